@@ -30,7 +30,7 @@ AnnotationCommand::AnnotationCommand(const string &path,
                 const string &enddate, 
                 const string &termid,
                 const string &outpath):
-    PhenotoolsCommand(hp_json),
+    PhenotoolsCommand(hp_json, LoadProfile::GRAPH_LABELS),
     phenotype_hpoa_path(path),
     termid_(termid),
     date_(date),
@@ -38,21 +38,18 @@ AnnotationCommand::AnnotationCommand(const string &path,
     outpath_(outpath)
 {
     if (! date.empty()) {
-        this->start_date_ = make_unique<struct tm>(string_to_time(date));
+        time_window_.start = string_to_date(date);
     } else {
         // If the user does not supply a begin date, we will choose a date that is
         // very likely to be before any current bio-ontology
-        this->start_date_ = make_unique<struct tm>(string_to_time("1000-01-01"));
+        time_window_.start = CivilDate(1000, 1, 1);
     }
     if (enddate.empty()) {
-        // this means the user did not pass an end date. We set the end date to 42 days after today to include everything
+        // this means the user did not pass an end date; include everything
         // up to and including the present time
-        // current date/time based on current system
-        time_t now = time(0);
-        tm *gmtm = gmtime(&now);
-        this->end_date_ = make_unique<struct tm>(*gmtm);
+        time_window_.end = CivilDate::today();
     } else {
-        this->end_date_ = make_unique<struct tm>(string_to_time(enddate));
+        time_window_.end = string_to_date(enddate);
     }
     if (termid.empty()) {
         do_by_toplevel_category_ = true;
@@ -87,7 +84,7 @@ AnnotationCommand::output_descendants(std::ostream & ost)
     TermId tid = TermId::from_string(termid_);
     cout <<"[INFO] HPO ontology with " << ontology_->current_term_count() << " terms\n" ;
     cout <<"[INFO] We will output descendants from term " << tid << "\n";
-    std::optional<Term> termopt = ontology_->get_term(tid);
+    TermView termopt = ontology_->term(tid);
     string term_label = "n/a";
     if (termopt) {
        term_label = termopt->get_label();
@@ -96,24 +93,25 @@ AnnotationCommand::output_descendants(std::ostream & ost)
         return;
     }
     ost << "#" << tid << " (" << term_label << ")\n";
-    for (HpoAnnotation ann : annotations_) {
+    // exists_path is called for each annotation
+    ontology_->build_reachability_index();
+    for (const HpoAnnotation &ann : annotations_) {
         if (! ann.is_omim()) {
             continue;
         }
-        TermId hpoid = ann.get_hpo_id();
+        const TermId &hpoid = ann.hpo_id();
         if (! ontology_->exists_path(hpoid, tid)) {
             continue;
             // the term is not a descendant
         }
         total++;
-        tm anndate = ann.get_curation_date();
-        if (in_time_window(ann.get_curation_date())) {
+        if (time_window_.contains(ann.get_curation_date())) {
             total_newer++;
-            ost << ann.get_disease_id() 
+            ost << ann.disease_id() 
                 << "\t" 
-                << ann.get_disease_name() 
+                << ann.disease_name() 
                 << "\t"
-                << ann.get_hpo_id()
+                << ann.hpo_id()
                 << "\t"
                 << ann.get_negated()
                 << "\t"
@@ -149,12 +147,12 @@ AnnotationCommand::output_descendants(std::ostream & ost)
             << ")] Could not open \"" << outpath_ << "\" for writing\n";
         return;
     }
-    for (HpoAnnotation ann : annotations_) {
+    for (const HpoAnnotation &ann : annotations_) {
         if (! ann.is_omim()) {
             continue;
         }
-        TermId hpoid = ann.get_hpo_id();
-        std::optional<Term> term = ontology_->get_term(hpoid);
+        const TermId &hpoid = ann.hpo_id();
+        TermView term = ontology_->term(hpoid);
         if (! term) {
             cerr << "[ERROR] Could not retrieve term for id: " << hpoid << "\n";
             continue;
@@ -162,7 +160,7 @@ AnnotationCommand::output_descendants(std::ostream & ost)
         }
         string label = term->get_label();
         total++;
-        if (! in_time_window(ann.get_curation_date())) {
+        if (! time_window_.contains(ann.get_curation_date())) {
             continue;
         }
         total_in_window++;
@@ -213,38 +211,6 @@ AnnotationCommand::execute()
 }
 
 
-/**
- * This function checks whether a date is within the two trheshold dates
- * A typical use case is to ask whether a term was created between 2015 and 2018.
- */
- bool 
- AnnotationCommand::in_time_window(tm time) const
- {
-    if (time.tm_year == start_date_->tm_year) {
-        if (time.tm_mon < start_date_->tm_mon) {
-            return false;
-        } else if (time.tm_mon == start_date_->tm_mon && time.tm_mday < start_date_->tm_mday) {
-            return false;
-        }
-        // if we get here, the years are the same and the month day are not earlier.
-        // so far, ,so good
-    } else if (time.tm_year < start_date_->tm_year) {
-        return false;
-    }
-    // if we get here, that time is equal to or later than start_date_
-    if (time.tm_year == end_date_->tm_year) {
-        if (time.tm_mon > end_date_->tm_mon) {
-            return false;
-        } else if (time.tm_mon == end_date_->tm_mon && time.tm_mday > end_date_->tm_mday) {
-            return false;
-        }
-    } else if (time.tm_year > end_date_->tm_year) {
-        return false;
-    }
-    return true;
- }
-
-
 int 
 AnnotationCommand::output_annotation_stats_per_database(std::ostream & ost, const map<string, int> &annotmap, const string &dbasename) const
 {
@@ -282,11 +248,11 @@ AnnotationCommand::output_annotation_stats(std::ostream & ost) const {
     set<string> omim_diseases;
     set<string> orpha_diseases;
 
-    for (HpoAnnotation annot : annotations_) {
+    for (const HpoAnnotation &annot : annotations_) {
         string dbase = annot.get_database();
-        string disease_id = annot.get_disease_id().get_value();
+        string disease_id = annot.disease_id().get_value();
         auto etype =  annot.get_evidence_type_string();
-        string termidstring = annot.get_hpo_id().get_value();
+        string termidstring = annot.hpo_id().get_value();
         if (dbase == "OMIM") {
             omim[etype]++;
             omim_terms[termidstring]++;
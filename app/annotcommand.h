@@ -35,10 +35,9 @@ namespace phenotools {
             string enddate_;
             string outpath_;
             bool do_by_toplevel_category_ = false;
-            std::unique_ptr<struct tm> start_date_;
-            std::unique_ptr<struct tm> end_date_;
+            /** Only annotations curated in this window are counted. */
+            DateWindow time_window_;
             vector<HpoAnnotation> annotations_;
-            bool in_time_window(tm time) const;
             void process_by_top_level_categories() const;
             void output_descendants(std::ostream & ost);
             void output_annotation_stats(std::ostream & ost) const;
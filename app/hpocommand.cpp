@@ -6,6 +6,7 @@
 
 #include "hpocommand.h"
 #include "../lib/jsonobo.h"
+#include "../lib/snapshot.h"
 #include "../lib/property.h"
 
 #define EMPTY_STRING ""
@@ -18,20 +19,6 @@ using std::stringstream;
 using std::make_unique;
 
 
-string stringify_date(tm *t) {
-    stringstream ss;
-    ss  << t->tm_year + 1900
-        << "-"
-        <<  std::right << std::setfill('0') << std::setw(2)
-        << t->tm_mon + 1
-        << "-"
-        <<  std::right << std::setfill('0') << std::setw(2)
-        << t->tm_mday;
-    return ss.str();
-}
-
-
-
 HpoCommand::HpoCommand(const string &hp_json_path, 
                 bool descriptive_stats, 
                 bool quality_control,
@@ -50,29 +37,26 @@ HpoCommand::HpoCommand(const string &hp_json_path,
                         const string &termid,
                         bool debug,
                         const string &outpath):
-    PhenotoolsCommand(hp_json_path),
     show_descriptive_stats(descriptive_stats),
     show_quality_control(quality_control),
     threshold_date_str(date),
     end_date_str(end_date),
     debug_(debug),
-    outpath_(outpath)
+    outpath_(outpath),
+    hp_json_path_(hp_json_path)
 {
     if (date.empty()) {
         // the following is the birthday of the HPO
-        this->start_date_ = make_unique<struct tm>(string_to_time("2008-11-01"));
+        time_window_.start = CivilDate(2008, 11, 1);
     } else {
-        this->start_date_ = make_unique<struct tm>(string_to_time(date));
+        time_window_.start = string_to_date(date);
     }
     if (end_date.empty()) {
-        // this means the user did not pass an end date. We set the end date to 42 days after today to include everything
+        // this means the user did not pass an end date; include everything
         // up to and including the present time
-        // current date/time based on current system
-        time_t now = time(0);
-        tm *gmtm = gmtime(&now);
-        this->end_date_ = make_unique<struct tm>(*gmtm);
+        time_window_.end = CivilDate::today();
     } else {
-        this->end_date_ = make_unique<struct tm>(string_to_time(end_date));
+        time_window_.end = string_to_date(end_date);
     }
     if (! termid.empty()) {
         this->tid_ = make_unique<TermId>(TermId::from_string(termid));
@@ -84,9 +68,7 @@ HpoCommand::HpoCommand(const string &hp_json_path, const string &hpo_term_file,
     outpath_(outpath),
     do_term_annotation_(true)
     {
-         JsonOboParser parser{hp_json_path};
-         error_list_ = parser.get_errors();
-         this->ontology_ = parser.get_ontology();
+         load_ontology(hp_json_path, LoadProfile::GRAPH_LABELS);
          if (! error_list_.empty()) {
              for (string s : error_list_) {
                  cerr << "[ERROR] " << s << "\n";
@@ -116,26 +98,20 @@ HpoCommand::annotate_termfile() const
             // root term, skip
             continue;
         }
-        std::optional<Term> term = ontology_->get_term(tid);
+        TermView term = ontology_->term(tid);
         if (! term) {
             cerr << "[WARNING] Could not retrieve term for " << tid << "\n";
+            continue;
         } else if (term->obsolete()){
             continue;
         }
         if (term->is_alternative_id(tid)) {
             continue;
         }
-        std::set<TermId> ancestors = ontology_->get_ancestors(tid);
-        bool found = false;
-        for (TermId t : ancestors) {
-            auto p = std::find (toplevelCatories_.begin(), toplevelCatories_.end(), t);
-            if (p != toplevelCatories_.end()) {
-                outfile << tid << "\t" << *p << "\n";
-                found = true;
-                break;
-            }
-        }
-        if (! found) {
+        std::optional<TermId> category = get_toplevel(tid);
+        if (category) {
+            outfile << tid << "\t" << *category << "\n";
+        } else {
             cout << "[WARN] Not placed in category: "    
                 <<  term->get_label() 
                 <<": "
@@ -147,7 +123,7 @@ HpoCommand::annotate_termfile() const
 
 void
 HpoCommand::output_terms_by_category() const {
-    vector<TermId> termids = ontology_->get_current_term_ids();
+    const vector<TermId> &termids = ontology_->current_term_ids();
     std::ofstream outfile;
     unsigned int valid_term_count = 0;
     outfile.open(outpath_);
@@ -156,24 +132,18 @@ HpoCommand::output_terms_by_category() const {
         return;
     }
     for (TermId tid : termids) {
-        std::optional<Term> term = ontology_->get_term(tid);
+        TermView term = ontology_->term(tid);
         if (! term) {
             cerr << "[WARNING] Could not retrieve term for " << tid << "\n";
+            continue;
         } else if (term->obsolete()){
             continue;
         }
         valid_term_count++;
-        std::set<TermId> ancestors = ontology_->get_ancestors(tid);
-        bool found = false;
-        for (TermId t : ancestors) {
-            auto p = std::find (toplevelCatories_.begin(), toplevelCatories_.end(), t);
-            if (p != toplevelCatories_.end()) {
-                outfile << tid << "\t" << *p << "\n";
-                found = true;
-                break;
-            }
-        }
-        if (! found) {
+        std::optional<TermId> category = get_toplevel(tid);
+        if (category) {
+            outfile << tid << "\t" << *category << "\n";
+        } else {
             cout << "[WARN] Not placed in category: "    
                 <<  term->get_label() 
                 <<": "
@@ -187,9 +157,35 @@ HpoCommand::output_terms_by_category() const {
 
 
 
+/**
+ * The ontology is loaded once we know what will be done with it (set_compile is
+ * called after construction).
+ */
+LoadProfile
+HpoCommand::required_profile() const
+{
+    if (compile_ || show_quality_control || show_descriptive_stats || debug_) {
+        return LoadProfile::FULL;
+    }
+    if (tid_) {
+        return LoadProfile::GRAPH_LABELS_DATES;
+    }
+    return LoadProfile::GRAPH_ONLY;
+}
+
 int
 HpoCommand::execute()
 {
+    if (! ontology_) {
+        cout <<"hp json path " << hp_json_path_ << "\n";
+        load_ontology(hp_json_path_, required_profile());
+        for (auto error : error_list_) {
+            cout << "[ERROR] " << error << "\n";
+        }
+    }
+    if (compile_) {
+        return compile();
+    }
     if (do_term_annotation_) {
         init_toplevel_categories();
         if (hpo_termfile_.empty()) {
@@ -228,6 +224,26 @@ HpoCommand::execute()
 }
 
 
+/**
+ * Write a binary snapshot of the ontology that subsequent runs can pass to --hp
+ * instead of hp.json. If no output path was given, the name is derived from the
+ * ontology version, e.g., hp-2019-09-06.phsnap.
+ */
+int
+HpoCommand::compile() const
+{
+    string path = outpath_.empty() ? OntologySnapshot::default_file_name(*ontology_) : outpath_;
+    try {
+        OntologySnapshot::write(*ontology_, path);
+    } catch (const PhenopacketException &e) {
+        cerr << "[ERROR] " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    cout << "[INFO] Wrote snapshot of " << ontology_->get_id() << " (version: "
+         << ontology_->get_version() << ") to " << path << "\n";
+    return EXIT_SUCCESS;
+}
+
 void
 HpoCommand::show_qc()
 {
@@ -245,6 +261,9 @@ HpoCommand::show_qc()
 void
 HpoCommand::show_stats()
 {
+    // the build time and size of the closure and the index are part of the statistics
+    ontology_->build_ancestor_closure();
+    ontology_->build_reachability_index();
     ontology_->output_descriptive_statistics();
 }
 
@@ -252,8 +271,10 @@ HpoCommand::show_stats()
 void 
 HpoCommand::output_descendants(std::ostream & ost)
 {
+    // get_descendant_term_ids calls exists_path for each term
+    this->ontology_->build_reachability_index();
     vector<TermId> descs = this->ontology_->get_descendant_term_ids(*tid_);
-    std::optional<Term> term = this->ontology_->get_term(*tid_);
+    TermView term = this->ontology_->term(*tid_);
     if (! term) {
         cerr << "[ERROR] Could not find term for " << *tid_ << "\n";
         return;
@@ -272,25 +293,19 @@ HpoCommand::output_descendants(std::ostream & ost)
    
     for (TermId tid : descs) {
         total++;
-        std::optional<Term> termopt = this->ontology_->get_term(tid);
+        TermView termopt = this->ontology_->term(tid);
         if (! termopt) {
             cerr << "[ERROR] Could not find term for " << tid << "\n";
             continue;
         } 
         label = termopt->get_label();
-        tm creation_date = termopt->get_creation_date();
-        stringstream ss;
-        ss << creation_date.tm_year + 1900
-            << "-"
-            << creation_date.tm_mon + 1
-            << "-"
-            << creation_date.tm_mday;
-        bool passes_threshold = in_time_window(creation_date);
+        CivilDate creation_date = termopt->get_creation_date();
+        bool passes_threshold = time_window_.contains(creation_date);
         ost << tid
             << "\t"
             << label
             << "\t"
-            << ss.str()
+            << creation_date
             << "\t"
             << (passes_threshold ? "T" : "F")
             << "\n";
@@ -307,22 +322,23 @@ HpoCommand::count_descendants()
 {
     int total = 0;
     int total_newer = 0;
+    this->ontology_->build_reachability_index();
     vector<TermId> descs = this->ontology_->get_descendant_term_ids(*tid_);
-    if (start_date_) {
+    if (! time_window_.start.empty()) {
         for (TermId tid : descs) {
             total++;
-            std::optional<Term> termopt = this->ontology_->get_term(tid);
+            TermView termopt = this->ontology_->term(tid);
             if (! termopt) {
                 cerr << "[ERROR] Could not find term for " << tid << "\n";
                 return;
             } else {
                 cout << tid << ": " << termopt->get_label() << "\n";
             }
-            tm creation_date = termopt->get_creation_date();
-            if (in_time_window(creation_date)) {
-                cout << tid << " was created before: " << (1900 + creation_date.tm_year) << "\n";
+            CivilDate creation_date = termopt->get_creation_date();
+            if (time_window_.contains(creation_date)) {
+                cout << tid << " was created before: " << creation_date.year() << "\n";
             } else {
-                cout << tid << " was created after: " << (1900 + creation_date.tm_year) << "\n";
+                cout << tid << " was created after: " << creation_date.year() << "\n";
                 total_newer++;
             }
         }
@@ -335,38 +351,6 @@ HpoCommand::count_descendants()
 
 
 
-/**
- * This function checks whether a date is within the two trheshold dates
- * A typical use case is to ask whether a term was created between 2015 and 2018.
- */
- bool 
- HpoCommand::in_time_window(tm time) const
- {
-    if (time.tm_year == start_date_->tm_year) {
-        if (time.tm_mon < start_date_->tm_mon) {
-            return false;
-        } else if (time.tm_mon == start_date_->tm_mon && time.tm_mday < start_date_->tm_mday) {
-            return false;
-        }
-        // if we get here, the years are the same and the month day are not earlier.
-        // so far, ,so good
-    } else if (time.tm_year < start_date_->tm_year) {
-        return false;
-    }
-    // if we get here, that time is equal to or later than start_date_
-    if (time.tm_year == end_date_->tm_year) {
-        if (time.tm_mon > end_date_->tm_mon) {
-            return false;
-        } else if (time.tm_mon == end_date_->tm_mon && time.tm_mday > end_date_->tm_mday) {
-            return false;
-        }
-    } else if (time.tm_year > end_date_->tm_year) {
-        return false;
-    }
-    return true;
- }
-
-
  void
  HpoCommand::print_category(const string &path, const string &outpath) const
  {
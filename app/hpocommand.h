@@ -4,7 +4,6 @@
 #include <string>
 #include <memory>
 #include <vector>
-#include <ctime>
 
 #include "../lib/phenotools.h"
 #include "phenotoolscommand.h"
@@ -39,14 +38,16 @@ class HpoCommand : public PhenotoolsCommand {
                 bool debug);
       HpoCommand(const string &hp_json_path, const string &hpo_term_file, const string &outpath);
       virtual int execute();
+      /** If true, execute() writes a binary snapshot of the ontology (hpo --compile). */
+      void set_compile(bool compile) { compile_ = compile; }
       /** path: file with one HPO term per line. outpath:name of file to print the ther together with its top level category. */
       void print_category(const string &path, const string &outpath) const;
 
     private:
       bool show_descriptive_stats;
       bool show_quality_control;
-      std::unique_ptr<struct tm> start_date_;
-      std::unique_ptr<struct tm> end_date_;
+      /** Only terms created in this window are counted. */
+      DateWindow time_window_;
       string threshold_date_str;
       string end_date_str;
       std::unique_ptr<TermId> tid_;
@@ -54,13 +55,17 @@ class HpoCommand : public PhenotoolsCommand {
       string hpo_termfile_;
       string outpath_;
       bool do_term_annotation_ = false;
-      
+      bool compile_ = false;
+      /** Loaded in execute() (the termfile constructor loads it right away). */
+      string hp_json_path_;
 
+      LoadProfile required_profile() const;
+
+      int compile() const;
       void show_qc();
       void show_stats();
       void count_descendants();
       void output_descendants(std::ostream & ost);
-      bool in_time_window(tm time) const;
       void annotate_termfile() const;
       void output_terms_by_category() const;
      
@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 #include <memory>
 
 #include "CLI11.hpp"
@@ -17,6 +18,7 @@
 #include "annotcommand.h"
 
 using std::string;
+using std::vector;
 using std::cout;
 using std::cerr;
 using std::make_unique;
@@ -30,6 +32,8 @@ int main (int argc, char ** argv) {
   /** Path to mondo file file, mondo.json. */
   string mondo_json_path;
   string phenopacket_path;
+  /** Further ontologies for the phenopacket command, as PREFIX=path (e.g., MONDO=mondo.json). */
+  vector<string> ontology_paths;
   /** Path/name for file with one HPO term per line that we will annotate with top level terms */
   string hpo_termfile;
   /** Path/name for any outputt file. */
@@ -44,12 +48,19 @@ int main (int argc, char ** argv) {
   bool show_quality_control = false;
   bool omim_analysis = false; 
   bool hpo_debug = false;
+  bool hpo_compile = false;
 
   CLI::App app ( "phenotools" );
   // phenopacket options
   CLI::App* phenopacket_command = app.add_subcommand ( "phenopacket", "work with GA4GH phenopackets" );
   CLI::Option* phenopacket_path_option = phenopacket_command->add_option ( "-p,--phenopacket",phenopacket_path,"path to input phenopacket" )->check ( CLI::ExistingFile );
   CLI::Option* phenopacket_hp_option = phenopacket_command->add_option ( "--hp",hp_json_path,"path to hp.json file" )->check ( CLI::ExistingFile );
+  // the path after PREFIX= must name an existing file, like the other input paths
+  const CLI::Validator existing_ontology_file ( [] ( std::string &op ) {
+      std::size_t i = op.find ( '=' );
+      return i == std::string::npos ? std::string ( "Expected PREFIX=path" ) : CLI::ExistingFile ( op.substr ( i + 1 ) );
+  }, "PREFIX=FILE" );
+  phenopacket_command->add_option ( "--ontology",ontology_paths,"further ontology as PREFIX=path (e.g., MONDO=mondo.json); may be repeated" )->check ( existing_ontology_file );
   // annotation options
   auto annot_command = app.add_subcommand("annotation", "work with phenotype.hpoa");
   auto annot_annot_option = annot_command->add_option("-a,--annot",phenotype_hpoa_path,"path to phenotype.hpoa file")->check ( CLI::ExistingFile )->required();
@@ -70,6 +81,7 @@ int main (int argc, char ** argv) {
   CLI::Option* term_option = hpo_command->add_option("-t,--term", termid, "TermId (target)");
   auto hpo_debug_option = hpo_command->add_flag("--debug", hpo_debug, "print details of HPO parse" );
   auto hpo_outpath_option = hpo_command->add_option("-o,--out", outpath, "name/path for output file" );
+  hpo_command->add_flag("--compile", hpo_compile, "write binary snapshot of the ontology (load it later with --hp)");
   
 
   CLI::App* toplevel_command = app.add_subcommand("toplevel", "annotate top level terms from an input file");
@@ -87,8 +99,9 @@ int main (int argc, char ** argv) {
       cerr << "[ERROR] --hp <path to hp.json> option required for hpo command.\n";
       exit(EXIT_FAILURE);
     }
+    std::unique_ptr<HpoCommand> hpocommand;
     if (* hpo_outpath_option) {
-      ptcommand = make_unique<HpoCommand>(hp_json_path, 
+      hpocommand = make_unique<HpoCommand>(hp_json_path, 
           show_descriptive_stats, 
           show_quality_control,
           iso_date,
@@ -97,7 +110,7 @@ int main (int argc, char ** argv) {
           hpo_debug, 
           outpath);
     } else {
-      ptcommand = make_unique<HpoCommand>(hp_json_path, 
+      hpocommand = make_unique<HpoCommand>(hp_json_path, 
           show_descriptive_stats, 
           show_quality_control,
           iso_date,
@@ -105,6 +118,8 @@ int main (int argc, char ** argv) {
           termid,
           hpo_debug);
     }
+    hpocommand->set_compile(hpo_compile);
+    ptcommand = std::move(hpocommand);
   } else if (toplevel_command->parsed()) {
       ptcommand = make_unique<HpoCommand>(hp_json_path, hpo_termfile, outpath);
   }  else if ( annot_command->parsed() ) { 
@@ -121,7 +136,7 @@ int main (int argc, char ** argv) {
       cerr << "[FATAL] -p/--phenopacket option required!\n";
       return EXIT_FAILURE;
     }
-   ptcommand = make_unique<PhenopacketCommand>(phenopacket_path, hp_json_path);
+   ptcommand = make_unique<PhenopacketCommand>(phenopacket_path, hp_json_path, ontology_paths);
   } else {
     std::cerr << "[ERROR] No command passed. Run with -h option to see usage\n";
     return 1;
@@ -15,6 +15,8 @@
 #include "../lib/base.pb.h"
 #include "../lib/phenotools.h"
 #include "../lib/jsonobo.h"
+#include "../lib/ontologyregistry.h"
+#include "../lib/snapshot.h"
 
 using namespace phenotools;
 using std::cerr;
@@ -26,13 +28,11 @@ PhenotoolsCommand::PhenotoolsCommand()
     // no -op
 }
 
-PhenotoolsCommand::PhenotoolsCommand(const string & hp_json):
+PhenotoolsCommand::PhenotoolsCommand(const string & hp_json, LoadProfile profile):
     hp_json_path_(hp_json) 
 {
     cout <<"hp json path " << hp_json << "\n";
-    JsonOboParser parser{hp_json_path_};
-    error_list_ = parser.get_errors();
-    this->ontology_ = parser.get_ontology();
+    load_ontology(hp_json_path_, profile);
     if (! error_list_.empty()) {
         for (auto error : error_list_) {
             cout << "[ERROR] " << error << "\n";
@@ -40,18 +40,32 @@ PhenotoolsCommand::PhenotoolsCommand(const string & hp_json):
     }
 }
 
+/**
+ * See OntologyRegistry::load_file. Snapshots are only written from ontologies that were parsed,
+ * so there is no error list for them.
+ */
+void
+PhenotoolsCommand::load_ontology(const string &path, LoadProfile profile)
+{
+    error_list_.clear();
+    try {
+        this->ontology_ = OntologyRegistry::load_file(path, profile, error_list_);
+    } catch (const PhenopacketException &e) {
+        cerr << "[ERROR] Could not load ontology: " << e.what() << "\n";
+        exit(EXIT_FAILURE);
+    }
+}
 
-struct tm 
-PhenotoolsCommand::string_to_time(string iso8601date) const
+
+CivilDate
+PhenotoolsCommand::string_to_date(const string &iso8601date) const
 {
-    tm time;
-    int y,M,d,h,m;
-    float s;
-    sscanf(iso8601date.c_str(), "%d-%d-%dT%d:%d:%fZ", &y, &M, &d, &h, &m, &s);
-    time.tm_year = y - 1900; // Year since 1900
-    time.tm_mon = M - 1;     // 0-11
-    time.tm_mday = d;        // 1-31
-    return time;
+    CivilDate date = CivilDate::parse(iso8601date);
+    if (date.empty()) {
+        cerr << "[ERROR] Could not parse date \"" << iso8601date << "\" (expected YYYY-MM-DD)\n";
+        exit(EXIT_FAILURE);
+    }
+    return date;
 }
 
 
@@ -120,15 +134,20 @@ PhenotoolsCommand::init_toplevel_categories()
     toplevelCatories_.push_back(PAST_MEDICAL_HX);
     TermId BLOOD_GROUP = TermId::from_string("HP:0032223");
     toplevelCatories_.push_back(BLOOD_GROUP);
+    // get_toplevel is called for every term or annotation
+    ontology_->build_ancestor_closure();
 }
 
+/**
+ * The ancestors are visited in the order of their ids (the vertex indices are sorted by id), so
+ * if a term lies in several categories, the one with the smallest id is returned.
+ */
 std::optional<TermId> 
 PhenotoolsCommand::get_toplevel(const TermId &tid) const
 {
-    std::set<TermId> ancestors = ontology_->get_ancestors(tid);
-    bool found = false;
-    for (TermId t : ancestors) {
-        auto p = std::find (toplevelCatories_.begin(), toplevelCatories_.end(), t);
+    const vector<TermId> &termids = ontology_->current_term_ids();
+    for (int i : ontology_->get_ancestor_indices(tid)) {
+        auto p = std::find (toplevelCatories_.begin(), toplevelCatories_.end(), termids[i]);
         if (p != toplevelCatories_.end()) {
             return std::optional<TermId>(*p);
         }
@@ -146,6 +165,16 @@ PhenotoolsCommand::get_toplevel(const TermId &tid) const
 
  }
 
+ PhenopacketCommand::PhenopacketCommand(const string &phenopacket,
+                                        const string &hp_json,
+                                        const vector<string> &ontologies):
+    hp_json_path(hp_json),
+    phenopacket_path(phenopacket),
+    ontology_paths(ontologies)
+ {
+
+ }
+
 int
 PhenopacketCommand::execute() 
 {
@@ -166,21 +195,36 @@ PhenopacketCommand::execute()
     cout << "\n#### Phenopacket at: " << phenopacket_path << " ####\n\n";
     phenotools::Phenopacket ppacket(phenopacketpb);
     auto validation = ppacket.validate();
-    if (hp_json_path.empty()) {
+    if (hp_json_path.empty() && ontology_paths.empty()) {
         cout << "[INFO] path to hp.json not passed, skipping ontology-based validation.\n";
         return 0;
     }
-    JsonOboParser parser{hp_json_path};
-    vector<string> error_list = parser.get_errors();
-    if (! error_list.empty()) {
-        cerr << "[ERROR] Unable to parse ontology:\n:";
-        for (string e : error_list) {
-            cerr << "\t" << e << "\n";
+    OntologyRegistry registry;
+    if (! hp_json_path.empty()) {
+        registry.add("HP", hp_json_path);
+    }
+    for (const string &op : ontology_paths) {
+        // PREFIX=path, e.g., MONDO=mondo.json
+        std::size_t i = op.find('=');
+        if (i == string::npos || i == 0) {
+            cerr << "[ERROR] Expected --ontology PREFIX=path, but got: " << op << "\n";
+            return EXIT_FAILURE;
+        }
+        registry.add(op.substr(0, i), op.substr(i + 1));
+    }
+    // semantic validation only looks up labels and is_a paths
+    registry.load(LoadProfile::GRAPH_LABELS);
+    for (const string &prefix : registry.get_prefixes()) {
+        vector<string> errors = registry.get_errors(prefix);
+        if (! errors.empty() || ! registry.has_ontology(prefix)) {
+            cerr << "[ERROR] Unable to parse ontology for " << prefix << ":\n:";
+            for (string e : errors) {
+                cerr << "\t" << e << "\n";
+            }
+            exit(1);
         }
-        exit(1);
     }
-    std::unique_ptr<Ontology>  ontology = parser.get_ontology();
-    auto semvalidation = ppacket.semantically_validate(ontology);
+    auto semvalidation = ppacket.semantically_validate(registry);
     validation.insert(validation.end(),semvalidation.begin(), semvalidation.end());
     
     if ( validation.empty() ) {
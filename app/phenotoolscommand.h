@@ -2,7 +2,6 @@
 #define PHENOTOOLS_COMMAND_H
 
 
-#include <ctime>
 #include <string>
 #include <vector>
 #include <memory>
@@ -12,6 +11,8 @@ using std::string;
 using std::vector;
 #include "../lib/termid.h"
 #include "../lib/ontology.h"
+#include "../lib/jsonobo.h"
+#include "../lib/civildate.h"
 
 namespace phenotools {
 
@@ -22,15 +23,20 @@ namespace phenotools {
             virtual int execute() = 0;
             PhenotoolsCommand();
         protected:
-            PhenotoolsCommand(const string & hp_json);
+            /** Load the ontology with the parts of the terms that the command needs. */
+            PhenotoolsCommand(const string & hp_json, LoadProfile profile);
             std::unique_ptr<Ontology> ontology_;
-            // "2014-11-12T19:12:14.505Z"
-            struct tm string_to_time(string iso8601date) const;
+            /** Parse a date such as 2014-11-12 or "2014-11-12T19:12:14.505Z"; exits with an error message if it is not valid. */
+            CivilDate string_to_date(const string &iso8601date) const;
             vector<TermId> toplevelCatories_;
             /** A list of errors, if any, encountered while parsing the input file.*/
 	        vector<string> error_list_;
 
+            /** Load hp.json, hp.obo, or a snapshot written by hpo --compile, into ontology_. */
+            void load_ontology(const string &path, LoadProfile profile);
+            /** Set up the top-level categories of HPO and build the ancestor closure that get_toplevel uses. */
             void init_toplevel_categories();
+            /** @return the top-level category of tid, if any (requires init_toplevel_categories). */
             std::optional<TermId> get_toplevel(const TermId &tid) const;
     };
 
@@ -39,9 +45,12 @@ namespace phenotools {
         private:
         string hp_json_path;
         string phenopacket_path;
+        /** Further ontologies for semantic validation, as PREFIX=path (e.g., MONDO=mondo.json). */
+        vector<string> ontology_paths;
         
         public:
         PhenopacketCommand(const string &phenopacket, const string &hp_json);
+        PhenopacketCommand(const string &phenopacket, const string &hp_json, const vector<string> &ontologies);
           virtual int execute();
     };
 
@@ -0,0 +1,96 @@
+/**
+ * @file alloc_bench.cpp
+ * @brief Count the heap allocations made while the parsed terms and edges are turned
+ * into an Ontology, once through the copying constructor and once through
+ * OntologyBuilder::build, which moves them.
+ *
+ * The global operator new/delete of the benchmark executable are replaced by versions
+ * that count calls and bytes; the parse itself is not counted.
+ */
+#include "benchutil.h"
+#include "../lib/jsonobo.h"
+#include "../lib/ontologybuilder.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+namespace {
+std::atomic<size_t> allocation_calls{0};
+std::atomic<size_t> allocation_bytes{0};
+
+void *counted_alloc(size_t size)
+{
+  allocation_calls.fetch_add(1, std::memory_order_relaxed);
+  allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  void *p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+size_t allocation_count() { return allocation_calls.load(); }
+size_t allocated_bytes() { return allocation_bytes.load(); }
+}
+
+void *operator new(size_t size) { return counted_alloc(size); }
+void *operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+void operator delete[](void *p, size_t) noexcept { std::free(p); }
+
+static OntologyBuilder parse_to_builder(const string &path)
+{
+  // the parser writes INFO messages to cout
+  std::stringstream sink;
+  std::streambuf *old = std::cout.rdbuf(sink.rdbuf());
+  JsonOboOptions options;
+  options.mode = JsonParseMode::STREAMING;
+  JsonOboParser parser{path, options};
+  std::cout.rdbuf(old);
+  return parser.release_builder();
+}
+
+static void print_counts(const string &name, size_t calls, size_t bytes, size_t terms)
+{
+  std::cout << std::left << std::setw(40) << name
+            << std::right << std::setw(12) << calls
+            << std::setw(14) << bytes / 1024 << " kB"
+            << std::setw(12) << std::fixed << std::setprecision(1)
+            << (terms > 0 ? static_cast<double>(calls) / terms : 0.0) << "\n";
+}
+
+int run_alloc_bench(const string &path)
+{
+  std::cout << "[INFO] Ontology construction allocation benchmark: " << path << "\n";
+  std::cout << std::left << std::setw(40) << "case"
+            << std::right << std::setw(12) << "allocations"
+            << std::setw(17) << "bytes"
+            << std::setw(12) << "per term" << "\n";
+  {
+    OntologyBuilder builder = parse_to_builder(path);
+    vector<Edge> edges = builder.get_edges();
+    size_t terms = builder.get_terms().size();
+    size_t calls = allocation_count();
+    size_t bytes = allocated_bytes();
+    Ontology ontology{builder.get_id(), builder.get_terms(), edges,
+                      builder.get_predicate_values(), builder.get_properties()};
+    print_counts("Ontology(const vector<Term>&, ...)", allocation_count() - calls,
+                 allocated_bytes() - bytes, terms);
+  }
+  {
+    OntologyBuilder builder = parse_to_builder(path);
+    size_t terms = builder.get_terms().size();
+    size_t calls = allocation_count();
+    size_t bytes = allocated_bytes();
+    std::unique_ptr<Ontology> ontology = builder.build();
+    print_counts("OntologyBuilder::build()", allocation_count() - calls,
+                 allocated_bytes() - bytes, terms);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file benchutil.cpp
+ * @brief Helpers to measure wall time and peak memory of a benchmark case.
+ */
+#include "benchutil.h"
+#include "../lib/jsonobo.h"
+
+#include <chrono>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+BenchResult run_isolated(const string &name, std::function<void()> f)
+{
+  BenchResult result{name, 0.0, 0, false};
+  int fd[2];
+  if (pipe(fd) != 0)
+  {
+    std::cerr << "[ERROR] Could not create pipe for benchmark " << name << "\n";
+    return result;
+  }
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid < 0)
+  {
+    std::cerr << "[ERROR] Could not fork benchmark " << name << "\n";
+    return result;
+  }
+  if (pid == 0)
+  {
+    close(fd[0]);
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    ssize_t n = write(fd[1], &ms, sizeof(ms));
+    close(fd[1]);
+    _exit(n == sizeof(ms) ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  close(fd[1]);
+  double ms = 0.0;
+  bool got_time = read(fd[0], &ms, sizeof(ms)) == sizeof(ms);
+  close(fd[0]);
+  int status = 0;
+  struct rusage usage;
+  if (wait4(pid, &status, 0, &usage) == pid)
+  {
+    result.peak_rss_kb = usage.ru_maxrss;
+    result.ok = got_time && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  result.wall_ms = ms;
+  return result;
+}
+
+double time_in_process(std::function<void()> f, int repetitions)
+{
+  if (repetitions < 1)
+  {
+    repetitions = 1;
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repetitions; ++i)
+  {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() / repetitions;
+}
+
+void print_header(std::ostream &s)
+{
+  s << std::left << std::setw(40) << "case"
+    << std::right << std::setw(14) << "wall (ms)"
+    << std::setw(18) << "peak RSS (MB)" << "\n";
+}
+
+void print_result(const BenchResult &r, std::ostream &s)
+{
+  s << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(1)
+    << std::setw(14) << r.wall_ms
+    << std::setw(18) << (r.peak_rss_kb / 1024.0);
+  if (!r.ok)
+  {
+    s << "  [FAILED]";
+  }
+  s << "\n";
+}
+
+vector<string> read_string_values(const string &path, const string &key)
+{
+  std::ifstream in(path);
+  if (! in.good())
+  {
+    std::cerr << "[ERROR] Could not open " << path << "\n";
+    exit(EXIT_FAILURE);
+  }
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  const string text = buffer.str();
+  vector<string> values;
+  const string quoted = "\"" + key + "\"";
+  for (size_t pos = text.find(quoted); pos != string::npos; pos = text.find(quoted, pos))
+  {
+    pos += quoted.size();
+    size_t colon = text.find_first_not_of(" \t\r\n", pos);
+    if (colon == string::npos || text[colon] != ':')
+    {
+      continue;
+    }
+    size_t begin = text.find_first_not_of(" \t\r\n", colon + 1);
+    if (begin == string::npos || text[begin] != '"')
+    {
+      // not a string value, e.g., "meta" : {
+      continue;
+    }
+    size_t end = text.find('"', begin + 1);
+    values.push_back(text.substr(begin + 1, end - begin - 1));
+    pos = end;
+  }
+  return values;
+}
+
+std::unique_ptr<Ontology> load_ontology(const string &path)
+{
+  // the parser writes INFO messages to cout
+  std::stringstream sink;
+  std::streambuf *old = std::cout.rdbuf(sink.rdbuf());
+  JsonOboOptions options;
+  options.mode = JsonParseMode::STREAMING;
+  JsonOboParser parser{path, options};
+  std::unique_ptr<Ontology> ontology = parser.get_ontology();
+  std::cout.rdbuf(old);
+  return ontology;
+}
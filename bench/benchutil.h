@@ -0,0 +1,43 @@
+/**
+ * @file benchutil.h
+ * @brief Helpers to measure wall time and peak memory of a benchmark case.
+ *
+ * Each case is run in a forked child process so that the peak resident set size
+ * (ru_maxrss) reported for the case is not polluted by earlier cases.
+ */
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <string>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+class Ontology;
+
+struct BenchResult {
+  string name;
+  /** Wall time of the case in milliseconds (measured in the child). */
+  double wall_ms;
+  /** Peak resident set size of the child in kilobytes. */
+  long peak_rss_kb;
+  /** true if the child exited normally with status 0. */
+  bool ok;
+};
+
+/** Run f in a child process and report its wall time and peak RSS. */
+BenchResult run_isolated(const string &name, std::function<void()> f);
+/** Run f repeatedly in this process and return the mean wall time in milliseconds. */
+double time_in_process(std::function<void()> f, int repetitions);
+void print_header(std::ostream &s = std::cout);
+void print_result(const BenchResult &r, std::ostream &s = std::cout);
+/** @return the string values of all occurrences of key in the JSON file (e.g., "pred"), in file order. */
+vector<string> read_string_values(const string &path, const string &key);
+/** Parse the JSON file with the streaming parser; the INFO messages of the parser are discarded. */
+std::unique_ptr<Ontology> load_ontology(const string &path);
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file closure_bench.cpp
+ * @brief Cost and benefit of the ancestor closure (see ancestorclosure.h): the time to build it
+ * and its size, compared with the ancestor queries it replaces.
+ *
+ * The queries are those of the commands that place terms into top-level categories: the
+ * ancestors of every current term, and for every term the categories it belongs to. The
+ * categories are the children of the roots of the is_a graph (for HPO, the children of
+ * Phenotypic abnormality and its siblings are one level further down, so the count differs
+ * from the commands, but the work per query is the same). The graph cases run before the
+ * closure is built; Ontology then answers the same calls from the closure.
+ */
+#include "benchutil.h"
+#include "../lib/ontology.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <random>
+
+/** Time one pass of queries (best of several repetitions) and print queries per second. */
+static void report(const string &name, size_t n, std::function<size_t()> queries)
+{
+  double best_ms = 0;
+  size_t checksum = 0;
+  for (int rep = 0; rep < 5; ++rep)
+  {
+    size_t c = 0;
+    double ms = time_in_process([&]() { c = queries(); }, 1);
+    if (rep == 0 || ms < best_ms)
+    {
+      best_ms = ms;
+    }
+    checksum = c;
+  }
+  double per_second = best_ms > 0 ? n / best_ms * 1000.0 : 0.0;
+  std::cout << std::left << std::setw(44) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << best_ms
+            << std::setw(16) << std::setprecision(2) << per_second / 1e6
+            << std::setw(12) << checksum << "\n";
+}
+
+static void print_query_header()
+{
+  std::cout << std::left << std::setw(44) << "case"
+            << std::right << std::setw(12) << "wall (ms)"
+            << std::setw(16) << "M queries/s"
+            << std::setw(12) << "checksum" << "\n";
+}
+
+int run_closure_bench(const string &path)
+{
+  std::cout << "[INFO] Ancestor closure benchmark: " << path << "\n";
+  std::unique_ptr<Ontology> ontology = load_ontology(path);
+  vector<TermId> terms = ontology->current_term_ids();
+  std::mt19937 rng(42);
+  std::shuffle(terms.begin(), terms.end(), rng);
+  vector<TermId> roots;
+  for (const TermId &tid : terms)
+  {
+    if (ontology->get_isa_parents(tid).empty())
+    {
+      roots.push_back(tid);
+    }
+  }
+  vector<TermId> categories;
+  for (const TermId &tid : terms)
+  {
+    for (const TermId &parent : ontology->get_isa_parents(tid))
+    {
+      if (std::find(roots.begin(), roots.end(), parent) != roots.end())
+      {
+        categories.push_back(tid);
+        break;
+      }
+    }
+  }
+  std::cout << "[INFO] " << terms.size() << " terms, " << roots.size() << " roots, "
+            << categories.size() << " categories\n";
+  size_t pairs = terms.size() * categories.size();
+  auto all_ancestors = [&]() {
+    size_t c = 0;
+    for (const TermId &tid : terms)
+    {
+      c += ontology->get_ancestors(tid).size();
+    }
+    return c;
+  };
+  auto category_membership = [&]() {
+    size_t c = 0;
+    for (const TermId &tid : terms)
+    {
+      for (const TermId &category : categories)
+      {
+        c += ontology->is_ancestor(category, tid);
+      }
+    }
+    return c;
+  };
+  print_query_header();
+  report("get_ancestors (graph search)", terms.size(), all_ancestors);
+  report("is_ancestor (graph search)", pairs, category_membership);
+
+  ontology->build_ancestor_closure();
+  const AncestorClosure::Stats &stats = ontology->ancestor_closure().stats();
+  std::cout << "[INFO] closure: built in " << std::fixed << std::setprecision(2) << stats.build_ms << " ms, "
+            << stats.entries << " entries (mean " << std::setprecision(1)
+            << (stats.vertices ? double(stats.entries) / stats.vertices : 0.0)
+            << ", max " << stats.max_row_length << " per term), "
+            << stats.bytes / 1024 << " KiB; a bit matrix would need "
+            << stats.bit_matrix_bytes() / 1024 << " KiB\n";
+  report("get_ancestors (closure)", terms.size(), all_ancestors);
+  report("get_ancestor_indices (closure)", terms.size(), [&]() {
+    size_t c = 0;
+    for (const TermId &tid : terms)
+    {
+      c += ontology->get_ancestor_indices(tid).size();
+    }
+    return c;
+  });
+  report("is_ancestor (closure)", pairs, category_membership);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file lookup_bench.cpp
+ * @brief Throughput of TermId lookups: std::map and std::unordered_map compared with
+ * TermIdMap, the open-addressing table used by Ontology, and the Ontology queries
+ * that start with a lookup: get_term (which copies the term), term (which returns a
+ * TermView) and get_isa_parents.
+ *
+ * All ids of the ontology are looked up in random order (hits), and then the same
+ * number of ids that are not in the ontology (misses). The last cases scan the labels
+ * of all current terms, once via a lookup per id and once via filter_terms, which reads
+ * the columns of the TermStore in order, and the terms that have an xref with a given prefix.
+ * The date window cases count the terms created in 2015-2018: field by field on struct tm
+ * (as the commands used to), per TermView, and with a scan of the creation date column.
+ */
+#include "benchutil.h"
+#include "../lib/jsonobo.h"
+#include "../lib/termidmap.h"
+
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <unordered_map>
+
+/** The comparison of struct tm dates that HpoCommand and AnnotationCommand used to do. */
+static bool tm_in_window(const tm &time, const tm &start, const tm &end)
+{
+  if (time.tm_year == start.tm_year) {
+    if (time.tm_mon < start.tm_mon) {
+      return false;
+    } else if (time.tm_mon == start.tm_mon && time.tm_mday < start.tm_mday) {
+      return false;
+    }
+  } else if (time.tm_year < start.tm_year) {
+    return false;
+  }
+  if (time.tm_year == end.tm_year) {
+    if (time.tm_mon > end.tm_mon) {
+      return false;
+    } else if (time.tm_mon == end.tm_mon && time.tm_mday > end.tm_mday) {
+      return false;
+    }
+  } else if (time.tm_year > end.tm_year) {
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Time one pass of lookup over queries (best of several repetitions) and print lookups per second.
+ * If each query visits several terms, items_per_query is the number of terms.
+ */
+static void report(const string &name, const vector<TermId> &queries, std::function<size_t(const TermId &)> lookup,
+                   size_t items_per_query = 1)
+{
+  size_t found = 0;
+  double best_ms = 0;
+  for (int rep = 0; rep < 5; ++rep)
+  {
+    size_t n = 0;
+    double ms = time_in_process([&]() {
+      for (const TermId &tid : queries)
+      {
+        n += lookup(tid);
+      }
+    }, 1);
+    if (rep == 0 || ms < best_ms)
+    {
+      best_ms = ms;
+    }
+    found = n;
+  }
+  double per_second = best_ms > 0 ? queries.size() * items_per_query / best_ms * 1000.0 : 0.0;
+  std::cout << std::left << std::setw(44) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(1) << best_ms
+            << std::setw(16) << std::setprecision(2) << per_second / 1e6
+            << std::setw(10) << found << "\n";
+}
+
+int run_lookup_bench(const string &path)
+{
+  std::cout << "[INFO] TermId lookup benchmark: " << path << "\n";
+  std::unique_ptr<Ontology> ontology = load_ontology(path);
+  const vector<TermId> &ids = ontology->current_term_ids();
+  std::map<TermId, int> ordered;
+  std::unordered_map<TermId, int> unordered;
+  TermIdMap<int> open_addressing;
+  unordered.reserve(ids.size());
+  open_addressing.reserve(ids.size());
+  for (size_t i = 0; i < ids.size(); ++i)
+  {
+    ordered.emplace(ids[i], i);
+    unordered.emplace(ids[i], i);
+    open_addressing.insert(ids[i], i);
+  }
+  vector<TermId> hits = ids;
+  std::mt19937 rng(42);
+  std::shuffle(hits.begin(), hits.end(), rng);
+  // same local ids with a prefix that the ontology does not use
+  vector<TermId> misses;
+  misses.reserve(hits.size());
+  for (const TermId &tid : hits)
+  {
+    misses.push_back(TermId::from_string("NOTINONTOLOGY:" + tid.get_id()));
+  }
+  std::cout << "[INFO] " << ids.size() << " terms\n";
+  std::cout << std::left << std::setw(44) << "case"
+            << std::right << std::setw(12) << "wall (ms)"
+            << std::setw(16) << "M lookups/s"
+            << std::setw(10) << "found" << "\n";
+  struct Queries { const char *name; const vector<TermId> &ids; };
+  for (const Queries &q : {Queries{"hit", hits}, Queries{"miss", misses}})
+  {
+    string suffix = string(" (") + q.name + ")";
+    report("std::map<TermId,int>" + suffix, q.ids,
+           [&ordered](const TermId &tid) { return ordered.find(tid) != ordered.end(); });
+    report("std::unordered_map<TermId,int>" + suffix, q.ids,
+           [&unordered](const TermId &tid) { return unordered.find(tid) != unordered.end(); });
+    report("TermIdMap<int>" + suffix, q.ids,
+           [&open_addressing](const TermId &tid) { return open_addressing.find(tid) != nullptr; });
+  }
+  report("Ontology::get_term (hit)", hits,
+         [&ontology](const TermId &tid) { return ontology->get_term(tid).has_value(); });
+  report("Ontology::term (hit)", hits,
+         [&ontology](const TermId &tid) { return ontology->term(tid).has_value(); });
+  report("Ontology::get_isa_parents (hit)", hits,
+         [&ontology](const TermId &tid) { return ontology->get_isa_parents(tid).size(); });
+  report("label scan via Ontology::term", hits,
+         [&ontology](const TermId &tid) { return ontology->term(tid)->label().size() > 0; });
+  // a single query scans all current terms
+  const vector<TermId> one_scan{ids.front()};
+  report("label scan via Ontology::filter_terms", one_scan,
+         [&ontology](const TermId &) {
+           return ontology->filter_terms([](const TermView &t) { return t.label().size() > 0 && ! t.obsolete(); });
+         }, ids.size());
+  report("xref prefix scan (UMLS) via filter_terms", one_scan,
+         [&ontology](const TermId &) {
+           return ontology->filter_terms([](const TermView &t) { return t.contains_xref_with_prefix("UMLS"); });
+         }, ids.size());
+  const DateWindow window{CivilDate(2015, 1, 1), CivilDate(2018, 12, 31)};
+  vector<tm> tm_dates;
+  tm_dates.reserve(ids.size());
+  for (int i = 0; i < ontology->current_term_count(); ++i)
+  {
+    CivilDate d = ontology->term_at(i).get_creation_date();
+    tm t = {};
+    t.tm_year = d.year() - 1900;
+    t.tm_mon = d.month() - 1;
+    t.tm_mday = d.day();
+    tm_dates.push_back(t);
+  }
+  tm tm_start = {};
+  tm_start.tm_year = 2015 - 1900;
+  tm tm_end = {};
+  tm_end.tm_year = 2018 - 1900;
+  tm_end.tm_mon = 11;
+  tm_end.tm_mday = 31;
+  report("date window, struct tm fields", one_scan,
+         [&](const TermId &) {
+           return std::count_if(tm_dates.begin(), tm_dates.end(),
+                                [&](const tm &t) { return tm_in_window(t, tm_start, tm_end); });
+         }, ids.size());
+  report("date window via filter_terms", one_scan,
+         [&](const TermId &) {
+           return ontology->filter_terms([&window](const TermView &t) { return window.contains(t.get_creation_date()); });
+         }, ids.size());
+  report("date window, Ontology::count_terms_created_in", one_scan,
+         [&](const TermId &) { return ontology->count_terms_created_in(window); }, ids.size());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file main.cpp
+ * @brief Driver for the phenotools benchmarks.
+ *
+ * Usage: phenotools_bench <benchmark> [path to ontology file]
+ * The benchmarks are intended to be run on the full hp.json file
+ * (http://purl.obolibrary.org/obo/hp.json); the small test file is used by default.
+ */
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+using std::string;
+
+int run_parse_bench(const string &path);
+int run_alloc_bench(const string &path);
+int run_obo_bench(const string &json_path, const string &obo_path);
+int run_lookup_bench(const string &path);
+int run_registry_bench(const string &path);
+int run_termid_bench(const string &path);
+int run_closure_bench(const string &path);
+int run_reach_bench(const string &path);
+
+static void usage()
+{
+  std::cerr << "Usage: phenotools_bench <benchmark> [hp.json] [hp.obo]\n"
+            << "  benchmarks:\n"
+            << "    parse\tpeak memory and wall time of DOM vs. streaming, ifstream vs. mmap JSON parse\n"
+            << "    alloc\theap allocations of building the Ontology by copy vs. OntologyBuilder\n"
+            << "    obo\tpeak memory and wall time of OboParser vs. the JSON parser on the same release\n"
+            << "    lookup\tTermId lookups per second of std::map, std::unordered_map and TermIdMap\n"
+            << "    registry\tpredicate lookups per second of std::map vs. the compile-time registries\n"
+            << "    termid\tTermIds converted per second by from_string (throwing) vs. parse and parse_all\n"
+            << "    closure\tbuild time and size of the ancestor closure, and the ancestor queries it speeds up\n"
+            << "    reach\texists_path with graph search vs. reachability index, on the ontology and a deep DAG\n";
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+  string benchmark = argv[1];
+  string path = argc > 2 ? argv[2] : "../testdata/hp.small.json";
+  if (benchmark == "parse")
+  {
+    return run_parse_bench(path);
+  }
+  if (benchmark == "alloc")
+  {
+    return run_alloc_bench(path);
+  }
+  if (benchmark == "obo")
+  {
+    return run_obo_bench(path, argc > 3 ? argv[3] : "../testdata/hp.small.obo");
+  }
+  if (benchmark == "lookup")
+  {
+    return run_lookup_bench(path);
+  }
+  if (benchmark == "registry")
+  {
+    return run_registry_bench(path);
+  }
+  if (benchmark == "termid")
+  {
+    return run_termid_bench(path);
+  }
+  if (benchmark == "closure")
+  {
+    return run_closure_bench(path);
+  }
+  if (benchmark == "reach")
+  {
+    return run_reach_bench(path);
+  }
+  usage();
+  return EXIT_FAILURE;
+}
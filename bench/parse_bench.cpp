@@ -0,0 +1,123 @@
+/**
+ * @file parse_bench.cpp
+ * @brief Compare the DOM and the streaming (SAX) modes of JsonOboParser,
+ * each reading the file through an ifstream or an in-situ parsed mmap, and the
+ * multi-threaded conversion of DOM nodes to terms. The lazy case only decodes
+ * what is needed for the graph (see JsonOboOptions::lazy_terms), and the
+ * profile cases only build the parts of the terms that a command needs.
+ * The obo benchmark compares the JSON parser with OboParser on the same release.
+ */
+#include "benchutil.h"
+#include "../lib/jsonobo.h"
+#include "../lib/oboparser.h"
+
+#include <sstream>
+#include <thread>
+#include <algorithm>
+
+static void parse_and_build(const string &path, JsonParseMode mode, bool memory_map, unsigned int threads = 1,
+                            bool lazy_terms = false, LoadProfile profile = LoadProfile::FULL)
+{
+  JsonOboOptions options;
+  options.mode = mode;
+  options.memory_map = memory_map;
+  options.threads = threads;
+  options.lazy_terms = lazy_terms;
+  options.profile = profile;
+  // the parser writes INFO messages to cout; keep the table readable
+  std::stringstream sink;
+  std::streambuf *old = std::cout.rdbuf(sink.rdbuf());
+  {
+    JsonOboParser parser{path, options};
+    std::unique_ptr<Ontology> ontology = parser.get_ontology();
+    std::cout.rdbuf(old);
+    if (ontology->current_term_count() == 0)
+    {
+      std::cerr << "[ERROR] No terms parsed from " << path << "\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+int run_parse_bench(const string &path)
+{
+  std::cout << "[INFO] JSON parse benchmark: " << path << "\n";
+  print_header();
+  struct Case { const char *name; JsonParseMode mode; bool memory_map; bool lazy_terms; LoadProfile profile; };
+  const LoadProfile FULL = LoadProfile::FULL;
+  const Case cases[] = {
+      {"JsonOboParser (DOM, ifstream)", JsonParseMode::DOM, false, false, FULL},
+      {"JsonOboParser (DOM, mmap in situ)", JsonParseMode::DOM, true, false, FULL},
+      {"JsonOboParser (STREAMING, ifstream)", JsonParseMode::STREAMING, false, false, FULL},
+      {"JsonOboParser (STREAMING, mmap in situ)", JsonParseMode::STREAMING, true, false, FULL},
+      {"JsonOboParser (STREAMING, mmap, lazy)", JsonParseMode::STREAMING, true, true, FULL},
+      {"JsonOboParser (STREAMING, graph+labels)", JsonParseMode::STREAMING, true, false, LoadProfile::GRAPH_LABELS},
+      {"JsonOboParser (STREAMING, graph only)", JsonParseMode::STREAMING, true, false, LoadProfile::GRAPH_ONLY}};
+  bool ok = true;
+  for (const Case &c : cases)
+  {
+    BenchResult r = run_isolated(c.name, [&path, &c]() {
+      parse_and_build(path, c.mode, c.memory_map, 1, c.lazy_terms, c.profile);
+    });
+    print_result(r);
+    ok = ok && r.ok;
+  }
+  unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned int threads = 2; threads <= cores; threads *= 2)
+  {
+    string name = "JsonOboParser (DOM, mmap, " + std::to_string(threads) + " threads)";
+    BenchResult r = run_isolated(name, [&path, threads]() {
+      parse_and_build(path, JsonParseMode::DOM, true, threads);
+    });
+    print_result(r);
+    ok = ok && r.ok;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static void parse_obo_and_build(const string &path, LoadProfile profile)
+{
+  OboOptions options;
+  options.profile = profile;
+  std::stringstream sink;
+  std::streambuf *old = std::cout.rdbuf(sink.rdbuf());
+  {
+    OboParser parser{path, options};
+    std::unique_ptr<Ontology> ontology = parser.get_ontology();
+    std::cout.rdbuf(old);
+    if (ontology->current_term_count() == 0)
+    {
+      std::cerr << "[ERROR] No terms parsed from " << path << "\n";
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+int run_obo_bench(const string &json_path, const string &obo_path)
+{
+  std::cout << "[INFO] OBO vs. JSON parse benchmark: " << obo_path << ", " << json_path << "\n";
+  print_header();
+  struct Case { const char *name; bool obo; LoadProfile profile; };
+  const Case cases[] = {
+      {"JsonOboParser (STREAMING, mmap in situ)", false, LoadProfile::FULL},
+      {"OboParser (mmap)", true, LoadProfile::FULL},
+      {"JsonOboParser (STREAMING, graph+labels)", false, LoadProfile::GRAPH_LABELS},
+      {"OboParser (graph+labels)", true, LoadProfile::GRAPH_LABELS}};
+  bool ok = true;
+  for (const Case &c : cases)
+  {
+    BenchResult r = run_isolated(c.name, [&json_path, &obo_path, &c]() {
+      if (c.obo)
+      {
+        parse_obo_and_build(obo_path, c.profile);
+      }
+      else
+      {
+        parse_and_build(json_path, JsonParseMode::STREAMING, true, 1, false, c.profile);
+      }
+    });
+    print_result(r);
+    ok = ok && r.ok;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
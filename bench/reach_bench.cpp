@@ -0,0 +1,164 @@
+/**
+ * @file reach_bench.cpp
+ * @brief exists_path with the graph search, the reachability index (see reachabilityindex.h)
+ * and the ancestor closure, on the given ontology and on a synthetic deep DAG.
+ *
+ * The queries are those of get_descendant_term_ids and of the annotation command: is the
+ * term an ancestor of each of many terms. The ancestors are found by walking up from
+ * random terms, so that they lie at different depths, and are paired with random terms.
+ * The deep DAG has 100 levels of 200 terms; each term below the first level has a parent on
+ * the level above and, with probability 0.1, a second parent up to five levels higher. The graph search of
+ * exists_path has no visited set, so on this graph it reaches the shared ancestors once per
+ * path; with more levels or more second parents, it does not finish.
+ */
+#include "benchutil.h"
+#include "../lib/ontology.h"
+
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+/** Time one pass of queries (best of several repetitions) and print queries per second. */
+static void report(const string &name, size_t n, std::function<size_t()> queries, int repetitions = 5)
+{
+  double best_ms = 0;
+  size_t checksum = 0;
+  for (int rep = 0; rep < repetitions; ++rep)
+  {
+    size_t c = 0;
+    double ms = time_in_process([&]() { c = queries(); }, 1);
+    if (rep == 0 || ms < best_ms)
+    {
+      best_ms = ms;
+    }
+    checksum = c;
+  }
+  double per_second = best_ms > 0 ? n / best_ms * 1000.0 : 0.0;
+  std::cout << std::left << std::setw(44) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << best_ms
+            << std::setw(16) << std::setprecision(2) << per_second / 1e6
+            << std::setw(12) << checksum << "\n";
+}
+
+static std::unique_ptr<Ontology> deep_dag(int levels, int width, double second_parent)
+{
+  std::mt19937 rng(25);
+  std::uniform_real_distribution<double> coin(0.0, 1.0);
+  vector<Term> terms;
+  vector<Edge> edges;
+  auto tid = [width](int level, int i) {
+    std::stringstream ss;
+    ss << "HP:" << std::setw(7) << std::setfill('0') << level * width + i + 1;
+    return TermId::from_string(ss.str());
+  };
+  for (int level = 0; level < levels; ++level)
+  {
+    for (int i = 0; i < width; ++i)
+    {
+      TermId child = tid(level, i);
+      terms.emplace_back(child, "term " + child.get_id());
+      if (level == 0)
+      {
+        // the first term of level 0 is the root, the others are its children
+        if (i > 0)
+        {
+          edges.push_back(Edge::of(child, EdgeType::IS_A, tid(0, 0)));
+        }
+        continue;
+      }
+      edges.push_back(Edge::of(child, EdgeType::IS_A, tid(level - 1, rng() % width)));
+      if (coin(rng) < second_parent)
+      {
+        int up = 1 + rng() % std::min(level, 5);
+        edges.push_back(Edge::of(child, EdgeType::IS_A, tid(level - up, rng() % width)));
+      }
+    }
+  }
+  std::stringstream sink;
+  std::streambuf *old = std::cout.rdbuf(sink.rdbuf());
+  auto ontology = std::make_unique<Ontology>("hp", terms, edges, vector<PredicateValue>(), vector<Property>());
+  std::cout.rdbuf(old);
+  return ontology;
+}
+
+static void run_queries(const string &title, Ontology &ontology)
+{
+  const vector<TermId> &termids = ontology.current_term_ids();
+  std::mt19937 rng(42);
+  vector<TermId> ancestors;
+  while (ancestors.size() < 10)
+  {
+    TermId t = termids[rng() % termids.size()];
+    int steps = 1 + rng() % 8;
+    for (int s = 0; s < steps; ++s)
+    {
+      vector<TermId> parents = ontology.get_isa_parents(t);
+      if (parents.empty())
+      {
+        break;
+      }
+      t = parents[rng() % parents.size()];
+    }
+    ancestors.push_back(t);
+  }
+  vector<TermId> sources;
+  for (int i = 0; i < 2000; ++i)
+  {
+    sources.push_back(termids[rng() % termids.size()]);
+  }
+  size_t n = ancestors.size() * sources.size();
+  auto queries = [&]() {
+    size_t c = 0;
+    for (const TermId &a : ancestors)
+    {
+      for (const TermId &s : sources)
+      {
+        c += ontology.exists_path(s, a);
+      }
+    }
+    return c;
+  };
+  std::cout << "[INFO] " << title << ": " << termids.size() << " terms, " << ontology.is_a_edge_count()
+            << " is_a edges, " << n << " queries\n";
+  std::cout << std::left << std::setw(44) << "case"
+            << std::right << std::setw(12) << "wall (ms)"
+            << std::setw(16) << "M queries/s"
+            << std::setw(12) << "paths" << "\n";
+  report("exists_path (graph search)", n, queries, 1);
+
+  ontology.build_reachability_index();
+  const ReachabilityIndex &index = ontology.reachability_index();
+  size_t decided[3] = {0, 0, 0};
+  for (const TermId &a : ancestors)
+  {
+    for (const TermId &s : sources)
+    {
+      int si = ontology.term(s).index();
+      int ai = ontology.term(a).index();
+      if (si == ai)
+      {
+        continue;
+      }
+      ++decided[static_cast<int>(index.decide(si, ai))];
+    }
+  }
+  std::cout << "[INFO] index: built in " << std::fixed << std::setprecision(2) << index.stats().build_ms << " ms, "
+            << index.stats().bytes / 1024 << " KiB; labels answer yes " << decided[0] << ", no " << decided[1]
+            << ", search " << decided[2] << "\n";
+  report("exists_path (reachability index)", n, queries);
+
+  ontology.build_ancestor_closure();
+  std::cout << "[INFO] closure: built in " << ontology.ancestor_closure().stats().build_ms << " ms, "
+            << ontology.ancestor_closure().stats().bytes / 1024 << " KiB\n";
+  report("exists_path (ancestor closure)", n, queries);
+}
+
+int run_reach_bench(const string &path)
+{
+  std::cout << "[INFO] Reachability benchmark: " << path << "\n";
+  std::unique_ptr<Ontology> ontology = load_ontology(path);
+  run_queries(path, *ontology);
+  std::unique_ptr<Ontology> deep = deep_dag(100, 200, 0.1);
+  run_queries("deep DAG", *deep);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file registry_bench.cpp
+ * @brief Throughput of the lookups of the predicates of edges and property values:
+ * the std::map<string,...> with a substr of the IRI that the parsers used to do,
+ * compared with the compile-time registries (see staticregistry.h) and strip_iri.
+ *
+ * The queries are the "pred" values of the JSON file in the order in which they occur.
+ * The std::map only holds the keys that occur in the file, so it is, if anything,
+ * smaller than the table the parsers used.
+ */
+#include "benchutil.h"
+#include "../lib/edge.h"
+#include "../lib/property.h"
+#include "../lib/staticregistry.h"
+
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+/** Time one pass of lookup over queries (best of several repetitions) and print lookups per second. */
+static void report(const string &name, const vector<string> &queries, std::function<int(const string &)> lookup)
+{
+  double best_ms = 0;
+  long checksum = 0;
+  for (int rep = 0; rep < 5; ++rep)
+  {
+    long n = 0;
+    double ms = time_in_process([&]() {
+      for (const string &q : queries)
+      {
+        n += lookup(q);
+      }
+    }, 1);
+    if (rep == 0 || ms < best_ms)
+    {
+      best_ms = ms;
+    }
+    checksum = n;
+  }
+  double per_second = best_ms > 0 ? queries.size() / best_ms * 1000.0 : 0.0;
+  std::cout << std::left << std::setw(44) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << best_ms
+            << std::setw(16) << std::setprecision(2) << per_second / 1e6
+            << std::setw(12) << checksum << "\n";
+}
+
+/** The lookup of the parsers before the registries were built at compile time. */
+template <typename V>
+static V map_lookup(const std::map<string, V> &registry, const string &iri)
+{
+  string key = iri;
+  size_t pos = key.find_last_of("/");
+  if (pos != string::npos)
+  {
+    key = key.substr(pos + 1);
+  }
+  return registry.find(key)->second;
+}
+
+int run_registry_bench(const string &path)
+{
+  std::cout << "[INFO] Predicate registry benchmark: " << path << "\n";
+  vector<string> edge_predicates;
+  vector<string> value_predicates;
+  std::map<string, EdgeType> edgetype_map;
+  std::map<string, Predicate> predicate_map;
+  // unknown predicates are reported on cerr
+  std::stringstream sink;
+  std::streambuf *old = std::cerr.rdbuf(sink.rdbuf());
+  for (const string &pred : read_string_values(path, "pred"))
+  {
+    string key{strip_iri(pred)};
+    try
+    {
+      edgetype_map[key] = Edge::string_to_edgetype(key);
+      edge_predicates.push_back(pred);
+      continue;
+    }
+    catch (const PhenopacketException &) {}
+    Predicate p = PredicateValue::string_to_predicate(key);
+    if (p != Predicate::UNKNOWN)
+    {
+      predicate_map[key] = p;
+      value_predicates.push_back(pred);
+    }
+  }
+  std::cerr.rdbuf(old);
+  std::cout << "[INFO] " << edge_predicates.size() << " edge predicates, "
+            << value_predicates.size() << " property value predicates\n";
+  std::cout << std::left << std::setw(44) << "case"
+            << std::right << std::setw(12) << "wall (ms)"
+            << std::setw(16) << "M lookups/s"
+            << std::setw(12) << "checksum" << "\n";
+  report("edge: std::map<string> + substr", edge_predicates,
+         [&edgetype_map](const string &q) { return static_cast<int>(map_lookup(edgetype_map, q)); });
+  report("edge: Edge::string_to_edgetype(strip_iri)", edge_predicates,
+         [](const string &q) { return static_cast<int>(Edge::string_to_edgetype(strip_iri(q))); });
+  report("value: std::map<string> + substr", value_predicates,
+         [&predicate_map](const string &q) { return static_cast<int>(map_lookup(predicate_map, q)); });
+  report("value: string_to_predicate(strip_iri)", value_predicates,
+         [](const string &q) { return static_cast<int>(PredicateValue::string_to_predicate(strip_iri(q))); });
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file termid_bench.cpp
+ * @brief Throughput of the conversion of strings to TermIds: from_string and from_url,
+ * which throw for malformed ids, compared with parse, parse_url and parse_all, which
+ * report them in the result.
+ *
+ * The valid ids are the node ids of the JSON file (IRIs) and the CURIEs of the same terms.
+ * For the mixed column, every other CURIE is replaced by its local id alone (0001234),
+ * which is neither a CURIE nor an IRI that we recognize, as for many xrefs in the wild.
+ */
+#include "benchutil.h"
+#include "../lib/termid.h"
+#include "../lib/myexception.h"
+
+#include <iomanip>
+#include <string_view>
+
+/** Time one pass of convert over the ids (best of several repetitions) and print ids per second. */
+static void report(const string &name, size_t n, std::function<size_t()> convert)
+{
+  double best_ms = 0;
+  size_t converted = 0;
+  for (int rep = 0; rep < 5; ++rep)
+  {
+    size_t c = 0;
+    double ms = time_in_process([&]() { c = convert(); }, 1);
+    if (rep == 0 || ms < best_ms)
+    {
+      best_ms = ms;
+    }
+    converted = c;
+  }
+  double per_second = best_ms > 0 ? n / best_ms * 1000.0 : 0.0;
+  std::cout << std::left << std::setw(44) << name
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << best_ms
+            << std::setw(16) << std::setprecision(2) << per_second / 1e6
+            << std::setw(12) << converted << "\n";
+}
+
+int run_termid_bench(const string &path)
+{
+  std::cout << "[INFO] TermId parse benchmark: " << path << "\n";
+  vector<string> urls;
+  vector<string> curies;
+  vector<string> mixed;
+  for (const string &id : read_string_values(path, "id"))
+  {
+    TermIdResult r = TermId::parse_url(id);
+    if (! r)
+    {
+      continue;
+    }
+    urls.push_back(id);
+    curies.push_back(r.value.get_value());
+    mixed.push_back(mixed.size() % 2 == 0 ? curies.back() : r.value.get_id());
+  }
+  vector<std::string_view> curie_views(curies.begin(), curies.end());
+  std::cout << "[INFO] " << urls.size() << " ids\n";
+  std::cout << std::left << std::setw(44) << "case"
+            << std::right << std::setw(12) << "wall (ms)"
+            << std::setw(16) << "M ids/s"
+            << std::setw(12) << "converted" << "\n";
+  report("TermId::from_url", urls.size(), [&urls]() {
+    size_t c = 0;
+    for (const string &s : urls)
+    {
+      c += TermId::from_url(s).prefix_index() >= 0;
+    }
+    return c;
+  });
+  report("TermId::parse_url", urls.size(), [&urls]() {
+    size_t c = 0;
+    for (const string &s : urls)
+    {
+      c += static_cast<bool>(TermId::parse_url(s));
+    }
+    return c;
+  });
+  report("TermId::from_string (CURIE)", curies.size(), [&curies]() {
+    size_t c = 0;
+    for (const string &s : curies)
+    {
+      c += TermId::from_string(s).prefix_index() >= 0;
+    }
+    return c;
+  });
+  report("TermId::parse_all (CURIE)", curies.size(), [&curie_views]() {
+    vector<TermId> ids;
+    return TermId::parse_all(curie_views, ids);
+  });
+  report("TermId::from_string + catch (50% malformed)", mixed.size(), [&mixed]() {
+    size_t c = 0;
+    for (const string &s : mixed)
+    {
+      try
+      {
+        c += TermId::from_string(s).prefix_index() >= 0;
+      }
+      catch (const PhenopacketException &) {}
+    }
+    return c;
+  });
+  report("TermId::parse (50% malformed)", mixed.size(), [&mixed]() {
+    size_t c = 0;
+    for (const string &s : mixed)
+    {
+      c += static_cast<bool>(TermId::parse(s));
+    }
+    return c;
+  });
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file ancestorclosure.cc
+ * @brief The ancestors of every vertex of the is_a graph, computed once.
+ */
+#include "ancestorclosure.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+/**
+ * The vertices are visited in an order in which every parent comes before its children (the
+ * post-order of a depth-first search along the edges). The row of a vertex is then the vertex
+ * itself plus the union of the rows of its parents; a stamp per vertex removes the ancestors
+ * that are reached via several parents, so each row costs its length times the number of parents.
+ */
+AncestorClosure::AncestorClosure(const vector<int> &offsets, const vector<int> &edge_to,
+                                 const vector<EdgeType> &edge_types, EdgeType etype)
+{
+  auto start = std::chrono::steady_clock::now();
+  const int n = offsets.empty() ? 0 : static_cast<int>(offsets.size()) - 1;
+  // position of each vertex in the order; -1: not visited, -2: on the stack of the search
+  vector<int> position(n, -1);
+  vector<int> order;
+  order.reserve(n);
+  vector<std::pair<int, int>> stack; // vertex, next edge
+  for (int root = 0; root < n; ++root) {
+    if (position[root] != -1) {
+      continue;
+    }
+    position[root] = -2;
+    stack.emplace_back(root, offsets[root]);
+    while (! stack.empty()) {
+      auto &top = stack.back();
+      int v = top.first;
+      if (top.second == offsets[v + 1]) {
+        position[v] = static_cast<int>(order.size());
+        order.push_back(v);
+        stack.pop_back();
+        continue;
+      }
+      int e = top.second++;
+      int w = edge_to[e];
+      if (edge_types[e] == etype && position[w] == -1) {
+        position[w] = -2;
+        stack.emplace_back(w, offsets[w]);
+      }
+    }
+  }
+  // rows in the order of the search; row_start[v] and row_length[v] locate them
+  vector<int> rows;
+  vector<size_t> row_start(n);
+  vector<int> row_length(n);
+  vector<int> stamp(n, -1);
+  for (int v : order) {
+    size_t begin = rows.size();
+    rows.push_back(v);
+    stamp[v] = v;
+    for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+      int p = edge_to[e];
+      // a parent that comes later in the order closes a cycle
+      if (edge_types[e] != etype || position[p] > position[v]) {
+        continue;
+      }
+      for (size_t i = row_start[p]; i < row_start[p] + row_length[p]; ++i) {
+        int a = rows[i];
+        if (stamp[a] != v) {
+          stamp[a] = v;
+          rows.push_back(a);
+        }
+      }
+    }
+    std::sort(rows.begin() + begin, rows.end());
+    row_start[v] = begin;
+    row_length[v] = static_cast<int>(rows.size() - begin);
+  }
+  offsets_.resize(n + 1);
+  offsets_[0] = 0;
+  for (int v = 0; v < n; ++v) {
+    offsets_[v + 1] = offsets_[v] + row_length[v];
+  }
+  ancestors_.resize(rows.size());
+  for (int v = 0; v < n; ++v) {
+    std::copy(rows.begin() + row_start[v], rows.begin() + row_start[v] + row_length[v],
+              ancestors_.begin() + offsets_[v]);
+    stats_.max_row_length = std::max(stats_.max_row_length, static_cast<size_t>(row_length[v]));
+  }
+  stats_.vertices = n;
+  stats_.entries = ancestors_.size();
+  stats_.bytes = (offsets_.capacity() + ancestors_.capacity()) * sizeof(int);
+  stats_.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool
+AncestorClosure::contains(int v, int a) const
+{
+  return std::binary_search(begin(v), end(v), a);
+}
@@ -0,0 +1,64 @@
+/**
+ * @file ancestorclosure.h
+ * @brief The ancestors of every vertex of the is_a graph, computed once.
+ * @author Peter N Robinson
+ *
+ * Ontology::get_ancestors walks the graph from the term upwards, and the commands that place
+ * terms or annotations into top-level categories do this once per term. The closure stores,
+ * for each vertex, the sorted vertex indices of the vertex itself and all of its ancestors in
+ * one CSR array (the same layout as the edges of Ontology). Retrieving the ancestors of a term
+ * is then a pair of offsets, and "is a an ancestor of v" is a binary search in a short sorted
+ * row (HPO terms have a few dozen ancestors at most).
+ *
+ * A bit matrix would answer the membership query with a single load, but it needs n*n/8 bytes
+ * (about 36 MB for HPO and far more for MONDO or the merged ontologies); the rows need four
+ * bytes per (vertex, ancestor) pair. stats() reports the size and the time it took to build the
+ * closure, so that the commands can decide whether the closure is worth building.
+ */
+#ifndef ANCESTORCLOSURE_H
+#define ANCESTORCLOSURE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "edge.h"
+
+using std::vector;
+
+class AncestorClosure {
+public:
+  struct Stats {
+    size_t vertices = 0;
+    /** Sum of the row lengths, i.e., of the number of ancestors (including the vertex itself). */
+    size_t entries = 0;
+    size_t max_row_length = 0;
+    /** Bytes of the offset and ancestor arrays. */
+    size_t bytes = 0;
+    double build_ms = 0;
+    /** Bytes that a bit matrix with one row per vertex would need. */
+    size_t bit_matrix_bytes() const { return vertices * ((vertices + 7) / 8); }
+  };
+  /** An empty closure (built() is false). */
+  AncestorClosure() = default;
+  /**
+   * Compute the closure of the graph given by the CSR arrays of Ontology, following the edges
+   * of type etype only. The graph should be acyclic; an edge that closes a cycle is ignored.
+   */
+  AncestorClosure(const vector<int> &offsets, const vector<int> &edge_to,
+                  const vector<EdgeType> &edge_types, EdgeType etype = EdgeType::IS_A);
+  bool built() const { return ! offsets_.empty(); }
+  /** The vertex v and its ancestors, sorted by vertex index, are [begin(v), end(v)). */
+  const int *begin(int v) const { return ancestors_.data() + offsets_[v]; }
+  const int *end(int v) const { return ancestors_.data() + offsets_[v + 1]; }
+  /** @return true if a is v or an ancestor of v. */
+  bool contains(int v, int a) const;
+  const Stats &stats() const { return stats_; }
+
+private:
+  /** The row of vertex v is ancestors_[offsets_[v]] ... ancestors_[offsets_[v+1]-1]. */
+  vector<int> offsets_;
+  vector<int> ancestors_;
+  Stats stats_;
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file civildate.cc
+ * @brief A calendar date (year, month, day) stored as a 32-bit day number.
+ */
+#include "civildate.h"
+
+#include <charconv>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+
+CivilDate
+CivilDate::parse(std::string_view s)
+{
+  const char *p = s.data();
+  const char *end = s.data() + s.size();
+  int y = 0, M = 0, d = 0;
+  auto r = std::from_chars(p, end, y);
+  if (r.ec != std::errc() || r.ptr == end || *r.ptr != '-') {
+    return CivilDate();
+  }
+  r = std::from_chars(r.ptr + 1, end, M);
+  if (r.ec != std::errc() || r.ptr == end || *r.ptr != '-') {
+    return CivilDate();
+  }
+  r = std::from_chars(r.ptr + 1, end, d);
+  if (r.ec != std::errc()) {
+    return CivilDate();
+  }
+  return CivilDate(y, M, d);
+}
+
+CivilDate
+CivilDate::today()
+{
+  time_t now = time(nullptr);
+  tm utc = {};
+  gmtime_r(&now, &utc);
+  return CivilDate(utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday);
+}
+
+/** The inverse of to_day_number. */
+void
+CivilDate::to_civil(int &year, int &month, int &day) const
+{
+  uint32_t era = day_number_ / 146097;
+  uint32_t doe = day_number_ - era * 146097;
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+  day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+  month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  year = static_cast<int>(yoe + era * 400) + (month <= 2 ? 1 : 0);
+}
+
+int
+CivilDate::year() const
+{
+  int y, m, d;
+  to_civil(y, m, d);
+  return y;
+}
+
+int
+CivilDate::month() const
+{
+  int y, m, d;
+  to_civil(y, m, d);
+  return m;
+}
+
+int
+CivilDate::day() const
+{
+  int y, m, d;
+  to_civil(y, m, d);
+  return d;
+}
+
+std::string
+CivilDate::to_string() const
+{
+  if (empty()) {
+    return std::string();
+  }
+  int y, m, d;
+  to_civil(y, m, d);
+  std::stringstream ss;
+  ss << std::setfill('0') << std::setw(4) << y << "-" << std::setw(2) << m << "-" << std::setw(2) << d;
+  return ss.str();
+}
+
+std::ostream &
+operator<<(std::ostream &ost, CivilDate date)
+{
+  ost << date.to_string();
+  return ost;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file civildate.h
+ * @brief A calendar date (year, month, day) stored as a 32-bit day number.
+ * @author Peter N Robinson
+ *
+ * Creation dates of terms and curation dates of annotations used to be kept as
+ * struct tm, which is 36 or more bytes and has to be compared field by field.
+ * A CivilDate is the number of days since 0000-03-01 of the proleptic Gregorian
+ * calendar, so two dates are compared with one integer comparison, and a column
+ * of dates can be filtered with a branch-free loop. Day number 0 means "no date";
+ * only the years 1 to 9999 can be represented.
+ */
+#ifndef CIVILDATE_H
+#define CIVILDATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+class CivilDate {
+public:
+  /** No date (empty() is true); it compares less than every date. */
+  constexpr CivilDate() = default;
+  /** The date year-month-day; empty if it does not exist (e.g., 2019-02-29). */
+  constexpr CivilDate(int year, int month, int day) :
+    day_number_(is_valid(year, month, day) ? to_day_number(year, month, day) : 0) {}
+  static constexpr CivilDate from_day_number(uint32_t n) { CivilDate d; d.day_number_ = n; return d; }
+  /**
+   * Parse the date at the start of an ISO 8601 string such as 2012-04-22 or
+   * 2014-11-12T19:12:14.505Z; anything after the day is ignored.
+   * @return the date, or an empty CivilDate if s does not start with a valid date.
+   */
+  static CivilDate parse(std::string_view s);
+  /** @return the current date (UTC). */
+  static CivilDate today();
+  static constexpr bool is_valid(int year, int month, int day)
+  {
+    return year >= 1 && year <= 9999 && month >= 1 && month <= 12 && day >= 1 && day <= days_in_month(year, month);
+  }
+  constexpr bool empty() const { return day_number_ == 0; }
+  constexpr uint32_t day_number() const { return day_number_; }
+  int year() const;
+  /** 1-12 */
+  int month() const;
+  /** 1-31 */
+  int day() const;
+  /** @return e.g., 2012-04-22, or the empty string for no date. */
+  std::string to_string() const;
+
+  constexpr bool operator==(CivilDate o) const { return day_number_ == o.day_number_; }
+  constexpr bool operator!=(CivilDate o) const { return day_number_ != o.day_number_; }
+  constexpr bool operator<(CivilDate o) const { return day_number_ < o.day_number_; }
+  constexpr bool operator<=(CivilDate o) const { return day_number_ <= o.day_number_; }
+  constexpr bool operator>(CivilDate o) const { return day_number_ > o.day_number_; }
+  constexpr bool operator>=(CivilDate o) const { return day_number_ >= o.day_number_; }
+
+private:
+  uint32_t day_number_ = 0;
+
+  static constexpr int days_in_month(int year, int month)
+  {
+    constexpr int DAYS[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return month == 2 && leap ? 29 : DAYS[month - 1];
+  }
+  /** Days since 0000-03-01; the year starts in March, so that the leap day is the last day of the year. */
+  static constexpr uint32_t to_day_number(int year, int month, int day)
+  {
+    uint32_t y = static_cast<uint32_t>(month <= 2 ? year - 1 : year);
+    uint32_t era = y / 400;
+    uint32_t yoe = y - era * 400;
+    uint32_t mp = static_cast<uint32_t>(month > 2 ? month - 3 : month + 9);
+    uint32_t doy = (153 * mp + 2) / 5 + static_cast<uint32_t>(day) - 1;
+    uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe;
+  }
+  void to_civil(int &year, int &month, int &day) const;
+};
+
+std::ostream &operator<<(std::ostream &ost, CivilDate date);
+
+/** The dates from start to end, both included. */
+struct DateWindow {
+  CivilDate start;
+  CivilDate end;
+  /** A single comparison per bound and no branch, so that loops over many dates can be vectorized. */
+  constexpr bool contains(CivilDate d) const { return (start <= d) & (d <= end); }
+  /** @return the number of the n dates that lie in the window. */
+  size_t count(const CivilDate *dates, size_t n) const
+  {
+    const uint32_t lo = start.day_number();
+    const uint32_t hi = end.day_number();
+    size_t c = 0;
+    for (size_t i = 0; i < n; ++i) {
+      uint32_t d = dates[i].day_number();
+      c += (lo <= d) & (d <= hi);
+    }
+    return c;
+  }
+};
+
+#endif
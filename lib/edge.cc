@@ -6,13 +6,13 @@
  */
 
 #include "edge.h"
+#include "staticregistry.h"
 
 #include <iostream> // remove after debug
 
-/**
- * Static initialization of map of edge types. */
-map<string,EdgeType>
-Edge::edgetype_registry_ = {
+namespace {
+/** The predicates of the OBO-JSON file (the part after the last / of the IRI) and their EdgeType. */
+constexpr RegistryEntry<EdgeType> EDGE_TYPES[] = {
 			    {"is_a",EdgeType::IS_A},
 			    {"RO_0004020",EdgeType::DISEASE_HAS_BASIS_IN_DYSFUNCTION_OF},
 			    {"RO_0004021",EdgeType::DISEASE_HAS_BASIS_IN_DISRUPTION_OF},
@@ -33,16 +33,44 @@ Edge::edgetype_registry_ = {
 			    {"mondo#disease_shares_features_of",EdgeType::DISEASE_SHARES_FEATURES_OF},
 			    {"mondo#disease_has_basis_in_development_of",EdgeType::DISEASE_HAS_BASIS_IN_DEVELOPMENT_OF},
 			    {"BFO_0000054",EdgeType::REALIZED_IN},
-  };
+};
+/** Built at compile time (see staticregistry.h). */
+constexpr auto EDGE_TYPE_REGISTRY = make_registry(EDGE_TYPES);
+static_assert(*EDGE_TYPE_REGISTRY.find("is_a") == EdgeType::IS_A, "EdgeType registry");
+}
 
 EdgeType
-Edge::string_to_edgetype(const string &s)
+Edge::string_to_edgetype(std::string_view s)
 {
-  auto p = Edge::edgetype_registry_.find(s);
-  if (p == Edge::edgetype_registry_.end()) {
-    throw "Unrecognized edgetype:" + s;
+  const EdgeType *et = EDGE_TYPE_REGISTRY.find(s);
+  if (et == nullptr) {
+    throw JsonParseException("Unrecognized edgetype: " + string(s));
   }
-  return p->second;
+  return *et;
+}
+
+/**
+ * OBO flat files write relations as CURIEs (RO:0004029) or, for relations
+ * defined in the ontology itself, by name (predisposes_towards in MONDO).
+ */
+EdgeType
+Edge::obo_relation_to_edgetype(std::string_view relation)
+{
+  const EdgeType *et = EDGE_TYPE_REGISTRY.find(relation);
+  if (et == nullptr) {
+    string key{relation};
+    size_t pos = key.find(':');
+    if (pos != string::npos) {
+      key[pos] = '_';
+      et = EDGE_TYPE_REGISTRY.find(key);
+    } else {
+      et = EDGE_TYPE_REGISTRY.find("mondo#" + key);
+    }
+  }
+  if (et == nullptr) {
+    throw PhenopacketException("Unrecognized relation: " + string(relation));
+  }
+  return *et;
 }
 
 Edge
@@ -62,30 +90,32 @@ Edge::of(const rapidjson::Value &val){
   if (p == val.MemberEnd()) {
     throw JsonParseException("Edge did not contain \'sub\' element");
   }
-  
-  TermId subj = TermId::from_url(p->value.GetString());
+  string sub = p->value.GetString();
   p = val.FindMember("obj");
   if (p == val.MemberEnd()) {
     throw JsonParseException("Edge did not contain \'obj\' element");
   }
-  TermId obj = TermId::from_url(p->value.GetString());
+  string obj = p->value.GetString();
   p = val.FindMember("pred");
   if (p == val.MemberEnd()) {
     throw JsonParseException("Edge did not contain \'pred\' element");
   }
-  string etype = p->value.GetString();
-  size_t pos = etype.find_last_of("/");
-  if (pos != string::npos) {
-    etype = etype.substr(pos+1);
-  }
-  EdgeType edgetype;
-  auto it = edgetype_registry_.find(etype);
-  if (it != edgetype_registry_.end()) {
-    edgetype = it->second;
-  } else {
-    throw JsonParseException("TODO -- finish up.Could not find edge type "+etype);
+  return Edge::of(sub, p->value.GetString(), obj);
+}
+
+/**
+ * Factory used by the streaming parser, which sees the three strings of
+ * an edge element one after the other and never has a rapidjson::Value.
+ */
+Edge
+Edge::of(std::string_view sub, std::string_view pred, std::string_view obj){
+  TermId subj = TermId::from_url(sub);
+  TermId object = TermId::from_url(obj);
+  const EdgeType *edgetype = EDGE_TYPE_REGISTRY.find(strip_iri(pred));
+  if (edgetype == nullptr) {
+    throw JsonParseException("TODO -- finish up.Could not find edge type " + string(strip_iri(pred)));
   }
-  Edge e{subj,edgetype,obj};
+  Edge e{subj,*edgetype,object};
   return e;
 }
 
@@ -12,13 +12,11 @@
 #ifndef EDGE_H
 #define EDGE_H
 
-#include <map>
+#include <string_view>
 #include <rapidjson/document.h>
 #include "termid.h"
 #include "myexception.h"
 
-using std::map;
-
 enum class EdgeType {
   IS_A,
   IS_A_INVERSE,
@@ -52,12 +50,16 @@ private:
     source_(s),
     dest_(o),
     edge_type_(et) {}
-    /** Map from string representation of predicates from OBO-JSON file to EdgeType.*/
-  static map<string, EdgeType> edgetype_registry_;
 public:
   static Edge of(const rapidjson::Value &val);
-  /** Construct an EdgeType from a string using edgetype_registry_ .*/
-  static EdgeType string_to_edgetype(const string &s);
+  /** Construct an Edge from the sub, pred and obj strings of an OBO-JSON edge element. */
+  static Edge of(std::string_view sub, std::string_view pred, std::string_view obj);
+  /** Construct an Edge from the TermIds and the relation of an is_a or relationship tag of an OBO flat file. */
+  static Edge of(const TermId &sub, EdgeType et, const TermId &obj) { return Edge{sub, et, obj}; }
+  /** Look up the EdgeType of a predicate of the OBO-JSON file (e.g., is_a, RO_0004029); throws JsonParseException if unknown. */
+  static EdgeType string_to_edgetype(std::string_view s);
+  /** Look up the relation of an OBO flat file (e.g., is_a, RO:0004029); throws PhenopacketException if unknown. */
+  static EdgeType obo_relation_to_edgetype(std::string_view relation);
   TermId get_source() const { return source_; }
   TermId get_destination() const { return dest_; }
   EdgeType get_edge_type() const { return edge_type_; }
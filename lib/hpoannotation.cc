@@ -7,6 +7,8 @@
 
 #include "hpoannotation.h"
 #include "../lib/termid.h"
+#include "inputstream.h"
+#include "myexception.h"
 
 #include <iostream>
 #include <fstream>
@@ -37,14 +39,8 @@ Biocuration::Biocuration(const string &curation)
     if (j<0) j = curation.size();
     size_t len = j-i;
     string payload = curation.substr(i+1,len);
-    tm date = {};
-    int y,M,d,h,m;
-    float s;
-    sscanf(payload.c_str(), "%d-%d-%dT%d:%d:%fZ", &y, &M, &d, &h, &m, &s);
-    date.tm_year = y - 1900; // Year since 1900
-    date.tm_mon = M - 1;     // 0-11
-    date.tm_mday = d;  
-    curation_date_ = date;
+    // e.g., 2019-09-06 or 2014-11-12T19:12:14.505Z; the time is not used
+    curation_date_ = CivilDate::parse(payload);
 }
 
 
@@ -54,11 +50,7 @@ Biocuration::to_string() const
     std::stringstream ss;
     ss  << curator_ 
         << "["
-        << (curation_date_.tm_year + 1900)
-        << "-"
-        << (curation_date_.tm_mon + 1)
-        << "-"
-        << (curation_date_.tm_mday)
+        << curation_date_
         << "]";
     return ss.str();
 }
@@ -86,14 +78,17 @@ vector<string> split(const string &str, char delim)
 vector<HpoAnnotation> 
 HpoAnnotation::parse_phenotype_hpoa(const string &path){
     vector<HpoAnnotation> annotations;
-    std::ifstream ifs(path);
-    if (! ifs.good()) {
+    // phenotype.hpoa may be gzip or zstd compressed
+    std::unique_ptr<InputStream> ifs;
+    try {
+        ifs = open_input_stream(path);
+    } catch (const PhenopacketException &e) {
         std::cerr << "[ERROR(" __FILE__ << ":" << __LINE__ 
               << ")] Could not open JSON ontology file \"" << path << "\"\n";
         exit(EXIT_FAILURE);
     }
     string line;
-    while(getline(ifs, line)){ //read data from file object and put it into string.
+    while(getline(*ifs, line)){ //read data from file object and put it into string.
         if (line.rfind("#", 0) == 0) {
             continue;
         }
@@ -101,6 +96,10 @@ HpoAnnotation::parse_phenotype_hpoa(const string &path){
         HpoAnnotation annot{line};
         annotations.push_back(annot);
       }
+    if (! ifs->get_error().empty()) {
+        std::cerr << "[ERROR] Could not decompress " << path << ": " << ifs->get_error() << "\n";
+        exit(EXIT_FAILURE);
+    }
     return annotations;
 }
 
@@ -114,10 +113,18 @@ HpoAnnotation::HpoAnnotation(const string &line)
             << EXPECTED_NUMBER_OF_FIELDS << ")\n";
         exit(1);
     }
-    disease_id_ = make_unique<TermId>(TermId::from_string(fields[0]));
+    TermIdResult disease_id = TermId::parse(fields[0]);
+    TermIdResult hpo_id = TermId::parse(fields[3]);
+    if (! disease_id || ! hpo_id) {
+        cerr << "[ERROR] Malformed line: "
+            << TermId::error_message(disease_id ? hpo_id.error : disease_id.error, disease_id ? fields[3] : fields[0])
+            << "\n";
+        exit(1);
+    }
+    disease_id_ = make_unique<TermId>(disease_id.value);
     disease_name_ = fields[1];
     negated_ = fields[2].rfind("NOT", 0) == 0;
-    hpo_id_ = make_unique<TermId>(TermId::from_string(fields[3]));
+    hpo_id_ = make_unique<TermId>(hpo_id.value);
     string evi = fields[5];
     if (evi == "IEA") {
         evidence_ = EvidenceType::IEA;
@@ -132,9 +139,16 @@ HpoAnnotation::HpoAnnotation(const string &line)
     
     string biocuration_string = fields[11];
     vector<string> curats = split(biocuration_string, ';');
+    CivilDate oldest;
     for (string s : curats) {
         curations_.push_back(Biocuration{s});
+        // most annotations have a single date; if there are several, we take the oldest
+        CivilDate date = curations_.back().get_curation_date();
+        if (! date.empty() && (oldest.empty() || date < oldest)) {
+            oldest = date;
+        }
     }
+    curation_date_ = oldest.empty() ? DEFAULT_CREATION_DATE : oldest;
 }
 
 
@@ -144,7 +158,8 @@ HpoAnnotation::HpoAnnotation(const HpoAnnotation &annot):
     negated_(annot.negated_),
     evidence_(annot.evidence_),
     hpo_id_(make_unique<TermId>(*(annot.hpo_id_))),
-    curations_(annot.curations_)
+    curations_(annot.curations_),
+    curation_date_(annot.curation_date_)
 {
 
 }
@@ -153,7 +168,7 @@ HpoAnnotation::HpoAnnotation(const HpoAnnotation &annot):
  bool 
  HpoAnnotation::is_omim() const
  {
-     return disease_id_->get_prefix() == "OMIM";
+     return disease_id_->has_prefix("OMIM");
  }
 
 
@@ -171,50 +186,6 @@ HpoAnnotation::get_hpo_id() const
      return tid;
 }
 
-// Am J Hum Genet. 2008 Nov 17; 83(5): 610–615. 
-/*
-int tm_sec;   // seconds of minutes from 0 to 61
-   int tm_min;   // minutes of hour from 0 to 59
-   int tm_hour;  // hours of day from 0 to 24
-   int tm_mday;  // day of month from 1 to 31
-   int tm_mon;   // month of year from 0 to 11
-   int tm_year;  // year since 1900
-   int tm_wday;  // days since sunday
-   int tm_yday;  // days since January 1st
-   int tm_isdst; // hours of daylight savings tim
-*/
-tm HpoAnnotation::DEFAULT_CREATION_DATE = {0,0,0,17,10,108,0,0,0};
-
-/** 
- * Return the oldest curation date
- * Most annotations just have a single date, some have multiple
- */
-tm 
-HpoAnnotation::get_curation_date() const
-{
-    if (curations_.empty()) {
-        return HpoAnnotation::DEFAULT_CREATION_DATE;
-    } else if (curations_.size() == 1) {
-        return curations_[0].get_curation_date();
-    } else {
-        // more than one curation date. Take the oldest
-        tm time0 = curations_[0].get_curation_date();
-        tm oldest = time0;
-        for (size_t i = 1; i < curations_.size(); ++i) {
-            tm timeI = curations_[i].get_curation_date();
-            if (oldest.tm_year < timeI.tm_year) {
-                continue;
-            } else if (oldest.tm_mon < timeI.tm_mon ) {
-                continue;
-            } else if (oldest.tm_mday < timeI.tm_mday) {
-                continue;
-            }
-        }
-        return oldest;
-    }
-}
-
-
 string 
 HpoAnnotation::get_disease_name() const
 {
@@ -4,10 +4,10 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <ctime>
 #include <iostream>
 
 #include "termid.h"
+#include "civildate.h"
 
 using std::string;
 using std::vector;
@@ -18,11 +18,11 @@ namespace phenotools {
     class Biocuration {
         private:
             string curator_;
-            tm curation_date_;
+            CivilDate curation_date_;
         public:
             Biocuration(const string &curation);
             string get_curator() const { return curator_; }
-            tm get_curation_date() const { return curation_date_; }
+            CivilDate get_curation_date() const { return curation_date_; }
             string to_string() const;
     };
 
@@ -36,6 +36,8 @@ namespace phenotools {
         EvidenceType evidence_;
         unique_ptr<TermId> hpo_id_;
         vector<Biocuration> curations_;
+        /** The oldest of the curation dates, determined once by the constructor. */
+        CivilDate curation_date_;
 
 
 
@@ -44,12 +46,16 @@ namespace phenotools {
          HpoAnnotation(const HpoAnnotation &annot);
          static vector<HpoAnnotation> parse_phenotype_hpoa(const string &path);
          bool is_omim() const;
+         const TermId &disease_id() const { return *disease_id_; }
+         const string &disease_name() const { return disease_name_; }
+         const TermId &hpo_id() const { return *hpo_id_; }
          TermId get_disease_id() const;
          string get_disease_name() const;
          string get_negated() const;
          TermId get_hpo_id() const;
          string get_biocuration_string() const;
-         tm get_curation_date() const;
+         /** @return the oldest curation date, or DEFAULT_CREATION_DATE if the annotation has none. */
+         CivilDate get_curation_date() const { return curation_date_; }
          bool is_IEA() const { return evidence_ == EvidenceType::IEA; }
          bool is_TAS() const { return evidence_ == EvidenceType::TAS; }
          bool is_PCS() const { return evidence_ == EvidenceType::PCS; }
@@ -57,7 +63,8 @@ namespace phenotools {
          string get_evidence_type_string() const;
          string get_database() const { return disease_id_->get_prefix(); }
         friend std::ostream& operator<<(std::ostream& ost, const HpoAnnotation& annot);
-        static tm DEFAULT_CREATION_DATE;
+        /** Publication of the HPO: Am J Hum Genet. 2008 Nov 17; 83(5): 610–615. */
+        static constexpr CivilDate DEFAULT_CREATION_DATE{2008, 11, 17};
     };
     std::ostream& operator<<(std::ostream& ost, const HpoAnnotation& annot);
 };
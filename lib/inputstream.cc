@@ -0,0 +1,297 @@
+/**
+ * @file inputstream.cc
+ * @brief Input streams that transparently decompress gzip and zstd files.
+ */
+#include "inputstream.h"
+#include "myexception.h"
+
+#include <fstream>
+#include <zlib.h>
+#ifdef PHENOTOOLS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+/** Size of the compressed blocks read from disk by the producer thread. */
+const size_t INPUT_BLOCK_SIZE = 1 << 18;
+}
+
+Compression detect_compression(const string &path)
+{
+  std::ifstream ifs(path, std::ios::binary);
+  unsigned char magic[4] = {0, 0, 0, 0};
+  ifs.read(reinterpret_cast<char *>(magic), sizeof(magic));
+  std::streamsize n = ifs.gcount();
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b)
+  {
+    return Compression::GZIP;
+  }
+  if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+  {
+    return Compression::ZSTD;
+  }
+  return Compression::NONE;
+}
+
+DecompressingStreamBuf::DecompressingStreamBuf(const string &path, Compression compression) : compression_(compression)
+{
+#ifndef PHENOTOOLS_HAVE_ZSTD
+  if (compression == Compression::ZSTD)
+  {
+    throw PhenopacketException("Cannot read " + path + ": phenotools was built without zstd support");
+  }
+#endif
+  file_ = fopen(path.c_str(), "rb");
+  if (file_ == nullptr)
+  {
+    throw PhenopacketException("Could not open " + path);
+  }
+  setg(nullptr, nullptr, nullptr);
+  producer_ = std::thread(&DecompressingStreamBuf::produce, this);
+}
+
+DecompressingStreamBuf::~DecompressingStreamBuf()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (producer_.joinable())
+  {
+    producer_.join();
+  }
+  fclose(file_);
+}
+
+void DecompressingStreamBuf::produce()
+{
+  try
+  {
+    if (compression_ == Compression::GZIP)
+    {
+      inflate_gzip();
+    }
+    else
+    {
+      decompress_zstd();
+    }
+  }
+  catch (const std::exception &e)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = e.what();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_ = true;
+  }
+  cv_.notify_all();
+}
+
+bool DecompressingStreamBuf::push_block(std::vector<char> &&block)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return stop_ || queue_.size() < MAX_QUEUED_BLOCKS; });
+  if (stop_)
+  {
+    return false;
+  }
+  queue_.push_back(std::move(block));
+  lock.unlock();
+  cv_.notify_all();
+  return true;
+}
+
+/**
+ * Inflate all gzip members of the file (bgzip and concatenated gzip files consist of
+ * several members).
+ */
+void DecompressingStreamBuf::inflate_gzip()
+{
+  z_stream zs{};
+  // 15 + 16: zlib window size with gzip header
+  if (inflateInit2(&zs, 15 + 16) != Z_OK)
+  {
+    throw PhenopacketException("Could not initialize zlib");
+  }
+  std::vector<unsigned char> in(INPUT_BLOCK_SIZE);
+  std::vector<char> out(BLOCK_SIZE);
+  size_t out_pos = 0;
+  bool member_done = false;
+  bool output_full = false;
+  int ret = Z_OK;
+  while (true)
+  {
+    // If the output block was filled, inflate may still hold output for the current input
+    if (member_done || (zs.avail_in == 0 && !output_full))
+    {
+      if (zs.avail_in == 0)
+      {
+        size_t n = fread(in.data(), 1, in.size(), file_);
+        if (n == 0)
+        {
+          break;
+        }
+        zs.next_in = in.data();
+        zs.avail_in = static_cast<uInt>(n);
+      }
+      if (member_done)
+      {
+        // another gzip member follows
+        inflateReset(&zs);
+        member_done = false;
+      }
+    }
+    zs.next_out = reinterpret_cast<Bytef *>(out.data() + out_pos);
+    zs.avail_out = static_cast<uInt>(out.size() - out_pos);
+    ret = inflate(&zs, Z_NO_FLUSH);
+    if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+    {
+      string msg = zs.msg != nullptr ? zs.msg : "corrupt gzip data";
+      inflateEnd(&zs);
+      throw PhenopacketException("gzip: " + msg);
+    }
+    output_full = zs.avail_out == 0;
+    out_pos = out.size() - zs.avail_out;
+    if (ret == Z_STREAM_END)
+    {
+      member_done = true;
+    }
+    if (out_pos == out.size())
+    {
+      if (!push_block(std::move(out)))
+      {
+        inflateEnd(&zs);
+        return;
+      }
+      out = std::vector<char>(BLOCK_SIZE);
+      out_pos = 0;
+    }
+  }
+  inflateEnd(&zs);
+  if (!member_done)
+  {
+    throw PhenopacketException("gzip: unexpected end of file");
+  }
+  if (out_pos > 0)
+  {
+    out.resize(out_pos);
+    push_block(std::move(out));
+  }
+}
+
+void DecompressingStreamBuf::decompress_zstd()
+{
+#ifdef PHENOTOOLS_HAVE_ZSTD
+  ZSTD_DStream *zds = ZSTD_createDStream();
+  if (zds == nullptr)
+  {
+    throw PhenopacketException("Could not initialize zstd");
+  }
+  ZSTD_initDStream(zds);
+  std::vector<char> in(ZSTD_DStreamInSize());
+  std::vector<char> out(BLOCK_SIZE);
+  size_t out_pos = 0;
+  size_t last_ret = 0;
+  size_t n;
+  while ((n = fread(in.data(), 1, in.size(), file_)) > 0)
+  {
+    ZSTD_inBuffer input = {in.data(), n, 0};
+    bool output_full = false;
+    // If the output block was filled, zstd may still hold output for the current input
+    while (input.pos < input.size || output_full)
+    {
+      ZSTD_outBuffer output = {out.data() + out_pos, out.size() - out_pos, 0};
+      last_ret = ZSTD_decompressStream(zds, &output, &input);
+      output_full = output.pos == output.size;
+      if (ZSTD_isError(last_ret))
+      {
+        string msg = ZSTD_getErrorName(last_ret);
+        ZSTD_freeDStream(zds);
+        throw PhenopacketException("zstd: " + msg);
+      }
+      out_pos += output.pos;
+      if (out_pos == out.size())
+      {
+        if (!push_block(std::move(out)))
+        {
+          ZSTD_freeDStream(zds);
+          return;
+        }
+        out = std::vector<char>(BLOCK_SIZE);
+        out_pos = 0;
+      }
+    }
+  }
+  ZSTD_freeDStream(zds);
+  if (last_ret != 0)
+  {
+    throw PhenopacketException("zstd: unexpected end of file");
+  }
+  if (out_pos > 0)
+  {
+    out.resize(out_pos);
+    push_block(std::move(out));
+  }
+#endif
+}
+
+DecompressingStreamBuf::int_type
+DecompressingStreamBuf::underflow()
+{
+  if (gptr() < egptr())
+  {
+    return traits_type::to_int_type(*gptr());
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return finished_ || !queue_.empty(); });
+    if (queue_.empty())
+    {
+      return traits_type::eof();
+    }
+    current_ = std::move(queue_.front());
+    queue_.pop_front();
+  }
+  cv_.notify_all();
+  setg(current_.data(), current_.data(), current_.data() + current_.size());
+  return traits_type::to_int_type(*gptr());
+}
+
+string DecompressingStreamBuf::get_error()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return error_;
+}
+
+InputStream::InputStream(const string &path) : std::istream(nullptr)
+{
+  Compression compression = detect_compression(path);
+  if (compression == Compression::NONE)
+  {
+    auto fb = std::make_unique<std::filebuf>();
+    if (fb->open(path, std::ios::in | std::ios::binary) == nullptr)
+    {
+      throw PhenopacketException("Could not open " + path);
+    }
+    buf_ = std::move(fb);
+  }
+  else
+  {
+    auto db = std::make_unique<DecompressingStreamBuf>(path, compression);
+    decompressor_ = db.get();
+    buf_ = std::move(db);
+  }
+  rdbuf(buf_.get());
+}
+
+string InputStream::get_error() const
+{
+  return decompressor_ != nullptr ? decompressor_->get_error() : string();
+}
+
+std::unique_ptr<InputStream> open_input_stream(const string &path)
+{
+  return std::make_unique<InputStream>(path);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file inputstream.h
+ * @brief Input streams that transparently decompress gzip and zstd files.
+ * @author Peter N Robinson
+ *
+ * The compression format is detected from the magic bytes of the file and not
+ * from the file name. Decompression runs on a separate thread that keeps a small
+ * number of decompressed blocks ahead of the reader, so that parsing and
+ * decompression overlap and no temporary file is needed.
+ */
+#ifndef INPUTSTREAM_H
+#define INPUTSTREAM_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+
+using std::string;
+
+enum class Compression { NONE, GZIP, ZSTD };
+
+/** @return the compression format of the file, judged from its first bytes. */
+Compression detect_compression(const string &path);
+
+/**
+ * A streambuf that hands out blocks decompressed by a producer thread. At most
+ * MAX_QUEUED_BLOCKS blocks are held in memory at any time.
+ */
+class DecompressingStreamBuf : public std::streambuf {
+private:
+  static constexpr size_t BLOCK_SIZE = 1 << 20;
+  static constexpr size_t MAX_QUEUED_BLOCKS = 4;
+  FILE *file_;
+  Compression compression_;
+  std::thread producer_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::vector<char>> queue_;
+  /** The block that is currently exposed via the get area. */
+  std::vector<char> current_;
+  bool finished_ = false;
+  bool stop_ = false;
+  string error_;
+
+  void produce();
+  void inflate_gzip();
+  void decompress_zstd();
+  /** Called by the producer; blocks while the queue is full. @return false if the reader has gone away. */
+  bool push_block(std::vector<char> &&block);
+
+protected:
+  int_type underflow() override;
+
+public:
+  DecompressingStreamBuf(const string &path, Compression compression);
+  DecompressingStreamBuf(const DecompressingStreamBuf &) = delete;
+  DecompressingStreamBuf &operator=(const DecompressingStreamBuf &) = delete;
+  ~DecompressingStreamBuf();
+  /** @return a description of the decompression error, if any (check after reading to the end). */
+  string get_error();
+};
+
+/**
+ * An istream for a plain or compressed file. Use the free function open_input_stream
+ * to create one.
+ */
+class InputStream : public std::istream {
+private:
+  std::unique_ptr<std::streambuf> buf_;
+  DecompressingStreamBuf *decompressor_ = nullptr;
+
+public:
+  explicit InputStream(const string &path);
+  bool is_compressed() const { return decompressor_ != nullptr; }
+  /** @return an error message if the compressed input was corrupt or truncated, otherwise an empty string. */
+  string get_error() const;
+};
+
+/** Open path for reading; gzip and zstd files are decompressed on the fly. Throws PhenopacketException on failure. */
+std::unique_ptr<InputStream> open_input_stream(const string &path);
+
+#endif
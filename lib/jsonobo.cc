@@ -5,47 +5,26 @@
  *  Author: Peter N Robinson
  */
 #include "jsonobo.h"
+#include "staticregistry.h"
 
-#include "rapidjson/writer.h"
-#include "rapidjson/stringbuffer.h"
 #include <rapidjson/istreamwrapper.h>
-#include <rapidjson/prettywriter.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/error/en.h>
 
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <deque>
+#include <string_view>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <iterator>
 
 using std::cerr;
 using std::cout;
 
-/**
- * A convenience function for debugging only!
- */
-void printJ(const rapidjson::Value &json)
-{
-  using namespace rapidjson;
-  StringBuffer sb;
-  PrettyWriter<StringBuffer> writer(sb);
-  json.Accept(writer);
-  auto str = sb.GetString();
-  cout << str << "\n";
-}
-
-/**
- * generate a printable String from an arbitrary RAPIDJSON value object.
- * Used mainly to create error messages (if any)
- * @param json A rapid json object
- * @return a String representation of the JSON.
- */
-string get_json_string(const rapidjson::Value &json)
-{
-  using namespace rapidjson;
-  StringBuffer sb;
-  PrettyWriter<StringBuffer> writer(sb);
-  json.Accept(writer);
-  return sb.GetString();
-}
-
 bool is_class(const rapidjson::Value &val)
 {
   if (!val.IsObject())
@@ -84,204 +63,1300 @@ void JsonOboParser::process_metadata(const rapidjson::Value &val)
   {
     throw JsonParseException("Attempt to add malformed meta (not JSON object).");
   }
-  auto itr = val.FindMember("basicPropertyValues");
-  if (itr != val.MemberEnd())
+  auto itr = val.FindMember("basicPropertyValues");
+  if (itr != val.MemberEnd())
+  {
+    const rapidjson::Value &propertyVals = itr->value;
+    if (!propertyVals.IsArray())
+    {
+      throw JsonParseException("Ontology property values not array");
+    }
+    for (auto elem = propertyVals.Begin(); elem != propertyVals.End(); elem++)
+    {
+      PredicateValue predval = json_to_predicate_value(*elem);
+      predicate_value_list_.push_back(predval);
+    }
+  }
+  itr = val.FindMember("version");
+  if (itr != val.MemberEnd() && itr->value.IsString())
+  {
+    ontology_version_ = itr->value.GetString();
+  }
+}
+
+void JsonOboParser::process_nodes(const rapidjson::Value &nodes)
+{
+  if (!nodes.IsArray())
+  {
+    throw JsonParseException("rapidjson nodes object is not array");
+  }
+  rapidjson::SizeType n_nodes = nodes.Size();
+  unsigned int n_workers = options_.threads;
+  if (n_workers == 0)
+  {
+    n_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  n_workers = std::min<unsigned int>(n_workers, n_nodes);
+  if (n_workers <= 1)
+  {
+    NodeBatch batch{options_.max_errors};
+    process_node_range(nodes, 0, n_nodes, batch);
+    term_list_ = std::move(batch.terms);
+    property_list_ = std::move(batch.properties);
+    error_list_.append(std::move(batch.errors));
+    return;
+  }
+  // Each worker gets a contiguous block of nodes and its own lists. Appending the
+  // lists in block order yields the same terms and errors, in the same order, as
+  // the single-threaded path.
+  vector<NodeBatch> batches(n_workers, NodeBatch{options_.max_errors});
+  vector<std::exception_ptr> failures(n_workers);
+  vector<std::thread> workers;
+  workers.reserve(n_workers);
+  rapidjson::SizeType block = (n_nodes + n_workers - 1) / n_workers;
+  for (unsigned int w = 0; w < n_workers; ++w)
+  {
+    rapidjson::SizeType begin = std::min(n_nodes, w * block);
+    rapidjson::SizeType end = std::min(n_nodes, begin + block);
+    workers.emplace_back([this, &nodes, &batches, &failures, w, begin, end]() {
+      try
+      {
+        process_node_range(nodes, begin, end, batches[w]);
+      }
+      catch (...)
+      {
+        failures[w] = std::current_exception();
+      }
+    });
+  }
+  for (std::thread &t : workers)
+  {
+    t.join();
+  }
+  for (const std::exception_ptr &failure : failures)
+  {
+    if (failure)
+    {
+      std::rethrow_exception(failure);
+    }
+  }
+  size_t n_terms = 0;
+  for (const NodeBatch &batch : batches)
+  {
+    n_terms += batch.terms.size();
+  }
+  term_list_.reserve(n_terms);
+  for (NodeBatch &batch : batches)
+  {
+    std::move(batch.terms.begin(), batch.terms.end(), std::back_inserter(term_list_));
+    std::move(batch.properties.begin(), batch.properties.end(), std::back_inserter(property_list_));
+    error_list_.append(std::move(batch.errors));
+  }
+}
+
+/**
+ * Convert the nodes [begin,end) into Term and Property objects. This function only
+ * reads from the DOM and only writes to batch, so that several ranges can be processed
+ * concurrently.
+ */
+void JsonOboParser::process_node_range(const rapidjson::Value &nodes,
+                                       rapidjson::SizeType begin,
+                                       rapidjson::SizeType end,
+                                       NodeBatch &batch) const
+{
+  for (rapidjson::SizeType i = begin; i < end; ++i)
+  {
+    const rapidjson::Value &v = nodes[i];
+    if (is_class(v))
+    {
+      try
+      {
+        Term term = json_to_term(v, i, batch.errors);
+        batch.terms.push_back(std::move(term));
+      }
+      catch (const JsonParseException &e)
+      {
+        batch.errors.add(ParseErrorCause::MALFORMED_TERM, i, OboParseError::UNKNOWN_OFFSET, e.what());
+      }
+    }
+    else if (is_property(v))
+    {
+      // This is a PROPERTY element (these are mixed with the CLASS elements
+      // in the JSON file), such as "UK spelling", "abbreviation" and so on.
+      // These elements introduce properties that can be used elsewhere, for
+      // instance, some synonyms have the property "UK spelling"
+      try
+      {
+        Property prop = json_to_property(v);
+        batch.properties.push_back(prop);
+      }
+      catch (const PhenopacketException &e)
+      {
+        batch.errors.add(ParseErrorCause::MALFORMED_PROPERTY, i, OboParseError::UNKNOWN_OFFSET, e.what());
+      }
+    }
+    else
+    {
+      // the id is enough to find the node, it is not worth printing the whole stanza
+      auto id = v.IsObject() ? v.FindMember("id") : v.MemberEnd();
+      string detail = id != v.MemberEnd() && id->value.IsString() ? id->value.GetString() : "";
+      batch.errors.add(ParseErrorCause::UNKNOWN_NODE_TYPE, i, OboParseError::UNKNOWN_OFFSET, detail);
+    }
+  }
+}
+
+void JsonOboParser::process_edges(const rapidjson::Value &edges,
+                                  vector<Edge> &edge_list,
+                                  OboParseErrorList &errors)
+{
+  if (!edges.IsArray())
+  {
+    throw JsonParseException("rapidjson edges object is not array");
+  }
+  edge_list.reserve(edge_list.size() + edges.Size());
+  for (rapidjson::SizeType i = 0; i < edges.Size(); ++i)
+  {
+    try
+    {
+      Edge e = Edge::of(edges[i]);
+      edge_list.push_back(e);
+    }
+    catch (const PhenopacketException &e)
+    {
+      errors.add(ParseErrorCause::MALFORMED_EDGE, i, OboParseError::UNKNOWN_OFFSET, e.what());
+    }
+  }
+}
+
+/**
+ * Convert the nodes and edges of the imported graphs a[1], a[2], ... Each worker takes
+ * the next graph from a shared counter and converts all of it into the batch of that
+ * graph; the batches are then appended in the order of the graphs, so that the result
+ * does not depend on the number of threads. Terms that occur in several graphs are
+ * kept once when the Ontology is built (see Ontology::add_all_terms).
+ */
+void JsonOboParser::process_imported_graphs(const rapidjson::Value &graphs)
+{
+  rapidjson::SizeType n_imports = graphs.Size() - 1;
+  vector<NodeBatch> batches(n_imports, NodeBatch{options_.max_errors});
+  vector<std::exception_ptr> failures(n_imports);
+  std::atomic<rapidjson::SizeType> next{0};
+  auto worker = [this, &graphs, &batches, &failures, &next, n_imports]() {
+    for (rapidjson::SizeType g = next++; g < n_imports; g = next++)
+    {
+      try
+      {
+        process_graph(graphs[g + 1], batches[g]);
+      }
+      catch (...)
+      {
+        failures[g] = std::current_exception();
+      }
+    }
+  };
+  unsigned int n_workers = options_.threads;
+  if (n_workers == 0)
+  {
+    n_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  n_workers = std::min<unsigned int>(n_workers, n_imports);
+  if (n_workers <= 1)
+  {
+    worker();
+  }
+  else
+  {
+    vector<std::thread> workers;
+    workers.reserve(n_workers);
+    for (unsigned int w = 0; w < n_workers; ++w)
+    {
+      workers.emplace_back(worker);
+    }
+    for (std::thread &t : workers)
+    {
+      t.join();
+    }
+  }
+  for (const std::exception_ptr &failure : failures)
+  {
+    if (failure)
+    {
+      std::rethrow_exception(failure);
+    }
+  }
+  size_t n_terms = term_list_.size();
+  size_t n_edges = edge_list_.size();
+  for (const NodeBatch &batch : batches)
+  {
+    n_terms += batch.terms.size();
+    n_edges += batch.edges.size();
+  }
+  term_list_.reserve(n_terms);
+  edge_list_.reserve(n_edges);
+  for (NodeBatch &batch : batches)
+  {
+    std::move(batch.terms.begin(), batch.terms.end(), std::back_inserter(term_list_));
+    std::move(batch.edges.begin(), batch.edges.end(), std::back_inserter(edge_list_));
+    std::move(batch.properties.begin(), batch.properties.end(), std::back_inserter(property_list_));
+    error_list_.append(std::move(batch.errors));
+  }
+}
+
+/**
+ * Convert all nodes and edges of an imported graph into batch. Unlike the main graph,
+ * an imported graph need not have nodes, edges, id or meta elements, and its meta
+ * element is not used.
+ */
+void JsonOboParser::process_graph(const rapidjson::Value &graph, NodeBatch &batch) const
+{
+  if (!graph.IsObject())
+  {
+    throw JsonParseException("Imported graph was not a rapidjson object.");
+  }
+  auto itr = graph.FindMember("nodes");
+  if (itr != graph.MemberEnd())
+  {
+    if (!itr->value.IsArray())
+    {
+      throw JsonParseException("rapidjson nodes object is not array");
+    }
+    process_node_range(itr->value, 0, itr->value.Size(), batch);
+  }
+  itr = graph.FindMember("edges");
+  if (itr != graph.MemberEnd())
+  {
+    process_edges(itr->value, batch.edges, batch.errors);
+  }
+}
+
+JsonOboParser::JsonOboParser(const string &path) : path_(path),
+                                                    error_list_(options_.max_errors)
+{
+  parse();
+}
+
+JsonOboParser::JsonOboParser(const string &path, bool edge_leniency) : path_(path),
+                                                                        error_list_(options_.max_errors)
+{
+  options_.edge_lenient = edge_leniency;
+  parse();
+}
+
+JsonOboParser::JsonOboParser(const string &path, const JsonOboOptions &options) : path_(path),
+                                                                                  options_(options),
+                                                                                  error_list_(options.max_errors)
+{
+  parse();
+}
+
+void JsonOboParser::parse()
+{
+  std::cout << "[INFO] Parsing " << path_ << "\n";
+  if (options_.mode == JsonParseMode::STREAMING)
+  {
+    parse_streaming();
+  }
+  else
+  {
+    parse_dom();
+  }
+}
+
+MappedFile JsonOboParser::map_input_file() const
+{
+  try
+  {
+    return MappedFile{path_};
+  }
+  catch (const PhenopacketException &e)
+  {
+    throw PhenopacketException("Could not open JSON ontology file \"" + path_ + "\": " + e.what());
+  }
+}
+
+std::unique_ptr<InputStream> JsonOboParser::open_input_file() const
+{
+  try
+  {
+    return open_input_stream(path_);
+  }
+  catch (const PhenopacketException &e)
+  {
+    throw PhenopacketException("Could not open JSON ontology file \"" + path_ + "\": " + e.what());
+  }
+}
+
+bool JsonOboParser::use_memory_map() const
+{
+  // compressed files are decompressed into a stream instead
+  return options_.memory_map && detect_compression(path_) == Compression::NONE;
+}
+
+void JsonOboParser::parse_dom()
+{
+  if (use_memory_map())
+  {
+    // The Document refers to strings in the mapping, so the mapping must outlive it.
+    MappedFile input = map_input_file();
+    rapidjson::Document d;
+    d.ParseInsitu(input.data());
+    check_parse_result(d);
+    process_document(d);
+    return;
+  }
+  rapidjson::Document d;
+  std::unique_ptr<InputStream> input = open_input_file();
+  rapidjson::IStreamWrapper isw(*input);
+
+  d.ParseStream(isw);
+  if (!input->get_error().empty())
+  {
+    throw JsonParseException("Could not decompress " + path_ + ": " + input->get_error());
+  }
+  check_parse_result(d);
+  process_document(d);
+}
+
+void JsonOboParser::check_parse_result(const rapidjson::ParseResult &result) const
+{
+  if (result.IsError())
+  {
+    std::stringstream sstr;
+    sstr << "Could not parse " << path_ << ": "
+         << rapidjson::GetParseError_En(result.Code())
+         << " (offset " << result.Offset() << ")";
+    throw JsonParseException(sstr.str());
+  }
+}
+
+void JsonOboParser::process_document(const rapidjson::Document &d)
+{
+  if (!d.IsObject() || !d.HasMember("graphs"))
+  {
+    throw JsonParseException("Ontology JSON did not contain graphs element array.");
+  }
+  const rapidjson::Value &a = d["graphs"];
+  if (!a.IsArray())
+  {
+    throw JsonParseException("Ontology JSON did not contain graphs element array.");
+  }
+  // the first item in the array is an object with a list of nodes
+  if (a.Size() < 1)
+  {
+    throw JsonParseException("Ontology JSON array is empty.");
+  }
+
+  const rapidjson::Value &mainObject = a[0];
+  if (!mainObject.IsObject())
+  {
+    throw JsonParseException("Main object was not a rapidjson object.");
+  }
+  const rapidjson::Value &nodes = mainObject["nodes"];
+  process_nodes(nodes);
+  string myError;
+  rapidjson::Value::ConstMemberIterator itr = mainObject.FindMember("edges");
+  if (itr == mainObject.MemberEnd())
+  {
+    throw JsonParseException("Did not find edges element");
+  }
+  const rapidjson::Value &edges = mainObject["edges"];
+  process_edges(edges, edge_list_, error_list_);
+
+  itr = mainObject.FindMember("id");
+  if (itr == mainObject.MemberEnd())
+  {
+    throw JsonParseException("Did not find id element");
+  }
+  else
+  {
+    ontology_id_ = itr->value.GetString();
+  }
+  itr = mainObject.FindMember("meta");
+  if (itr == mainObject.MemberEnd())
+  {
+    throw JsonParseException("Did not find meta element");
+  }
+  else
+  {
+    const rapidjson::Value &meta = mainObject["meta"];
+    process_metadata(meta);
+  }
+  // further graphs (e.g., the imports of hp-full.json) add their terms and edges
+  if (a.Size() > 1)
+  {
+    process_imported_graphs(a);
+  }
+}
+
+/**
+ * SAX handler for OBO-JSON. The handler keeps a stack with the kind of
+ * element it is currently inside of (e.g., a node, the meta element of a node,
+ * a synonym of a node) and collects the scalar values of one node or edge
+ * at a time. When the node or edge is closed, the corresponding Term,
+ * Property or Edge is created and handed to the parser, and the collected values
+ * are discarded. Elements that we do not use (e.g., logicalDefinitionAxioms)
+ * are skipped. The nodes and edges of all graphs are ingested, but only the
+ * id and meta element of the first (main) graph are used, as in the DOM path.
+ */
+class JsonOboSaxHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JsonOboSaxHandler>
+{
+public:
+  JsonOboSaxHandler(JsonOboParser &parser) : parser_(parser) {}
+  /**
+   * Create lazy terms: the definition, xrefs, property values and synonyms are not
+   * converted, only the byte range of the meta element in stream is recorded.
+   */
+  void set_lazy(std::shared_ptr<const LazyTermSource> source) { lazy_source_ = std::move(source); }
+  /** Provides the current byte offset of the input stream (for error records and lazy terms). */
+  void set_tell(std::function<size_t()> tell) { tell_ = std::move(tell); }
+
+  bool StartObject();
+  bool EndObject(rapidjson::SizeType memberCount);
+  bool StartArray();
+  bool EndArray(rapidjson::SizeType elementCount);
+  bool Key(const char *str, rapidjson::SizeType length, bool copy);
+  bool String(const char *str, rapidjson::SizeType length, bool copy);
+  bool Bool(bool b);
+  /** Numbers and nulls are not used by any element that we ingest. */
+  bool Default() { return true; }
+  /** Throws if the main graph lacked a required element or if parsing was aborted. */
+  void check_complete() const;
+  const string &get_fatal_error() const { return fatal_error_; }
+
+private:
+  enum class Ctx
+  {
+    DOCUMENT,
+    ROOT,
+    GRAPHS,
+    GRAPH,
+    NODES,
+    NODE,
+    NODE_META,
+    DEFINITION,
+    DEFINITION_XREFS,
+    XREFS,
+    XREF,
+    SYNONYMS,
+    SYNONYM,
+    PROPERTY_VALUES,
+    PROPERTY_VALUE,
+    EDGES,
+    EDGE,
+    GRAPH_META,
+    GRAPH_PROPERTY_VALUES,
+    GRAPH_PROPERTY_VALUE,
+    SKIP
+  };
+  /** Values of the node that is currently being read. */
+  struct NodeRecord
+  {
+    std::string_view id;
+    std::string_view type;
+    std::string_view label;
+    bool has_id = false;
+    bool has_type = false;
+    bool has_label = false;
+    bool has_meta = false;
+    bool deprecated = false;
+    bool has_definition = false;
+    /** Position of the node in the nodes array and in the input. */
+    size_t index = 0;
+    size_t offset = OboParseError::UNKNOWN_OFFSET;
+    /** Byte range of the meta object in the input (lazy mode only). */
+    size_t meta_begin = 0;
+    size_t meta_end = 0;
+    std::string_view definition;
+    vector<std::string_view> definition_xrefs;
+    vector<std::string_view> xrefs;
+    vector<std::pair<std::string_view, std::string_view>> synonyms;
+    vector<std::pair<std::string_view, std::string_view>> property_values;
+    /** Set if the node is malformed; it is then reported and skipped. */
+    string error;
+  };
+  /** The pred/val (or sub/pred/obj) pair that is currently being read. */
+  struct Triple
+  {
+    std::string_view a, b, c;
+    bool has_a = false, has_b = false, has_c = false;
+    size_t index = 0;
+    size_t offset = OboParseError::UNKNOWN_OFFSET;
+  };
+
+  JsonOboParser &parser_;
+  vector<Ctx> stack_{Ctx::DOCUMENT};
+  string key_;
+  NodeRecord node_;
+  Triple triple_;
+  /** Owns copies of the strings of the current node/edge when rapidjson does not keep them for us. */
+  std::deque<string> scratch_;
+  int graph_index_ = -1;
+  bool seen_graphs_ = false;
+  bool seen_edges_ = false;
+  bool seen_id_ = false;
+  bool seen_meta_ = false;
+  string fatal_error_;
+  std::shared_ptr<const LazyTermSource> lazy_source_;
+  std::function<size_t()> tell_;
+  size_t node_count_ = 0;
+  size_t edge_count_ = 0;
+
+  Ctx top() const { return stack_.back(); }
+  bool is_lazy() const { return lazy_source_ != nullptr; }
+  /** @return offset of the opening brace of the object that has just been started. */
+  size_t object_begin() const { return tell_ ? tell_() - 1 : OboParseError::UNKNOWN_OFFSET; }
+  void add_error(ParseErrorCause cause, size_t index, size_t offset, const string &detail)
+  {
+    parser_.error_list_.add(cause, index, offset, detail);
+  }
+  /** Definitions, xrefs and synonyms are only visited for the FULL profile (also if they are then kept lazily). */
+  bool builds_details() const { return parser_.options_.profile == LoadProfile::FULL; }
+  bool is_lazy_field(Ctx ctx) const;
+  std::string_view keep(const char *str, rapidjson::SizeType length, bool copy);
+  Ctx child_object(Ctx parent) const;
+  Ctx child_array(Ctx parent) const;
+  void finish_node();
+  void finish_term();
+  void finish_property();
+  void finish_edge();
+  void reset_node();
+};
+
+std::string_view
+JsonOboSaxHandler::keep(const char *str, rapidjson::SizeType length, bool copy)
+{
+  if (!copy)
+  {
+    // the string lives in the input buffer (in situ parsing)
+    return std::string_view(str, length);
+  }
+  scratch_.emplace_back(str, length);
+  return std::string_view(scratch_.back());
+}
+
+/**
+ * @return true if values in ctx are only decoded when a lazy term is materialized.
+ */
+bool JsonOboSaxHandler::is_lazy_field(Ctx ctx) const
+{
+  switch (ctx)
+  {
+  case Ctx::DEFINITION:
+  case Ctx::DEFINITION_XREFS:
+  case Ctx::XREF:
+  case Ctx::SYNONYM:
+    return is_lazy();
+  default:
+    return false;
+  }
+}
+
+JsonOboSaxHandler::Ctx
+JsonOboSaxHandler::child_object(Ctx parent) const
+{
+  switch (parent)
+  {
+  case Ctx::DOCUMENT:
+    return Ctx::ROOT;
+  case Ctx::GRAPHS:
+    return Ctx::GRAPH;
+  case Ctx::GRAPH:
+    return key_ == "meta" && graph_index_ == 0 ? Ctx::GRAPH_META : Ctx::SKIP;
+  case Ctx::NODES:
+    return Ctx::NODE;
+  case Ctx::NODE:
+    return key_ == "meta" ? Ctx::NODE_META : Ctx::SKIP;
+  case Ctx::NODE_META:
+    return key_ == "definition" && builds_details() ? Ctx::DEFINITION : Ctx::SKIP;
+  case Ctx::XREFS:
+    return Ctx::XREF;
+  case Ctx::SYNONYMS:
+    return Ctx::SYNONYM;
+  case Ctx::PROPERTY_VALUES:
+    return Ctx::PROPERTY_VALUE;
+  case Ctx::EDGES:
+    return Ctx::EDGE;
+  case Ctx::GRAPH_PROPERTY_VALUES:
+    return Ctx::GRAPH_PROPERTY_VALUE;
+  default:
+    return Ctx::SKIP;
+  }
+}
+
+JsonOboSaxHandler::Ctx
+JsonOboSaxHandler::child_array(Ctx parent) const
+{
+  switch (parent)
+  {
+  case Ctx::ROOT:
+    return key_ == "graphs" ? Ctx::GRAPHS : Ctx::SKIP;
+  case Ctx::GRAPH:
+    if (key_ == "nodes")
+      return Ctx::NODES;
+    if (key_ == "edges")
+      return Ctx::EDGES;
+    return Ctx::SKIP;
+  case Ctx::NODE_META:
+    if (key_ == "xrefs" && builds_details())
+      return Ctx::XREFS;
+    if (key_ == "synonyms" && builds_details())
+      return Ctx::SYNONYMS;
+    if (key_ == "basicPropertyValues")
+      return Ctx::PROPERTY_VALUES;
+    return Ctx::SKIP;
+  case Ctx::DEFINITION:
+    return key_ == "xrefs" ? Ctx::DEFINITION_XREFS : Ctx::SKIP;
+  case Ctx::GRAPH_META:
+    return key_ == "basicPropertyValues" ? Ctx::GRAPH_PROPERTY_VALUES : Ctx::SKIP;
+  default:
+    return Ctx::SKIP;
+  }
+}
+
+bool JsonOboSaxHandler::StartObject()
+{
+  Ctx parent = top();
+  if (parent == Ctx::GRAPHS)
+  {
+    // the error records refer to the position in the nodes/edges array of each graph
+    ++graph_index_;
+    node_count_ = 0;
+    edge_count_ = 0;
+  }
+  Ctx ctx = child_object(parent);
+  switch (ctx)
+  {
+  case Ctx::NODE:
+    reset_node();
+    node_.index = node_count_++;
+    node_.offset = object_begin();
+    break;
+  case Ctx::NODE_META:
+    node_.has_meta = true;
+    if (is_lazy())
+    {
+      // the opening brace has already been consumed
+      node_.meta_begin = object_begin();
+    }
+    break;
+  case Ctx::XREF:
+  case Ctx::SYNONYM:
+  case Ctx::PROPERTY_VALUE:
+  case Ctx::GRAPH_PROPERTY_VALUE:
+    triple_ = Triple{};
+    break;
+  case Ctx::EDGE:
+    triple_ = Triple{};
+    triple_.index = edge_count_++;
+    triple_.offset = object_begin();
+    break;
+  case Ctx::GRAPH_META:
+    seen_meta_ = true;
+    break;
+  default:
+    break;
+  }
+  stack_.push_back(ctx);
+  return true;
+}
+
+bool JsonOboSaxHandler::EndObject(rapidjson::SizeType)
+{
+  Ctx ctx = top();
+  stack_.pop_back();
+  switch (ctx)
+  {
+  case Ctx::NODE:
+    finish_node();
+    break;
+  case Ctx::NODE_META:
+    if (is_lazy())
+    {
+      node_.meta_end = tell_();
+    }
+    break;
+  case Ctx::XREF:
+    // term xrefs are objects such as {"val" : "UMLS:C4024355"}
+    if (triple_.has_b && !is_lazy())
+    {
+      node_.xrefs.push_back(triple_.b);
+    }
+    break;
+  case Ctx::SYNONYM:
+    if (!triple_.has_a)
+    {
+      node_.error = "Synonym required to have pred object (node:" + string(node_.id) + ")";
+    }
+    else if (!triple_.has_b)
+    {
+      node_.error = "Synonym required to have val object (node:" + string(node_.id) + ")";
+    }
+    else if (!is_lazy())
+    {
+      node_.synonyms.emplace_back(triple_.a, triple_.b);
+    }
+    break;
+  case Ctx::PROPERTY_VALUE:
+    if (!triple_.has_a)
+    {
+      node_.error = "PropertyValue did not contain \'pred\' element";
+    }
+    else if (!triple_.has_b)
+    {
+      node_.error = "PropertyValue did not contain \'val\' element";
+    }
+    else
+    {
+      node_.property_values.emplace_back(triple_.a, triple_.b);
+    }
+    break;
+  case Ctx::EDGE:
+    finish_edge();
+    break;
+  case Ctx::GRAPH_PROPERTY_VALUE:
+    if (!triple_.has_a || !triple_.has_b)
+    {
+      // in the DOM path this is a fatal error, see process_metadata
+      fatal_error_ = "Ontology property value did not contain pred and val elements";
+      return false;
+    }
+    parser_.predicate_value_list_.push_back(
+        JsonOboParser::make_predicate_value(triple_.a, triple_.b));
+    scratch_.clear();
+    break;
+  default:
+    break;
+  }
+  return true;
+}
+
+bool JsonOboSaxHandler::StartArray()
+{
+  Ctx ctx = child_array(top());
+  if (ctx == Ctx::GRAPHS)
+  {
+    seen_graphs_ = true;
+  }
+  else if (ctx == Ctx::EDGES && graph_index_ == 0)
+  {
+    seen_edges_ = true;
+  }
+  stack_.push_back(ctx);
+  return true;
+}
+
+bool JsonOboSaxHandler::EndArray(rapidjson::SizeType)
+{
+  stack_.pop_back();
+  return true;
+}
+
+bool JsonOboSaxHandler::Key(const char *str, rapidjson::SizeType length, bool)
+{
+  key_.assign(str, length);
+  return true;
+}
+
+bool JsonOboSaxHandler::String(const char *str, rapidjson::SizeType length, bool copy)
+{
+  if (is_lazy_field(top()))
+  {
+    // Only note which values are present, so that malformed nodes are still
+    // reported during the parse; the values are decoded on demand.
+    if (top() == Ctx::DEFINITION && key_ == "val")
+    {
+      node_.has_definition = true;
+    }
+    else if (key_ == "pred")
+    {
+      triple_.has_a = true;
+    }
+    else if (key_ == "val")
+    {
+      triple_.has_b = true;
+    }
+    return true;
+  }
+  switch (top())
+  {
+  case Ctx::NODE:
+    if (key_ == "id")
+    {
+      node_.id = keep(str, length, copy);
+      node_.has_id = true;
+    }
+    else if (key_ == "type")
+    {
+      node_.type = keep(str, length, copy);
+      node_.has_type = true;
+    }
+    else if (key_ == "lbl")
+    {
+      if (parser_.options_.profile != LoadProfile::GRAPH_ONLY)
+      {
+        node_.label = keep(str, length, copy);
+      }
+      node_.has_label = true;
+    }
+    break;
+  case Ctx::NODE_META:
+    if (key_ == "deprecated")
+    {
+      node_.deprecated = true;
+    }
+    break;
+  case Ctx::DEFINITION:
+    if (key_ == "val")
+    {
+      node_.definition = keep(str, length, copy);
+      node_.has_definition = true;
+    }
+    break;
+  case Ctx::DEFINITION_XREFS:
+    node_.definition_xrefs.push_back(keep(str, length, copy));
+    break;
+  case Ctx::XREF:
+  case Ctx::SYNONYM:
+  case Ctx::PROPERTY_VALUE:
+  case Ctx::GRAPH_PROPERTY_VALUE:
+    if (key_ == "pred")
+    {
+      triple_.a = keep(str, length, copy);
+      triple_.has_a = true;
+    }
+    else if (key_ == "val")
+    {
+      triple_.b = keep(str, length, copy);
+      triple_.has_b = true;
+    }
+    break;
+  case Ctx::EDGE:
+    if (key_ == "sub")
+    {
+      triple_.a = keep(str, length, copy);
+      triple_.has_a = true;
+    }
+    else if (key_ == "pred")
+    {
+      triple_.b = keep(str, length, copy);
+      triple_.has_b = true;
+    }
+    else if (key_ == "obj")
+    {
+      triple_.c = keep(str, length, copy);
+      triple_.has_c = true;
+    }
+    break;
+  case Ctx::GRAPH:
+    if (key_ == "id" && graph_index_ == 0)
+    {
+      parser_.ontology_id_.assign(str, length);
+      seen_id_ = true;
+    }
+    break;
+  case Ctx::GRAPH_META:
+    if (key_ == "version")
+    {
+      parser_.ontology_version_.assign(str, length);
+    }
+    break;
+  default:
+    break;
+  }
+  return true;
+}
+
+bool JsonOboSaxHandler::Bool(bool)
+{
+  // assumption -- no need to check that deprecated: "true"
+  // this member is never used unless it is true.
+  if (top() == Ctx::NODE_META && key_ == "deprecated")
+  {
+    node_.deprecated = true;
+  }
+  return true;
+}
+
+void JsonOboSaxHandler::reset_node()
+{
+  node_.has_id = node_.has_type = node_.has_label = false;
+  node_.has_meta = node_.deprecated = node_.has_definition = false;
+  node_.definition_xrefs.clear();
+  node_.xrefs.clear();
+  node_.synonyms.clear();
+  node_.property_values.clear();
+  node_.error.clear();
+  scratch_.clear();
+}
+
+void JsonOboSaxHandler::finish_node()
+{
+  if (node_.has_type && node_.type == "CLASS")
+  {
+    finish_term();
+  }
+  else if (node_.has_type && node_.type == "PROPERTY")
+  {
+    finish_property();
+  }
+  else
   {
-    const rapidjson::Value &propertyVals = itr->value;
-    if (!propertyVals.IsArray())
-    {
-      throw JsonParseException("Ontology property values not array");
-    }
-    for (auto elem = propertyVals.Begin(); elem != propertyVals.End(); elem++)
-    {
-      PredicateValue predval = json_to_predicate_value(*elem);
-      predicate_value_list_.push_back(predval);
-    }
+    add_error(ParseErrorCause::UNKNOWN_NODE_TYPE, node_.index, node_.offset,
+              node_.has_id ? string(node_.id) : string());
   }
+  scratch_.clear();
 }
 
-void JsonOboParser::process_nodes(const rapidjson::Value &nodes)
+void JsonOboSaxHandler::finish_term()
 {
-  if (!nodes.IsArray())
+  if (!node_.has_id)
   {
-    throw JsonParseException("rapidjson nodes object is not array");
+    node_.error = "Attempt to add malformed node (no id).";
   }
-  string myError;
-  for (auto &v : nodes.GetArray())
+  else if (!node_.has_label)
   {
-    if (is_class(v))
+    node_.error = "Malformed node (" + string(node_.id) + "): no label.";
+  }
+  if (!node_.error.empty())
+  {
+    add_error(ParseErrorCause::MALFORMED_TERM, node_.index, node_.offset, node_.error);
+    return;
+  }
+  try
+  {
+    TermId tid = TermId::from_string(node_.id);
+    Term term{tid, node_.label};
+    if (!node_.has_meta)
     {
-      try
+      add_error(ParseErrorCause::MISSING_META, node_.index, node_.offset, string(node_.id));
+    }
+    if (is_lazy() || !builds_details())
+    {
+      // alternative ids are needed to build the term map and are cheap, so
+      // we add them now; the rest of the meta element is decoded on demand
+      // or (depending on the profile) not at all
+      for (const auto &pv : node_.property_values)
       {
-        Term term = json_to_term(v);
-        term_list_.push_back(term);
+        PredicateValue predval = JsonOboParser::make_predicate_value(pv.first, pv.second);
+        if (parser_.is_early_property_value(predval))
+        {
+          term.add_predicate_value(predval);
+        }
       }
-      catch (const JsonParseException &e)
+      term.set_obsolete(node_.deprecated);
+      if (node_.has_meta && is_lazy())
       {
-        string json_stanza = get_json_string(v);
-        string message = e.what();
-        std::stringstream sstr;
-        sstr << "[ERROR] " __FILE__ << " (l." << __LINE__ << ") \"" << e.what();
-        //cerr << sstr.str() << "\n";
-        error_list_.push_back(sstr.str());
+        term.set_lazy_source(lazy_source_, node_.meta_begin, node_.meta_end);
       }
+      parser_.term_list_.push_back(std::move(term));
+      return;
     }
-    else if (is_property(v))
+    if (node_.has_definition)
     {
-      // This is a PROPERTY element (these are mixed with the CLASS elements
-      // in the JSON file), such as "UK spelling", "abbreviation" and so on.
-      // These elements introduce properties that can be used elsewhere, for
-      // instance, some synonyms have the property "UK spelling"
-      try
+      term.add_definition(node_.definition);
+    }
+    TermIdError error;
+    for (std::string_view x : node_.definition_xrefs)
+    {
+      Xref xref = Xref::parse(x, error);
+      if (error == TermIdError::NONE)
       {
-        Property prop = json_to_property(v);
-        property_list_.push_back(prop);
+        term.add_definition_xref(xref);
       }
-      catch (const PhenopacketException &e)
+      else
       {
-        std::stringstream sstr;
-        sstr << "[ERROR] Could not create Node" << e.what() << "; generated by ("
-             << get_json_string(v);
-        error_list_.push_back(sstr.str());
+        add_error(ParseErrorCause::MALFORMED_XREF, node_.index, node_.offset, TermId::error_message(error, x));
       }
     }
-    else
+    for (std::string_view x : node_.xrefs)
+    {
+      Xref xref = Xref::parse(x, error);
+      if (error == TermIdError::NONE)
+      {
+        term.add_term_xref(xref);
+      }
+      else
+      {
+        add_error(ParseErrorCause::MALFORMED_XREF, node_.index, node_.offset, TermId::error_message(error, x));
+      }
+    }
+    for (const auto &syn : node_.synonyms)
     {
-      std::stringstream sstr;
-      sstr << "[ERROR] parse_nodes function encountered object that is neither node nor property: ";
-      sstr << get_json_string(v);
-      error_list_.push_back(sstr.str());
+      term.add_synonym(string(syn.first), syn.second);
     }
+    for (const auto &pv : node_.property_values)
+    {
+      term.add_predicate_value(JsonOboParser::make_predicate_value(pv.first, pv.second));
+    }
+    if (node_.deprecated)
+    {
+      term.set_obsolete(true);
+    }
+    parser_.term_list_.push_back(std::move(term));
+  }
+  catch (const PhenopacketException &e)
+  {
+    add_error(ParseErrorCause::MALFORMED_TERM, node_.index, node_.offset, e.what());
   }
 }
 
-void JsonOboParser::process_edges(const rapidjson::Value &edges)
+void JsonOboSaxHandler::finish_property()
 {
-  if (!edges.IsArray())
+  if (!node_.has_id)
   {
-    throw JsonParseException("rapidjson edges object is not array");
+    add_error(ParseErrorCause::MALFORMED_PROPERTY, node_.index, node_.offset, "Attempt to add malformed node (no id).");
+    return;
   }
-  for (auto &v : edges.GetArray())
+  try
   {
-    try
+    AllowedPropertyValue apv = Property::id_to_property(node_.id);
+    parser_.property_list_.emplace_back(apv);
+  }
+  catch (const PhenopacketException &e)
+  {
+    add_error(ParseErrorCause::MALFORMED_PROPERTY, node_.index, node_.offset, e.what());
+  }
+}
+
+void JsonOboSaxHandler::finish_edge()
+{
+  try
+  {
+    if (!triple_.has_a)
     {
-      Edge e = Edge::of(v);
-      edge_list_.push_back(e);
+      throw JsonParseException("Edge did not contain \'sub\' element");
     }
-    catch (const PhenopacketException &e)
+    if (!triple_.has_c)
+    {
+      throw JsonParseException("Edge did not contain \'obj\' element");
+    }
+    if (!triple_.has_b)
     {
-      std::stringstream sstr;
-      sstr << "[ERROR] Could not create Edge: " << e.what() << "; generated by ("
-           << get_json_string(v);
-      error_list_.push_back(sstr.str());
+      throw JsonParseException("Edge did not contain \'pred\' element");
     }
+    parser_.edge_list_.push_back(Edge::of(triple_.a, triple_.b, triple_.c));
+  }
+  catch (const PhenopacketException &e)
+  {
+    add_error(ParseErrorCause::MALFORMED_EDGE, triple_.index, triple_.offset, e.what());
   }
+  scratch_.clear();
 }
 
-JsonOboParser::JsonOboParser(const string &path) : path_(path),
-                                                   edge_lenient_(true)
+void JsonOboSaxHandler::check_complete() const
 {
-  parse();
+  if (!seen_graphs_)
+  {
+    throw JsonParseException("Ontology JSON did not contain graphs element array.");
+  }
+  if (graph_index_ < 0)
+  {
+    throw JsonParseException("Ontology JSON array is empty.");
+  }
+  if (!seen_edges_)
+  {
+    throw JsonParseException("Did not find edges element");
+  }
+  if (!seen_id_)
+  {
+    throw JsonParseException("Did not find id element");
+  }
+  if (!seen_meta_)
+  {
+    throw JsonParseException("Did not find meta element");
+  }
 }
 
-JsonOboParser::JsonOboParser(const string &path, bool edge_leniency) : path_(path),
-                                                                       edge_lenient_(edge_leniency)
+/**
+ * Decodes the meta element of lazily parsed terms. It shares ownership of the
+ * mapped input file with all terms that have not been materialized yet.
+ */
+class JsonMetaSource : public LazyTermSource
 {
-  parse();
-}
+public:
+  explicit JsonMetaSource(std::shared_ptr<MappedFile> input) : input_(std::move(input)) {}
+  void materialize(Term &term, size_t begin, size_t end) const override;
 
-void JsonOboParser::parse()
+private:
+  std::shared_ptr<MappedFile> input_;
+};
+
+/**
+ * The byte range was a valid meta element when the file was parsed; if it no longer is (e.g.,
+ * the file was changed after it was mapped), the term cannot be completed and we throw rather
+ * than return a term without details.
+ */
+void JsonMetaSource::materialize(Term &term, size_t begin, size_t end) const
 {
+  const string id = term.get_term_id().get_value();
+  auto fail = [&](const string &reason) {
+    throw JsonParseException("Could not decode the meta element of " + id + " (bytes " + std::to_string(begin) +
+                             "-" + std::to_string(end) + " of the ontology file): " + reason);
+  };
   rapidjson::Document d;
-  std::cout << "[INFO] Parsing " << path_ << "\n";
-  std::ifstream ifs(path_);
-  if (!ifs.good())
+  d.Parse(input_->data() + begin, end - begin);
+  if (d.HasParseError())
   {
-    std::cerr << "[ERROR (" __FILE__ << ":" << __LINE__ 
-              << ")] Could not open JSON ontology file \"" << path_ << "\"\n";
-    exit(EXIT_FAILURE);
+    fail(rapidjson::GetParseError_En(d.GetParseError()));
   }
-  rapidjson::IStreamWrapper isw(ifs);
-
-  d.ParseStream(isw);
-  const rapidjson::Value &a = d["graphs"];
-  if (!a.IsArray())
+  // errors in the meta element were already reported by the parser
+  OboParseErrorList errors{0};
+  try
   {
-    throw JsonParseException("Ontology JSON did not contain graphs element array.");
+    JsonOboParser::add_meta_to_term(d, term, id, 0, errors, true);
   }
-  // the first item in the array is an object with a list of nodes
-  if (a.Size() < 1)
+  catch (const PhenopacketException &e)
   {
-    throw JsonParseException("Ontology JSON array is empty.");
+    fail(e.what());
   }
+}
 
-  const rapidjson::Value &mainObject = a[0];
-  if (!mainObject.IsObject())
+void JsonOboParser::parse_streaming()
+{
+  JsonOboSaxHandler handler{*this};
+  rapidjson::Reader reader;
+  rapidjson::ParseResult result;
+  if (options_.lazy_terms && options_.profile == LoadProfile::FULL && use_memory_map())
   {
-    throw JsonParseException("Main object was not a rapidjson object.");
+    // Not in situ: the terms decode their meta element from the unmodified mapping later.
+    auto input = std::make_shared<MappedFile>(map_input_file());
+    rapidjson::StringStream ss(input->data());
+    handler.set_lazy(std::make_shared<JsonMetaSource>(input));
+    handler.set_tell([&ss]() { return ss.Tell(); });
+    result = reader.Parse(ss, handler);
+    // Only few terms are usually materialized, so let the kernel reclaim the pages we read.
+    input->drop_resident_pages();
   }
-  const rapidjson::Value &nodes = mainObject["nodes"];
-  process_nodes(nodes);
-  string myError;
-  rapidjson::Value::ConstMemberIterator itr = mainObject.FindMember("edges");
-  if (itr == mainObject.MemberEnd())
+  else if (use_memory_map())
   {
-    throw JsonParseException("Did not find edges element");
+    // In situ, the handler receives pointers into the mapping and only
+    // copies the strings that end up in a Term.
+    MappedFile input = map_input_file();
+    rapidjson::InsituStringStream iss(input.data());
+    handler.set_tell([&iss]() { return iss.Tell(); });
+    result = reader.Parse<rapidjson::kParseInsituFlag>(iss, handler);
   }
-  const rapidjson::Value &edges = mainObject["edges"];
-  process_edges(edges);
+  else
+  {
+    std::unique_ptr<InputStream> input = open_input_file();
+    rapidjson::IStreamWrapper isw(*input);
+    handler.set_tell([&isw]() { return isw.Tell(); });
+    result = reader.Parse(isw, handler);
+    if (!input->get_error().empty())
+    {
+      throw JsonParseException("Could not decompress " + path_ + ": " + input->get_error());
+    }
+  }
+  if (!handler.get_fatal_error().empty())
+  {
+    throw JsonParseException(handler.get_fatal_error());
+  }
+  check_parse_result(result);
+  handler.check_complete();
+}
 
-  itr = mainObject.FindMember("id");
-  if (itr == mainObject.MemberEnd())
+void JsonOboParser::output_quality_assessment(std::ostream &ost) const
+{
+  if (error_list_.empty())
   {
-    throw JsonParseException("Did not find id element");
+    ost << "[INFO] No errors enounted in JSON parse\n";
+    return;
   }
-  else
+  ost << "[ERRORS]:\n";
+  for (const OboParseError &e : error_list_.records())
   {
-    ontology_id_ = itr->value.GetString();
+    ost << format_error(e) << "\n";
   }
-  itr = mainObject.FindMember("meta");
-  if (itr == mainObject.MemberEnd())
+  if (error_list_.dropped() > 0)
   {
-    throw JsonParseException("Did not find meta element");
+    ost << "[INFO] " << error_list_.dropped() << " further errors were not retained (total: "
+        << error_list_.total() << ")\n";
+  }
+}
+
+void OboParseErrorList::add(ParseErrorCause cause, size_t index, size_t byte_offset, const string &detail)
+{
+  if (errors_.size() < max_errors_)
+  {
+    errors_.push_back(OboParseError{cause, index, byte_offset, detail});
   }
   else
   {
-    const rapidjson::Value &meta = mainObject["meta"];
-    process_metadata(meta);
+    ++dropped_;
   }
-  /* std::cout << "DONE:" <<  std::endl;
-  if (error_list_.size()>0) {
-    for (string e : error_list_) {
-      std::cout << "\t" << e << "\n";
+}
+
+void OboParseErrorList::append(OboParseErrorList &&other)
+{
+  for (OboParseError &e : other.errors_)
+  {
+    if (errors_.size() < max_errors_)
+    {
+      errors_.push_back(std::move(e));
+    }
+    else
+    {
+      ++dropped_;
     }
-  } else {
-    std::cout << "[INFO] No errors encountered\n";
-  }*/
+  }
+  dropped_ += other.dropped_;
+  other.errors_.clear();
+  other.dropped_ = 0;
 }
 
-void JsonOboParser::output_quality_assessment(std::ostream &ost) const
+string
+JsonOboParser::format_error(const OboParseError &error)
 {
-  if (error_list_.size() == 0)
+  std::stringstream sstr;
+  switch (error.cause)
   {
-    ost << "[INFO] No errors enounted in JSON parse\n";
-    return;
+  case ParseErrorCause::MALFORMED_TERM:
+    sstr << "[ERROR] Could not create Term: " << error.detail;
+    break;
+  case ParseErrorCause::MISSING_META:
+    sstr << "[WARNING] node (" << error.detail << ") has no Metainformation";
+    break;
+  case ParseErrorCause::MALFORMED_XREF:
+    sstr << "[ERROR] Could not parse Xref: " << error.detail;
+    break;
+  case ParseErrorCause::MALFORMED_PROPERTY:
+    sstr << "[ERROR] Could not create Property: " << error.detail;
+    break;
+  case ParseErrorCause::UNKNOWN_NODE_TYPE:
+    sstr << "[ERROR] Encountered node that is neither CLASS nor PROPERTY: "
+         << (error.detail.empty() ? "(no id)" : error.detail);
+    break;
+  case ParseErrorCause::MALFORMED_EDGE:
+    sstr << "[ERROR] Could not create Edge: " << error.detail;
+    break;
   }
-  ost << "[ERRORS]:\n";
-  for (string e : error_list_)
+  sstr << " (" << (error.cause == ParseErrorCause::MALFORMED_EDGE ? "edge" : "node") << " #" << error.index;
+  if (error.byte_offset != OboParseError::UNKNOWN_OFFSET)
   {
-    ost << e << "\n";
+    sstr << ", byte " << error.byte_offset;
   }
+  sstr << ")";
+  return sstr.str();
 }
 
 unique_ptr<Ontology>
 JsonOboParser::get_ontology()
 {
-  return std::make_unique<Ontology>(ontology_id_,
-                                    term_list_,
-                                    edge_list_,
-                                    predicate_value_list_,
-                                    property_list_);
+  return release_builder().build();
+}
+
+OntologyBuilder
+JsonOboParser::release_builder()
+{
+  OntologyBuilder builder{ontology_id_};
+  builder.set_version(ontology_version_)
+      .set_terms(std::move(term_list_))
+      .set_edges(std::move(edge_list_))
+      .set_predicate_values(std::move(predicate_value_list_))
+      .set_properties(std::move(property_list_))
+      .set_edge_lenient(options_.edge_lenient)
+      .set_threads(options_.threads);
+  return builder;
 }
 
 /**
@@ -299,30 +1374,26 @@ JsonOboParser::json_to_predicate_value(const rapidjson::Value &val)
   {
     throw JsonParseException("PropertyValue did not contain \'pred\' element");
   }
-  // PropertyValue elements may contain elements like this
-  // "pred" : "http://purl.org/dc/elements/1.1/creator",
-  // In this case, we extract the last subelement (creator)
-  string pred = val["pred"].GetString();
-  size_t pos = pred.find_last_of('/');
-  if (pos != string::npos)
-  {
-    pred = pred.substr(pos + 1);
-  }
-  //We keep a list of properties in
-  Predicate predicate = PredicateValue::string_to_predicate(pred);
-
   p = val.FindMember("val");
   if (p == val.MemberEnd())
   {
     throw JsonParseException("PropertyValue did not contain \'val\' element");
   }
+  return make_predicate_value(val["pred"].GetString(), val["val"].GetString());
+}
 
-  string valu = val["val"].GetString();
-  PredicateValue pv{predicate, valu};
+PredicateValue
+JsonOboParser::make_predicate_value(std::string_view predicate_string, std::string_view value)
+{
+  // PropertyValue elements may contain elements like this
+  // "pred" : "http://purl.org/dc/elements/1.1/creator",
+  // In this case, we look up the last subelement (creator)
+  Predicate predicate = PredicateValue::string_to_predicate(strip_iri(predicate_string));
+  PredicateValue pv{predicate, value};
   return pv;
 }
 
-Term JsonOboParser::json_to_term(const rapidjson::Value &val)
+Term JsonOboParser::json_to_term(const rapidjson::Value &val, size_t index, OboParseErrorList &errors) const
 {
   string id;
   string label;
@@ -356,128 +1427,178 @@ Term JsonOboParser::json_to_term(const rapidjson::Value &val)
     label = val["lbl"].GetString();
   }
   TermId tid = TermId::from_string(id);
+  if (options_.profile == LoadProfile::GRAPH_ONLY)
+  {
+    label.clear();
+  }
   Term term{tid, label};
   if (!val.HasMember("meta"))
   {
     //throw JsonParseException("Malformed node ("+id+"): no Metainformation");
-    std::stringstream sstr;
-    sstr << "[WARNING] node (" << id << ") has no Metainformation";
-    error_list_.push_back(sstr.str());
+    errors.add(ParseErrorCause::MISSING_META, index, OboParseError::UNKNOWN_OFFSET, id);
+  }
+  else if (options_.profile != LoadProfile::FULL)
+  {
+    add_profile_meta_to_term(val["meta"], term, id);
   }
   else
   {
-    const rapidjson::Value &meta = val["meta"];
-    if (!meta.IsObject())
+    add_meta_to_term(val["meta"], term, id, index, errors, false);
+  }
+  return term;
+}
+
+bool JsonOboParser::is_early_property_value(const PredicateValue &pv) const
+{
+  if (pv.is_alternate_id())
+  {
+    return true;
+  }
+  // creation dates of lazy terms are decoded on demand with the other property values
+  return options_.profile == LoadProfile::GRAPH_LABELS_DATES &&
+         (pv.get_property() == Predicate::CREATION_DATE || pv.get_property() == Predicate::DATE);
+}
+
+/**
+ * Only the basicPropertyValues and the deprecated flag of meta are read; definitions,
+ * xrefs and synonyms are not needed by profiles other than FULL.
+ */
+void JsonOboParser::add_profile_meta_to_term(const rapidjson::Value &meta, Term &term, const string &id) const
+{
+  if (!meta.IsObject())
+  {
+    throw JsonParseException("Malformed node (" + id + "): meta is not JSON object.");
+  }
+  rapidjson::Value::ConstMemberIterator itr = meta.FindMember("basicPropertyValues");
+  if (itr != meta.MemberEnd())
+  {
+    const rapidjson::Value &propertyVals = itr->value;
+    if (!propertyVals.IsArray())
     {
-      throw JsonParseException("Malformed node (" + id + "): meta is not JSON object.");
+      throw JsonParseException("Malformed node (" + id + "): Term property values not array");
     }
-    rapidjson::Value::ConstMemberIterator itr = meta.FindMember("definition");
-    if (itr != meta.MemberEnd())
+    for (auto elem = propertyVals.Begin(); elem != propertyVals.End(); elem++)
     {
-      const rapidjson::Value &definition = meta["definition"];
-      rapidjson::Value::ConstMemberIterator it = definition.FindMember("val");
-      if (it != definition.MemberEnd())
+      PredicateValue propval = json_to_predicate_value(*elem);
+      if (is_early_property_value(propval))
       {
-        string definition_value = it->value.GetString();
-        term.add_definition(definition_value);
-      }
-      it = definition.FindMember("xrefs");
-      if (it != definition.MemberEnd())
-      {
-        const rapidjson::Value &defxrefs = it->value;
-        if (!defxrefs.IsArray())
-        {
-          throw JsonParseException("Malformed node (" + id + "): xref not array");
-        }
-        for (auto xrefs_itr = defxrefs.Begin(); xrefs_itr != defxrefs.End(); ++xrefs_itr)
-        {
-          try
-          {
-            Xref xr = json_to_xref(*xrefs_itr); // xrefs in definitions are simply CURIEs.
-            term.add_definition_xref(xr);
-          }
-          catch (const PhenopacketException &e)
-          {
-            std::stringstream sstr;
-            error_list_.push_back(e.what());
-          }
-        }
+        term.add_predicate_value(propval);
       }
-    } // done with definition
-    itr = meta.FindMember("xrefs");
-    if (itr != meta.MemberEnd())
+    }
+  }
+  if (meta.HasMember("deprecated"))
+  {
+    term.set_obsolete(true);
+  }
+}
+
+/**
+ * Decode the meta element of a node into term. If lazy_fields_only is true, the
+ * alternative ids and the obsolete flag are skipped, because they were set when
+ * the (lazy) term was created.
+ */
+void JsonOboParser::add_meta_to_term(const rapidjson::Value &meta,
+                                     Term &term,
+                                     const string &id,
+                                     size_t index,
+                                     OboParseErrorList &errors,
+                                     bool lazy_fields_only)
+{
+  if (!meta.IsObject())
+  {
+    throw JsonParseException("Malformed node (" + id + "): meta is not JSON object.");
+  }
+  rapidjson::Value::ConstMemberIterator itr = meta.FindMember("definition");
+  if (itr != meta.MemberEnd())
+  {
+    const rapidjson::Value &definition = meta["definition"];
+    rapidjson::Value::ConstMemberIterator it = definition.FindMember("val");
+    if (it != definition.MemberEnd())
+    {
+      string definition_value = it->value.GetString();
+      term.add_definition(definition_value, lazy_fields_only);
+    }
+    it = definition.FindMember("xrefs");
+    if (it != definition.MemberEnd())
     {
-      const rapidjson::Value &xrefs = itr->value;
-      if (!xrefs.IsArray())
+      const rapidjson::Value &defxrefs = it->value;
+      if (!defxrefs.IsArray())
       {
-        throw JsonParseException("Malformed node (" + id + "): Term Xrefs not array");
+        throw JsonParseException("Malformed node (" + id + "): xref not array");
       }
-      else
+      for (auto xrefs_itr = defxrefs.Begin(); xrefs_itr != defxrefs.End(); ++xrefs_itr)
       {
-        for (auto elem = xrefs.Begin(); elem != xrefs.End(); elem++)
-        {
-          auto elem_iter = elem->FindMember("val");
-          if (elem_iter != elem->MemberEnd())
-          {
-            try
-            {
-              Xref txr = json_to_xref(elem_iter->value);
-              term.add_term_xref(txr);
-            }
-            catch (const PhenopacketException &e)
-            {
-              std::stringstream sstr;
-              sstr << "Could not parse XRef: " << e.what();
-              error_list_.push_back(e.what());
-            }
-          }
-        }
+        // xrefs in definitions are simply CURIEs.
+        add_json_xref(*xrefs_itr, term, &Term::add_definition_xref, index, errors);
       }
     }
-    if (meta.HasMember("synonyms"))
+  } // done with definition
+  itr = meta.FindMember("xrefs");
+  if (itr != meta.MemberEnd())
+  {
+    const rapidjson::Value &xrefs = itr->value;
+    if (!xrefs.IsArray())
     {
-      const rapidjson::Value &synonyms = meta["synonyms"];
-      if (!synonyms.IsArray())
-      {
-        throw JsonParseException("Malformed node (" + id + "): synonyms not array");
-      }
-      for (auto &syno : synonyms.GetArray())
+      throw JsonParseException("Malformed node (" + id + "): Term Xrefs not array");
+    }
+    else
+    {
+      for (auto elem = xrefs.Begin(); elem != xrefs.End(); elem++)
       {
-        if (!syno.HasMember("pred"))
-        {
-          throw JsonParseException("Synonym required to have pred object (node:" + id + ")");
-        }
-        if (!syno.HasMember("val"))
+        auto elem_iter = elem->FindMember("val");
+        if (elem_iter != elem->MemberEnd())
         {
-          throw JsonParseException("Synonym required to have val object (node:" + id + ")");
+          add_json_xref(elem_iter->value, term, &Term::add_term_xref, index, errors);
         }
-        string pred = syno["pred"].GetString();
-        string val = syno["val"].GetString();
-        term.add_synonym(pred, val);
       }
     }
-    itr = meta.FindMember("basicPropertyValues");
-    if (itr != meta.MemberEnd())
+  }
+  if (meta.HasMember("synonyms"))
+  {
+    const rapidjson::Value &synonyms = meta["synonyms"];
+    if (!synonyms.IsArray())
+    {
+      throw JsonParseException("Malformed node (" + id + "): synonyms not array");
+    }
+    for (auto &syno : synonyms.GetArray())
     {
-      const rapidjson::Value &propertyVals = itr->value;
-      if (!propertyVals.IsArray())
+      if (!syno.HasMember("pred"))
       {
-        throw JsonParseException("Malformed node (" + id + "): Term property values not array");
+        throw JsonParseException("Synonym required to have pred object (node:" + id + ")");
       }
-      for (auto elem = propertyVals.Begin(); elem != propertyVals.End(); elem++)
+      if (!syno.HasMember("val"))
       {
-        PredicateValue propval = json_to_predicate_value(*elem);
-        term.add_predicate_value(propval);
+        throw JsonParseException("Synonym required to have val object (node:" + id + ")");
       }
+      string pred = syno["pred"].GetString();
+      string val = syno["val"].GetString();
+      term.add_synonym(pred, val);
     }
-    if (meta.HasMember("deprecated"))
+  }
+  itr = meta.FindMember("basicPropertyValues");
+  if (itr != meta.MemberEnd())
+  {
+    const rapidjson::Value &propertyVals = itr->value;
+    if (!propertyVals.IsArray())
     {
-      // assumption -- no need to check that deprecated: "true"
-      // this member is never used unless it is true.
-      term.set_obsolete(true);
+      throw JsonParseException("Malformed node (" + id + "): Term property values not array");
+    }
+    for (auto elem = propertyVals.Begin(); elem != propertyVals.End(); elem++)
+    {
+      PredicateValue propval = json_to_predicate_value(*elem);
+      if (lazy_fields_only && propval.is_alternate_id())
+      {
+        continue;
+      }
+      term.add_predicate_value(propval);
     }
   }
-  return term;
+  if (!lazy_fields_only && meta.HasMember("deprecated"))
+  {
+    // assumption -- no need to check that deprecated: "true"
+    // this member is never used unless it is true.
+    term.set_obsolete(true);
+  }
 }
 
 /**
@@ -488,7 +1609,7 @@ Term JsonOboParser::json_to_term(const rapidjson::Value &val)
  * an enum in the properties.h file.
  */
 Property
-JsonOboParser::json_to_property(const rapidjson::Value &val)
+JsonOboParser::json_to_property(const rapidjson::Value &val) const
 {
   string id;
   string label;
@@ -518,33 +1639,35 @@ JsonOboParser::json_to_property(const rapidjson::Value &val)
   return p;
 }
 
-Xref JsonOboParser::json_to_xref(const rapidjson::Value &val)
+void JsonOboParser::add_json_xref(const rapidjson::Value &val, Term &term, void (Term::*add)(const Xref &),
+                                  size_t index, OboParseErrorList &errors)
 {
-  if (val.IsString())
+  if (!val.IsString())
   {
-    string s = val.GetString();
-    int i = s.find("http");
-    if (i == string::npos)
-    {
-      TermId tid = TermId::from_string(val.GetString());
-      Xref xr{tid};
-      return xr;
-    }
-    else
-    {
-      // URL, s is a string like http://etc....
-      Xref xr = Xref::from_url(s);
-      return xr;
-    }
+    errors.add(ParseErrorCause::MALFORMED_XREF, index, OboParseError::UNKNOWN_OFFSET, "Could not construct Xref");
+    return;
+  }
+  std::string_view s{val.GetString(), val.GetStringLength()};
+  TermIdError error;
+  Xref xref = Xref::parse(s, error);
+  if (error == TermIdError::NONE)
+  {
+    (term.*add)(xref);
   }
   else
   {
-    throw JsonParseException("Could not construct Xref");
+    errors.add(ParseErrorCause::MALFORMED_XREF, index, OboParseError::UNKNOWN_OFFSET, TermId::error_message(error, s));
   }
 }
 
 vector<string>
 JsonOboParser::get_errors() const
 {
-  return error_list_;
+  vector<string> errors;
+  errors.reserve(error_list_.records().size());
+  for (const OboParseError &e : error_list_.records())
+  {
+    errors.push_back(format_error(e));
+  }
+  return errors;
 }
\ No newline at end of file
@@ -12,20 +12,115 @@
 #include <vector>
 #include <memory>
 #include <iostream>
+#include <functional>
 #include <rapidjson/document.h>
 #include "ontology.h"
+#include "ontologybuilder.h"
 #include "property.h"
+#include "mappedfile.h"
+#include "inputstream.h"
 
 using std::string;
 using std::vector;
 using std::unique_ptr;
 
+/**
+ * DOM parses the entire file into a rapidjson::Document and then walks it.
+ * STREAMING uses the rapidjson SAX Reader and creates terms, properties and
+ * edges while the file is being read, so that no Document is ever built.
+ */
+enum class JsonParseMode { DOM, STREAMING };
+
+/**
+ * The parts of each term that are built. Each profile includes the previous one;
+ * the edges, alternative ids and obsolete flags are always ingested.
+ * GRAPH_ONLY: term ids only (the labels are left empty).
+ * GRAPH_LABELS: plus the labels.
+ * GRAPH_LABELS_DATES: plus the creation dates (see Term::get_creation_date).
+ * FULL: plus definitions, xrefs, the other property values and synonyms.
+ */
+enum class LoadProfile { GRAPH_ONLY, GRAPH_LABELS, GRAPH_LABELS_DATES, FULL };
+
+/** Kinds of problems that are recorded while parsing (see OboParseError). */
+enum class ParseErrorCause {
+  MALFORMED_TERM,     // CLASS node that could not be converted to a Term
+  MISSING_META,       // CLASS node without meta element (warning, the term is kept)
+  MALFORMED_XREF,     // xref that could not be converted (the term is kept)
+  MALFORMED_PROPERTY, // PROPERTY node that could not be converted
+  UNKNOWN_NODE_TYPE,  // node that is neither CLASS nor PROPERTY
+  MALFORMED_EDGE      // edge that could not be converted
+};
+
+/**
+ * A problem found while parsing. Creating a record does not format any text; the message
+ * is put together only when the errors are output (see JsonOboParser::format_error).
+ */
+struct OboParseError {
+  /** Value of byte_offset if the position is not known (the DOM does not keep positions). */
+  static constexpr size_t UNKNOWN_OFFSET = static_cast<size_t>(-1);
+  ParseErrorCause cause;
+  /** Index of the node or edge in the nodes or edges array of the graph. */
+  size_t index;
+  /** Offset of the node or edge in the (uncompressed) input. */
+  size_t byte_offset;
+  /** Exception message or id of the element (may be empty). */
+  string detail;
+};
+
+/** Error records of which at most max_errors are retained; the remaining errors are only counted. */
+class OboParseErrorList {
+private:
+  vector<OboParseError> errors_;
+  size_t max_errors_;
+  size_t dropped_ = 0;
+
+public:
+  explicit OboParseErrorList(size_t max_errors) : max_errors_(max_errors) {}
+  void add(ParseErrorCause cause, size_t index, size_t byte_offset, const string &detail);
+  /** Append the errors of other (e.g., of a worker thread) after our own, respecting the cap. */
+  void append(OboParseErrorList &&other);
+  const vector<OboParseError> &records() const { return errors_; }
+  bool empty() const { return errors_.empty() && dropped_ == 0; }
+  /** @return number of errors found, including the ones that were not retained. */
+  size_t total() const { return errors_.size() + dropped_; }
+  size_t dropped() const { return dropped_; }
+};
+
+/** Options that control how JsonOboParser ingests an ontology file. */
+struct JsonOboOptions {
+	/** If true, skip edges where we do not have the corresponding term (this occurs for logical definitions). */
+	bool edge_lenient = true;
+	JsonParseMode mode = JsonParseMode::DOM;
+	/** If true, mmap the input file and let rapidjson parse it in situ (strings are not copied into the DOM).
+	    Ignored for gzip/zstd compressed files, which are always decompressed on a separate thread. */
+	bool memory_map = true;
+	/** Number of threads used to convert the nodes to Term objects in DOM mode and to look up
+	 * the vertices of the edges when the ontology is built (0: one per core). */
+	unsigned int threads = 1;
+	/** If true, the definition, xrefs, property values and synonyms of a term are only decoded from the
+	    (memory-mapped) file when they are first requested. Only the streaming parser defers them, and only for the
+	    FULL profile: the other profiles never build these fields, so they supersede lazy loading. Ignored in DOM
+	    mode, for compressed files and for every profile other than FULL. */
+	bool lazy_terms = false;
+	/** Meta elements that the profile does not need are skipped without being converted. */
+	LoadProfile profile = LoadProfile::FULL;
+	/** Maximum number of error records that are retained (further errors are only counted). */
+	size_t max_errors = 1000;
+};
+
+class JsonOboSaxHandler;
+class JsonMetaSource;
+
 class JsonOboParser {
 private:
+	friend class JsonOboSaxHandler;
+	friend class JsonMetaSource;
 	/** Path to the input JSON file. */
 	string path_;
 	/** The identifier of the ontology we are parsing. */
 	string ontology_id_;
+	/** The version IRI from the meta element of the ontology, if any. */
+	string ontology_version_;
 	/** List of all terms (classes) of the ontlogy we are parsing. */
 	vector<Term> term_list_;
 	/** List of all edges of the ontology we are parsing. */
@@ -34,34 +129,86 @@ private:
 	vector<PredicateValue> predicate_value_list_;
 
 	vector<Property> property_list_;
+	JsonOboOptions options_;
 	/** A list of errors, if any, encountered while parsing the input file.*/
-	vector<string> error_list_;
-	/** If true, skip edges where we do not have the corresponding term (this occurs for logical definitions). */
-	bool edge_lenient_;
+	OboParseErrorList error_list_;
+	/** Ingest the main (first) graph of a parsed DOM and the nodes and edges of all further graphs. */
+	void process_document(const rapidjson::Document &d);
 	void process_metadata(const rapidjson::Value &val);
+	/** Terms, properties and errors created from one block of nodes (or one imported graph) by one worker. */
+	struct NodeBatch {
+		vector<Term> terms;
+		vector<Property> properties;
+		/** Only used for imported graphs. */
+		vector<Edge> edges;
+		OboParseErrorList errors;
+		explicit NodeBatch(size_t max_errors) : errors(max_errors) {}
+	};
 	/** Ingest vertices from the JSON file */
 	void process_nodes(const rapidjson::Value& nodes);
+	void process_node_range(const rapidjson::Value &nodes,
+	                        rapidjson::SizeType begin,
+	                        rapidjson::SizeType end,
+	                        NodeBatch &batch) const;
 	/** Ingest edges from the JSON file */
-	void process_edges(const rapidjson::Value& edges);
+	static void process_edges(const rapidjson::Value& edges, vector<Edge> &edge_list, OboParseErrorList &errors);
+	/** Ingest the nodes and edges of graphs[1], graphs[2], ... concurrently. */
+	void process_imported_graphs(const rapidjson::Value &graphs);
+	void process_graph(const rapidjson::Value &graph, NodeBatch &batch) const;
 
 	void parse();
+	/** Map the input file; throws PhenopacketException if it cannot be opened. */
+	MappedFile map_input_file() const;
+	/** Open the (possibly gzip or zstd compressed) input file; throws PhenopacketException if it cannot be opened. */
+	std::unique_ptr<InputStream> open_input_file() const;
+	/** true if memory_map was requested and the input is not compressed. */
+	bool use_memory_map() const;
+	/** Build a rapidjson::Document and ingest its graphs. */
+	void parse_dom();
+	/** Ingest the graphs with the SAX interface (see JsonOboSaxHandler). */
+	void parse_streaming();
+	/** Throw JsonParseException with the rapidjson message and the offset if result is an error. */
+	void check_parse_result(const rapidjson::ParseResult &result) const;
 
-	PredicateValue json_to_predicate_value(const rapidjson::Value &val);
-	Property json_to_property(const rapidjson::Value &val);
-	Term json_to_term(const rapidjson::Value &val);
-	Xref json_to_xref(const rapidjson::Value &val);
+	static PredicateValue json_to_predicate_value(const rapidjson::Value &val);
+	Property json_to_property(const rapidjson::Value &val) const;
+	/** Convert the CLASS node with the given index; warnings are appended to errors. */
+	Term json_to_term(const rapidjson::Value &val, size_t index, OboParseErrorList &errors) const;
+	static void add_meta_to_term(const rapidjson::Value &meta,
+	                             Term &term,
+	                             const string &id,
+	                             size_t index,
+	                             OboParseErrorList &errors,
+	                             bool lazy_fields_only);
+	/** Add the alternative ids, the obsolete flag and (depending on the profile) the creation date to term. */
+	void add_profile_meta_to_term(const rapidjson::Value &meta, Term &term, const string &id) const;
+	/** @return true if pv is built before the rest of the meta element (profiles other than FULL, or lazy terms). */
+	bool is_early_property_value(const PredicateValue &pv) const;
+	/** Add the xref val to term with add, or record it in errors if it is malformed. */
+	static void add_json_xref(const rapidjson::Value &val, Term &term, void (Term::*add)(const Xref &),
+	                          size_t index, OboParseErrorList &errors);
+	/** Shared by the DOM and the streaming path. */
+	static PredicateValue make_predicate_value(std::string_view pred, std::string_view val);
 
 public:
 	JsonOboParser(const string &path);
 	JsonOboParser(const string &path, bool edge_lenient);
+	/** Parse the file at path; throws PhenopacketException if it cannot be opened. */
+	JsonOboParser(const string &path, const JsonOboOptions &options);
 	~JsonOboParser(){}
 	/** Transform the nodes and edges into an Ontology object
 			with CLR graph. When this method is called, the CTOR
-			has ingested data to the term_list and the edge_list.*/
+			has ingested data to the term_list and the edge_list.
+			The lists are moved into the Ontology, so this can only be called once. */
 	std::unique_ptr<Ontology> get_ontology();
+	/** Hand the parsed terms, edges and metadata over to a builder (used by get_ontology). */
+	OntologyBuilder release_builder();
 	/** Output the Q/C findings to an outstream (prints the error list). */
 	void output_quality_assessment(std::ostream& s = std::cout) const;
+	/** @return the formatted messages of the retained errors. */
 	vector<string> get_errors() const;
+	const OboParseErrorList &get_error_records() const { return error_list_; }
+	static string format_error(const OboParseError &error);
 };
 
 
@@ -0,0 +1,124 @@
+/**
+ * @file mappedfile.cc
+ * @brief Read-mostly memory mapping of an input file.
+ */
+#include "mappedfile.h"
+#include "myexception.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile(const string &path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw PhenopacketException("Could not open \"" + path + "\": " + std::strerror(errno));
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    string msg = std::strerror(errno);
+    close(fd);
+    throw PhenopacketException("Could not stat \"" + path + "\": " + msg);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  long page_size = sysconf(_SC_PAGESIZE);
+  // The bytes between the end of the file and the end of the last page are zero-filled,
+  // so if the file does not end exactly on a page boundary, the mapping is NUL-terminated.
+  if (size_ > 0 && page_size > 0 && size_ % static_cast<size_t>(page_size) != 0)
+  {
+    void *addr = mmap(nullptr, size_ + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED)
+    {
+      madvise(addr, size_ + 1, MADV_SEQUENTIAL);
+      data_ = static_cast<char *>(addr);
+      mapped_length_ = size_ + 1;
+      close(fd);
+      return;
+    }
+  }
+  buffer_.resize(size_ + 1);
+  size_t n = 0;
+  while (n < size_)
+  {
+    ssize_t r = read(fd, buffer_.data() + n, size_ - n);
+    if (r < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (r <= 0)
+    {
+      close(fd);
+      throw PhenopacketException("Could not read \"" + path + "\"");
+    }
+    n += static_cast<size_t>(r);
+  }
+  close(fd);
+  buffer_[size_] = '\0';
+  data_ = buffer_.data();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept : data_(other.data_),
+                                                      size_(other.size_),
+                                                      mapped_length_(other.mapped_length_),
+                                                      buffer_(std::move(other.buffer_))
+{
+  if (mapped_length_ == 0)
+  {
+    data_ = buffer_.data();
+  }
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.mapped_length_ = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    data_ = other.data_;
+    size_ = other.size_;
+    mapped_length_ = other.mapped_length_;
+    buffer_ = std::move(other.buffer_);
+    if (mapped_length_ == 0)
+    {
+      data_ = buffer_.data();
+    }
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.mapped_length_ = 0;
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile()
+{
+  release();
+}
+
+void MappedFile::release()
+{
+  if (mapped_length_ > 0 && data_ != nullptr)
+  {
+    munmap(data_, mapped_length_);
+  }
+  data_ = nullptr;
+  mapped_length_ = 0;
+  buffer_.clear();
+}
+
+void MappedFile::drop_resident_pages()
+{
+  if (mapped_length_ > 0 && data_ != nullptr)
+  {
+    // clean pages of a private file mapping are simply read in again on the next access
+    madvise(data_, mapped_length_, MADV_DONTNEED);
+    madvise(data_, mapped_length_, MADV_RANDOM);
+  }
+}
@@ -0,0 +1,50 @@
+/**
+ * @file mappedfile.h
+ * @brief Read-mostly memory mapping of an input file.
+ * @author Peter N Robinson
+ *
+ * The file is mapped copy-on-write (MAP_PRIVATE), so that rapidjson can parse it
+ * in situ: decoded strings are written back into the mapping without touching the
+ * file on disk, and pages that are only read are never copied. The buffer is always
+ * followed by a NUL byte, as required by rapidjson::InsituStringStream.
+ */
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+
+using std::string;
+
+class MappedFile {
+private:
+  char *data_ = nullptr;
+  /** Size of the file in bytes (excluding the terminating NUL). */
+  size_t size_ = 0;
+  /** Number of bytes mapped, zero if we had to fall back to reading the file. */
+  size_t mapped_length_ = 0;
+  /** Used if the file size is a multiple of the page size (no room for the NUL) or is zero. */
+  std::vector<char> buffer_;
+  void release();
+
+public:
+  /** Map the file at path; throws PhenopacketException if it cannot be opened. */
+  explicit MappedFile(const string &path);
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+  char *data() { return data_; }
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+  bool is_mapped() const { return mapped_length_ > 0; }
+  /**
+   * Release the physical pages of the mapping after a sequential pass, and expect
+   * random access from now on. Must not be called once the buffer has been modified
+   * (e.g., by in situ parsing), because modified pages would be discarded.
+   */
+  void drop_resident_pages();
+};
+
+#endif
@@ -0,0 +1,560 @@
+/**
+ * @file oboparser.cc
+ * @brief Parse ontologies in the OBO flat file format (.obo).
+ */
+#include "oboparser.h"
+#include "mappedfile.h"
+#include "inputstream.h"
+#include "myexception.h"
+#include "staticregistry.h"
+
+#include <cstring>
+#include <sstream>
+#include <iterator>
+
+namespace {
+/** Prefix of the ontology id and version IRIs. */
+const string OBO_PURL = "http://purl.obolibrary.org/obo/";
+
+bool is_blank(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+string_view trim(string_view s)
+{
+  size_t b = 0;
+  while (b < s.size() && is_blank(s[b]))
+  {
+    ++b;
+  }
+  size_t e = s.size();
+  while (e > b && is_blank(s[e - 1]))
+  {
+    --e;
+  }
+  return s.substr(b, e - b);
+}
+
+/** @return the first whitespace-delimited token of s; rest is set to what follows it. */
+string_view next_token(string_view s, string_view &rest)
+{
+  s = trim(s);
+  size_t e = 0;
+  while (e < s.size() && !is_blank(s[e]))
+  {
+    ++e;
+  }
+  rest = trim(s.substr(e));
+  return s.substr(0, e);
+}
+
+/**
+ * Read the quoted string at the beginning of s (e.g., the text of def and synonym tags)
+ * and resolve the escapes. rest is set to what follows the closing quote.
+ */
+bool quoted_string(string_view s, string &out, string_view &rest)
+{
+  s = trim(s);
+  if (s.empty() || s[0] != '"')
+  {
+    return false;
+  }
+  out.clear();
+  for (size_t i = 1; i < s.size(); ++i)
+  {
+    char c = s[i];
+    if (c == '\\' && i + 1 < s.size())
+    {
+      char n = s[++i];
+      out.push_back(n == 'n' ? '\n' : n == 't' ? '\t' : n);
+    }
+    else if (c == '"')
+    {
+      rest = trim(s.substr(i + 1));
+      return true;
+    }
+    else
+    {
+      out.push_back(c);
+    }
+  }
+  return false;
+}
+
+/** @return the comma-separated entries of the bracketed list at the beginning of s, e.g., [PMID:1, ISBN:2]. */
+vector<string_view> bracket_list(string_view s)
+{
+  vector<string_view> entries;
+  s = trim(s);
+  if (s.empty() || s[0] != '[')
+  {
+    return entries;
+  }
+  size_t close = s.find(']');
+  if (close == string_view::npos)
+  {
+    return entries;
+  }
+  string_view list = s.substr(1, close - 1);
+  while (!list.empty())
+  {
+    size_t comma = list.find(',');
+    string_view rest;
+    // an entry may be followed by a description in quotes
+    string_view entry = next_token(list.substr(0, comma), rest);
+    if (!entry.empty())
+    {
+      entries.push_back(entry);
+    }
+    if (comma == string_view::npos)
+    {
+      break;
+    }
+    list = list.substr(comma + 1);
+  }
+  return entries;
+}
+
+/**
+ * Predicates of property_value tags are URLs (http://purl.org/dc/elements/1.1/creator)
+ * or CURIEs (IAO:0000700); both are reduced to the key of the predicate registry.
+ */
+PredicateValue make_predicate_value(string_view predicate, const string &value)
+{
+  string_view pred = strip_iri(predicate);
+  size_t pos;
+  if (pred.size() == predicate.size() && (pos = pred.find(':')) != string_view::npos)
+  {
+    string key{pred};
+    key[pos] = '_';
+    return PredicateValue{PredicateValue::string_to_predicate(key), value};
+  }
+  return PredicateValue{PredicateValue::string_to_predicate(pred), value};
+}
+
+/** Value of a property_value tag: either a quoted literal followed by its datatype, or a CURIE. */
+string property_value_value(string_view s)
+{
+  string value;
+  string_view rest;
+  if (quoted_string(s, value, rest))
+  {
+    return value;
+  }
+  return string{next_token(s, rest)};
+}
+}
+
+OboParser::OboParser(const string &path) : path_(path),
+                                           error_list_(options_.max_errors)
+{
+  parse();
+}
+
+OboParser::OboParser(const string &path, const OboOptions &options) : path_(path),
+                                                                      options_(options),
+                                                                      error_list_(options.max_errors)
+{
+  parse();
+}
+
+bool OboParser::is_obo_file(const string &path)
+{
+  for (const char *suffix : {".obo", ".obo.gz", ".obo.zst"})
+  {
+    size_t n = strlen(suffix);
+    if (path.size() >= n && path.compare(path.size() - n, n, suffix) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void OboParser::parse()
+{
+  std::cout << "[INFO] Parsing " << path_ << "\n";
+  try
+  {
+    if (detect_compression(path_) == Compression::NONE)
+    {
+      MappedFile input{path_};
+      parse_buffer(input.data(), input.size());
+    }
+    else
+    {
+      // compressed files cannot be mapped; the decompressed text is scanned in the same way
+      std::unique_ptr<InputStream> in = open_input_stream(path_);
+      string text{std::istreambuf_iterator<char>(*in), std::istreambuf_iterator<char>()};
+      if (!in->get_error().empty())
+      {
+        throw PhenopacketException(in->get_error());
+      }
+      parse_buffer(text.data(), text.size());
+    }
+  }
+  catch (const PhenopacketException &e)
+  {
+    throw PhenopacketException("Could not read OBO ontology file \"" + path_ + "\": " + e.what());
+  }
+}
+
+/**
+ * The header tags come before the first stanza. The tags of each [Term] stanza are
+ * collected as views into the buffer and converted when the next stanza begins, so that
+ * the id and name are known before the Term is created, whatever the order of the tags.
+ */
+void OboParser::parse_buffer(const char *data, size_t size)
+{
+  enum class Stanza { HEADER, TERM, OTHER };
+  Stanza stanza = Stanza::HEADER;
+  size_t n_terms = 0;
+  size_t pos = 0;
+  while (pos < size)
+  {
+    const char *newline = static_cast<const char *>(memchr(data + pos, '\n', size - pos));
+    size_t end = newline != nullptr ? newline - data : size;
+    size_t line_offset = pos;
+    string_view line = trim(string_view{data + pos, end - pos});
+    pos = end + 1;
+    if (line.empty() || line[0] == '!')
+    {
+      continue;
+    }
+    if (line[0] == '[')
+    {
+      if (stanza == Stanza::TERM)
+      {
+        process_term_stanza();
+      }
+      stanza = line == "[Term]" ? Stanza::TERM : Stanza::OTHER;
+      if (stanza == Stanza::TERM)
+      {
+        stanza_index_ = n_terms++;
+        stanza_offset_ = line_offset;
+        stanza_tags_.clear();
+      }
+      continue;
+    }
+    size_t colon = line.find(':');
+    if (colon == string_view::npos)
+    {
+      continue;
+    }
+    string_view tag = line.substr(0, colon);
+    string_view value = trim(line.substr(colon + 1));
+    if (stanza == Stanza::HEADER)
+    {
+      process_header_tag(tag, value);
+    }
+    else if (stanza == Stanza::TERM)
+    {
+      stanza_tags_.emplace_back(tag, value);
+    }
+  }
+  if (stanza == Stanza::TERM)
+  {
+    process_term_stanza();
+  }
+  // the ontology tag may follow the subsetdef and synonymtypedef tags, so resolve them at the end
+  string ontology_name = ontology_id_.substr(std::min(ontology_id_.size(), OBO_PURL.size()));
+  ontology_name = ontology_name.substr(0, ontology_name.find('.'));
+  for (size_t i = 0; i < header_properties_.size(); ++i)
+  {
+    const std::pair<string_view, string> &p = header_properties_[i];
+    // e.g., synonymtypedef: layperson "layperson term", subsetdef: hposlim_core "Core clinical terminology"
+    string candidates[] = {p.second, ontology_name + "#" + string{p.first}, ontology_name + ".owl#" + string{p.first}, string{p.first}};
+    bool found = false;
+    for (const string &c : candidates)
+    {
+      try
+      {
+        property_list_.emplace_back(Property::id_to_property(c));
+        found = true;
+        break;
+      }
+      catch (const PhenopacketException &)
+      {
+      }
+    }
+    if (!found)
+    {
+      error_list_.add(ParseErrorCause::MALFORMED_PROPERTY, i, OboParseError::UNKNOWN_OFFSET,
+                      "Unrecognized property: " + string{p.first});
+    }
+  }
+  header_properties_.clear();
+  stanza_tags_.clear();
+  std::cout << "[INFO] Done parsing OBO file: terms: n=" << term_list_.size()
+            << ", edges: n=" << edge_list_.size() << "\n";
+}
+
+void OboParser::process_header_tag(string_view tag, string_view value)
+{
+  string_view rest;
+  if (tag == "ontology")
+  {
+    ontology_id_ = OBO_PURL + string{value} + ".obo";
+  }
+  else if (tag == "data-version")
+  {
+    // hp/releases/2019-09-06 -> http://purl.obolibrary.org/obo/hp/releases/2019-09-06
+    ontology_version_ = value.find('/') != string_view::npos ? OBO_PURL + string{value} : string{value};
+  }
+  else if (tag == "subsetdef" || tag == "synonymtypedef")
+  {
+    string_view name = next_token(value, rest);
+    string description;
+    quoted_string(rest, description, rest);
+    header_properties_.emplace_back(name, description);
+  }
+  else if (tag == "property_value")
+  {
+    string_view predicate = next_token(value, rest);
+    predicate_value_list_.push_back(make_predicate_value(predicate, property_value_value(rest)));
+  }
+  else if (tag == "format-version")
+  {
+    predicate_value_list_.emplace_back(Predicate::HAS_OBO_FORMAT_VERSION, string{value});
+  }
+  else if (tag == "default-namespace")
+  {
+    predicate_value_list_.emplace_back(Predicate::DEFAULT_NAMESPACE, string{value});
+  }
+  else if (tag == "saved-by")
+  {
+    predicate_value_list_.emplace_back(Predicate::SAVED_BY, string{value});
+  }
+  else if (tag == "logical-definition-view-relation")
+  {
+    predicate_value_list_.emplace_back(Predicate::LOGICAL_DEFINITION_VIEW_RELATION, string{value});
+  }
+  else if (tag == "remark")
+  {
+    predicate_value_list_.emplace_back(Predicate::RDF_SCHEMA_COMMENT, string{value});
+  }
+}
+
+bool OboParser::profile_uses_tag(string_view tag) const
+{
+  if (tag == "alt_id" || tag == "is_obsolete" || tag == "is_a" || tag == "relationship")
+  {
+    return true;
+  }
+  switch (options_.profile)
+  {
+  case LoadProfile::GRAPH_ONLY:
+  case LoadProfile::GRAPH_LABELS:
+    return false;
+  case LoadProfile::GRAPH_LABELS_DATES:
+    return tag == "creation_date";
+  case LoadProfile::FULL:
+    return true;
+  }
+  return true;
+}
+
+void OboParser::process_term_stanza()
+{
+  string_view id;
+  string_view name;
+  for (const auto &t : stanza_tags_)
+  {
+    if (t.first == "id")
+    {
+      id = t.second;
+    }
+    else if (t.first == "name")
+    {
+      name = t.second;
+    }
+  }
+  if (id.empty())
+  {
+    error_list_.add(ParseErrorCause::MALFORMED_TERM, stanza_index_, stanza_offset_, "[Term] stanza without id");
+    return;
+  }
+  if (name.empty())
+  {
+    error_list_.add(ParseErrorCause::MALFORMED_TERM, stanza_index_, stanza_offset_,
+                    "Malformed node (" + string{id} + "): no label.");
+    return;
+  }
+  try
+  {
+    TermId tid = TermId::from_string(id);
+    Term term{tid, options_.profile == LoadProfile::GRAPH_ONLY ? string_view() : name};
+    for (const auto &t : stanza_tags_)
+    {
+      if (profile_uses_tag(t.first))
+      {
+        add_tag_to_term(term, tid, t.first, t.second);
+      }
+    }
+    term_list_.push_back(std::move(term));
+  }
+  catch (const PhenopacketException &e)
+  {
+    error_list_.add(ParseErrorCause::MALFORMED_TERM, stanza_index_, stanza_offset_, e.what());
+  }
+}
+
+void OboParser::add_tag_to_term(Term &term, const TermId &tid, string_view tag, string_view value)
+{
+  string_view rest;
+  if (tag == "is_a" || tag == "relationship")
+  {
+    try
+    {
+      EdgeType et = EdgeType::IS_A;
+      if (tag == "relationship")
+      {
+        et = Edge::obo_relation_to_edgetype(string{next_token(value, value)});
+      }
+      TermId parent = TermId::from_string(next_token(value, rest));
+      edge_list_.push_back(Edge::of(tid, et, parent));
+    }
+    catch (const PhenopacketException &e)
+    {
+      error_list_.add(ParseErrorCause::MALFORMED_EDGE, stanza_index_, stanza_offset_,
+                      tid.get_value() + " " + string{tag} + ": " + e.what());
+    }
+  }
+  else if (tag == "alt_id")
+  {
+    term.add_predicate_value(PredicateValue{Predicate::HAS_ALTERNATIVE_ID, next_token(value, rest)});
+  }
+  else if (tag == "is_obsolete")
+  {
+    term.set_obsolete(value == "true");
+  }
+  else if (tag == "def")
+  {
+    string definition;
+    if (quoted_string(value, definition, rest))
+    {
+      term.add_definition(definition);
+      TermIdError error;
+      for (string_view x : bracket_list(rest))
+      {
+        Xref xref = Xref::parse(x, error);
+        if (error == TermIdError::NONE)
+        {
+          term.add_definition_xref(xref);
+        }
+        else
+        {
+          error_list_.add(ParseErrorCause::MALFORMED_XREF, stanza_index_, stanza_offset_, TermId::error_message(error, x));
+        }
+      }
+    }
+  }
+  else if (tag == "xref")
+  {
+    string_view x = next_token(value, rest);
+    TermIdError error;
+    Xref xref = Xref::parse(x, error);
+    if (error == TermIdError::NONE)
+    {
+      term.add_term_xref(xref);
+    }
+    else
+    {
+      error_list_.add(ParseErrorCause::MALFORMED_XREF, stanza_index_, stanza_offset_, TermId::error_message(error, x));
+    }
+  }
+  else if (tag == "synonym")
+  {
+    // synonym: "Abnormal shape of thyroid gland" EXACT layperson [ORCID:0000-0001-5208-3432]
+    string label;
+    if (quoted_string(value, label, rest))
+    {
+      string_view scope = next_token(rest, rest);
+      string pred = scope == "BROAD" ? "hasBroadSynonym" : scope == "NARROW" ? "hasNarrowSynonym"
+                                                       : scope == "RELATED" ? "hasRelatedSynonym"
+                                                                            : "hasExactSynonym";
+      term.add_synonym(pred, label);
+    }
+  }
+  else if (tag == "creation_date")
+  {
+    term.add_predicate_value(PredicateValue{Predicate::CREATION_DATE, value});
+  }
+  else if (tag == "created_by")
+  {
+    term.add_predicate_value(PredicateValue{Predicate::CREATED_BY, value});
+  }
+  else if (tag == "namespace")
+  {
+    term.add_predicate_value(PredicateValue{Predicate::HAS_OBO_NAMESPACE, value});
+  }
+  else if (tag == "comment")
+  {
+    term.add_predicate_value(PredicateValue{Predicate::RDF_SCHEMA_COMMENT, value});
+  }
+  else if (tag == "consider")
+  {
+    term.add_predicate_value(PredicateValue{Predicate::CONSIDER, next_token(value, rest)});
+  }
+  else if (tag == "replaced_by")
+  {
+    term.add_predicate_value(PredicateValue{Predicate::TERM_REPLACED_BY, next_token(value, rest)});
+  }
+  else if (tag == "property_value")
+  {
+    string_view predicate = next_token(value, rest);
+    term.add_predicate_value(make_predicate_value(predicate, property_value_value(rest)));
+  }
+}
+
+std::unique_ptr<Ontology>
+OboParser::get_ontology()
+{
+  return release_builder().build();
+}
+
+OntologyBuilder
+OboParser::release_builder()
+{
+  OntologyBuilder builder{ontology_id_};
+  builder.set_version(ontology_version_)
+      .set_terms(std::move(term_list_))
+      .set_edges(std::move(edge_list_))
+      .set_predicate_values(std::move(predicate_value_list_))
+      .set_properties(std::move(property_list_))
+      .set_edge_lenient(options_.edge_lenient)
+      .set_threads(options_.threads);
+  return builder;
+}
+
+void OboParser::output_quality_assessment(std::ostream &ost) const
+{
+  if (error_list_.empty())
+  {
+    ost << "[INFO] No errors enounted in OBO parse\n";
+    return;
+  }
+  ost << "[ERRORS]:\n";
+  for (const string &e : get_errors())
+  {
+    ost << e << "\n";
+  }
+  if (error_list_.dropped() > 0)
+  {
+    ost << "[INFO] " << error_list_.dropped() << " further errors were not retained (total: "
+        << error_list_.total() << ")\n";
+  }
+}
+
+vector<string>
+OboParser::get_errors() const
+{
+  vector<string> errors;
+  errors.reserve(error_list_.records().size());
+  for (const OboParseError &e : error_list_.records())
+  {
+    errors.push_back(JsonOboParser::format_error(e));
+  }
+  return errors;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file oboparser.h
+ * @brief Parse ontologies in the OBO flat file format (.obo).
+ * @author Peter N Robinson
+ *
+ * Some ontologies (e.g., older releases of MONDO and ECTO) are only available as .obo
+ * files. OboParser reads them line by line and produces the same terms, edges, property
+ * values and properties as JsonOboParser, so that the Ontology is built in the same way.
+ * The file is memory-mapped and scanned in place: tags and values are views into the
+ * mapping, and strings are only created for the fields that end up in a Term.
+ *
+ * Only [Term] stanzas are ingested ([Typedef] and [Instance] stanzas are skipped). The
+ * is_a and relationship tags become edges; intersection_of, union_of and disjoint_from
+ * (the logical definitions) are not used, as for OBO-JSON.
+ */
+#ifndef OBOPARSER_H
+#define OBOPARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <iostream>
+
+#include "ontology.h"
+#include "ontologybuilder.h"
+#include "jsonobo.h"
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+/** Options that control how OboParser ingests an ontology file (see JsonOboOptions). */
+struct OboOptions {
+	/** If true, skip edges where we do not have the corresponding term. */
+	bool edge_lenient = true;
+	/** Tags that the profile does not need are skipped without being converted. */
+	LoadProfile profile = LoadProfile::FULL;
+	/** Number of threads used to look up the vertices of the edges when the ontology is built (0: one per core). */
+	unsigned int threads = 1;
+	/** Maximum number of error records that are retained (further errors are only counted). */
+	size_t max_errors = 1000;
+};
+
+class OboParser {
+private:
+	/** Path to the input .obo file. */
+	string path_;
+	/** Built from the ontology header tag, e.g., http://purl.obolibrary.org/obo/hp.obo */
+	string ontology_id_;
+	/** Built from the data-version header tag, e.g., http://purl.obolibrary.org/obo/hp/releases/2019-09-06 */
+	string ontology_version_;
+	vector<Term> term_list_;
+	vector<Edge> edge_list_;
+	vector<PredicateValue> predicate_value_list_;
+	vector<Property> property_list_;
+	OboOptions options_;
+	/** Errors are recorded in the same way as by JsonOboParser; index is the number of the [Term] stanza. */
+	OboParseErrorList error_list_;
+	/** Tag/value pairs of the current stanza; views into the input buffer. */
+	vector<std::pair<string_view, string_view>> stanza_tags_;
+	/** Name and description of the subsetdef and synonymtypedef header tags, resolved to Property objects at the end. */
+	vector<std::pair<string_view, string>> header_properties_;
+	/** Number and byte offset of the current [Term] stanza. */
+	size_t stanza_index_ = 0;
+	size_t stanza_offset_ = 0;
+
+	void parse();
+	/** Scan the buffer line by line; the buffer must remain valid until the parse is complete. */
+	void parse_buffer(const char *data, size_t size);
+	void process_header_tag(string_view tag, string_view value);
+	/** Convert the collected tags of a [Term] stanza to a Term and its edges. */
+	void process_term_stanza();
+	void add_tag_to_term(Term &term, const TermId &tid, string_view tag, string_view value);
+	/** @return true if the term tag is built for the profile of the options. */
+	bool profile_uses_tag(string_view tag) const;
+
+public:
+	OboParser(const string &path);
+	/** Parse the file at path; throws PhenopacketException if it cannot be read. */
+	OboParser(const string &path, const OboOptions &options);
+	~OboParser(){}
+	/** Transform the terms and edges into an Ontology object. The lists are moved into the Ontology,
+	    so this can only be called once. */
+	std::unique_ptr<Ontology> get_ontology();
+	/** Hand the parsed terms, edges and metadata over to a builder (used by get_ontology). */
+	OntologyBuilder release_builder();
+	/** Output the Q/C findings to an outstream (prints the error list). */
+	void output_quality_assessment(std::ostream& s = std::cout) const;
+	/** @return the formatted messages of the retained errors. */
+	vector<string> get_errors() const;
+	const OboParseErrorList &get_error_records() const { return error_list_; }
+	/** @return true if path names an OBO flat file (.obo, optionally gzip or zstd compressed). */
+	static bool is_obo_file(const string &path);
+};
+
+#endif
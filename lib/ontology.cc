@@ -6,11 +6,18 @@
  */
 
 #include "ontology.h"
+#include "ontologybuilder.h"
+#include "myexception.h"
 #include <iostream>
 #include <utility> // make_pair
 #include <algorithm> // sort
 #include <stack>
 #include <sstream>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <iterator> // back_inserter
 
 
 using std::cerr;
@@ -22,42 +29,85 @@ using std::unique_ptr;
 
 
 
-Xref::Xref(const Xref &txr):
-  term_id_( txr.term_id_)
+namespace {
+/**
+ * The URLs of all Xrefs, referred to by their index. The strings are interned in the
+ * StringArena; the table only maps them to indices, so that an Xref fits in 64 bits.
+ * URLs are never removed. The parsers create Xrefs on several threads, hence the lock.
+ */
+class UrlTable {
+private:
+  mutable std::shared_mutex mutex_;
+  vector<std::string_view> urls_;
+  std::unordered_map<std::string_view, uint64_t> index_;
+
+public:
+  uint64_t intern(std::string_view url)
+  {
+    url = StringArena::global().intern(url);
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto p = index_.find(url);
+      if (p != index_.end()) {
+        return p->second;
+      }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto p = index_.emplace(url, urls_.size());
+    if (p.second) {
+      urls_.push_back(url);
+    }
+    return p.first->second;
+  }
+  std::string_view get(uint64_t i) const
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return urls_[i];
+  }
+};
+
+UrlTable &url_table()
 {
+  static UrlTable table;
+  return table;
+}
 }
 
-Xref::Xref():
-term_id_(EMPTY_TERMID)
+Xref
+Xref::from_url(std::string_view url)
 {
+  return Xref{URL_TAG | url_table().intern(url)};
 }
 
 Xref
-Xref::from_url(const string& url)
+Xref::parse(std::string_view s, TermIdError &error)
 {
-  Xref xref{};
-  xref.url_ = url;
-  return xref;
+  if (s.find("http") != std::string_view::npos) {
+    error = TermIdError::NONE;
+    return from_url(s);
+  }
+  TermIdResult r = TermId::parse(s);
+  error = r.error;
+  return Xref{r.value};
 }
 
-Xref &
-Xref::operator=(const Xref &txr) {
- term_id_ = txr.term_id_;
- url_ = txr.url_;
- return *this;
+std::string_view
+Xref::url() const
+{
+  return is_url() ? url_table().get(code_ & ~URL_TAG) : std::string_view();
 }
 
 std::ostream& operator<<(std::ostream& ost, const Xref& txref){
-  if (txref.term_id_ != EMPTY_TERMID) {
-    ost << txref.term_id_;
+  if (txref.is_url()) {
+    ost << txref.url();
   } else {
-    ost << txref.url_;
+    ost << txref.termid();
   }
  return ost;
 }
 
-Synonym::Synonym(const string &typ, const string &lbl):
-  label_(lbl)
+Synonym::Synonym(const string &typ, std::string_view lbl):
+  label_(StringArena::global().intern(lbl))
 {
   if (typ=="hasExactSynonym") {
     stype_ = SynonymType::EXACT;
@@ -90,14 +140,42 @@ operator<<(std::ostream& ost, const Synonym& synonym)
 }
 
 
-Term::Term(const TermId &id, const string &label):
-  id_(id),label_(label) {}
+Term::Term(const TermId &id, std::string_view label):
+  id_(id),label_(StringArena::global().intern(label)) {}
 
 
 
 void
-Term::add_definition(const string &def) {
-  definition_.assign(def);
+Term::set_lazy_source(std::shared_ptr<const LazyTermSource> source, size_t begin, size_t end)
+{
+  lazy_source_ = std::move(source);
+  lazy_begin_ = begin;
+  lazy_end_ = end;
+}
+
+void
+Term::decode_lazy_fields() const
+{
+  // reset first, so that the source may use the public add_ functions
+  std::shared_ptr<const LazyTermSource> source = std::move(lazy_source_);
+  lazy_source_.reset();
+  try {
+    source->materialize(const_cast<Term&>(*this), lazy_begin_, lazy_end_);
+  } catch (const PhenopacketException &) {
+    // drop what was decoded and keep the source, so that the next access fails as well
+    definition_ = std::string_view();
+    definition_xref_list_.clear();
+    term_xref_list_.clear();
+    property_values_.clear();
+    synonym_list_.clear();
+    lazy_source_ = std::move(source);
+    throw;
+  }
+}
+
+void
+Term::add_definition(std::string_view def, bool intern) {
+  definition_ = intern ? StringArena::global().intern(def) : StringArena::global().store(def);
 }
 
 void
@@ -112,7 +190,7 @@ Term::add_definition_xref(const Xref &txref){
 void
 Term::add_predicate_value(const PredicateValue &pv){
   if (pv.is_alternate_id()){
-    TermId alt_id = TermId::from_string(pv.get_value());
+    TermId alt_id = TermId::from_string(pv.value());
     alternative_id_list_.push_back(alt_id);
   } else {
     property_values_.push_back(pv);
@@ -120,12 +198,13 @@ Term::add_predicate_value(const PredicateValue &pv){
 }
 
 void
-Term::add_synonym(const string &pred, const string &lbl)
+Term::add_synonym(const string &pred, std::string_view lbl)
 {
   synonym_list_.emplace_back(Synonym(pred,lbl));
 }
 
 std::ostream& operator<<(std::ostream& ost, const Term& term){
+  term.materialize();
   ost << term.label_ << " [" << term.id_ << "]\n";
   ost << "def: " << (term.definition_.empty() ? "n/a":term.definition_) << "\n";
    if (term.is_obsolete_) {
@@ -157,35 +236,32 @@ std::ostream& operator<<(std::ostream& ost, const Term& term){
 }
 
  bool 
- Term::contains_xref_with_prefix(const string &prefix) const
+ Term::contains_xref_with_prefix(std::string_view prefix) const
  {
-   for (Xref xr : term_xref_list_) {
-     if (xr.get_termid().get_prefix() == prefix) {
-       return true;
-     }
-   }
-   return false;
+   return TermView::contains_xref_with_prefix(TermRange<Xref>(term_xrefs()), prefix);
  }
 
- tm
- Term::get_creation_date() const{
-    tm time = {}; // value initialize to zero
-    time.tm_year = 108; // 2008
-    int y,M,d,h,m;
-    float s; 
-    for (PredicateValue pv : property_values_) {
+ /**
+  * @return the creation date (CREATION_DATE or DATE property, e.g., 2012-04-22T04:38:20Z),
+  * or an empty date if there is none.
+  */
+ static CivilDate
+ parse_creation_date(const vector<PredicateValue> &property_values)
+ {
+    for (const PredicateValue &pv : property_values) {
         if (pv.get_property() == Predicate::CREATION_DATE || pv.get_property() == Predicate::DATE) {
           // assumption (not checked) there is only one such property per term
-            string val = pv.get_value();
-            sscanf(val.c_str(), "%d-%d-%dT%d:%d:%fZ", &y, &M, &d, &h, &m, &s);
-            time.tm_year = y - 1900; // Year since 1900
-            time.tm_mon = M - 1;     // 0-11
-            time.tm_mday = d;  
-            // disregard anything outside of y/m/d
-            break;
+          return CivilDate::parse(pv.value());
         }
-    }                   
-   return time;
+    }
+    return CivilDate();
+ }
+
+ CivilDate
+ Term::get_creation_date() const{
+    materialize();
+    CivilDate date = parse_creation_date(property_values_);
+    return date.empty() ? DEFAULT_CREATION_DATE : date;
  }
 
 /**
@@ -202,6 +278,284 @@ std::ostream& operator<<(std::ostream& ost, const Term& term){
 
 
 
+void
+TermStore::reserve(size_t n)
+{
+  ids_.reserve(n);
+  labels_.reserve(n);
+  obsolete_.reserve(n);
+  creation_dates_.reserve(n);
+  alternative_id_offsets_.reserve(n + 1);
+  definitions_.reserve(n);
+  definition_xref_offsets_.reserve(n + 1);
+  term_xref_offsets_.reserve(n + 1);
+  property_value_offsets_.reserve(n + 1);
+  synonym_offsets_.reserve(n + 1);
+}
+
+void
+TermStore::reserve(const vector<Term*> &terms)
+{
+  reserve(ids_.size() + terms.size());
+  size_t alternative_ids = 0, definition_xrefs = 0;
+  size_t term_xrefs = 0, property_values = 0, synonyms = 0;
+  for (const Term *t : terms) {
+    alternative_ids += t->alternative_id_list_.size();
+    definition_xrefs += t->definition_xref_list_.size();
+    term_xrefs += t->term_xref_list_.size();
+    property_values += t->property_values_.size();
+    synonyms += t->synonym_list_.size();
+  }
+  alternative_ids_.reserve(alternative_ids_.size() + alternative_ids);
+  definition_xrefs_.reserve(definition_xrefs_.size() + definition_xrefs);
+  term_xrefs_.reserve(term_xrefs_.size() + term_xrefs);
+  property_values_.reserve(property_values_.size() + property_values);
+  synonyms_.reserve(synonyms_.size() + synonyms);
+}
+
+/**
+ * The strings and lists of the term are appended to the pools. A lazily loaded term keeps
+ * its byte range instead, unless it comes from a different source than the terms before
+ * it (this does not happen with our parsers), in which case it is decoded now.
+ */
+int
+TermStore::append(Term &&term)
+{
+  int i = static_cast<int>(ids_.size());
+  ids_.push_back(term.id_);
+  labels_.push_back(term.label_);
+  obsolete_.push_back(term.is_obsolete_);
+  alternative_ids_.insert(alternative_ids_.end(), term.alternative_id_list_.begin(), term.alternative_id_list_.end());
+  alternative_id_offsets_.push_back(alternative_ids_.size());
+  if (term.lazy_source_ && (! lazy_source_ || lazy_source_ == term.lazy_source_)) {
+    lazy_source_ = term.lazy_source_;
+    lazy_ranges_.resize(i);
+    lazy_ranges_.emplace_back(term.lazy_begin_, term.lazy_end_);
+    // the creation date is a property value, which has not been decoded
+    creation_dates_.emplace_back();
+    definitions_.emplace_back();
+  } else {
+    term.materialize();
+    creation_dates_.push_back(parse_creation_date(term.property_values_));
+    definitions_.push_back(term.definition_);
+    std::move(term.definition_xref_list_.begin(), term.definition_xref_list_.end(), std::back_inserter(definition_xrefs_));
+    std::move(term.term_xref_list_.begin(), term.term_xref_list_.end(), std::back_inserter(term_xrefs_));
+    std::move(term.property_values_.begin(), term.property_values_.end(), std::back_inserter(property_values_));
+    std::move(term.synonym_list_.begin(), term.synonym_list_.end(), std::back_inserter(synonyms_));
+  }
+  definition_xref_offsets_.push_back(definition_xrefs_.size());
+  term_xref_offsets_.push_back(term_xrefs_.size());
+  property_value_offsets_.push_back(property_values_.size());
+  synonym_offsets_.push_back(synonyms_.size());
+  return i;
+}
+
+TermStore::LazyRange::LazyRange(LazyRange &&other) noexcept:
+  begin(other.begin), end(other.end), details(other.details.exchange(nullptr))
+{
+}
+
+TermStore::LazyRange &
+TermStore::LazyRange::operator=(const LazyRange &other)
+{
+  if (this != &other) {
+    begin = other.begin;
+    end = other.end;
+    delete details.exchange(nullptr);
+  }
+  return *this;
+}
+
+TermStore::LazyRange &
+TermStore::LazyRange::operator=(LazyRange &&other) noexcept
+{
+  if (this != &other) {
+    begin = other.begin;
+    end = other.end;
+    delete details.exchange(other.details.exchange(nullptr));
+  }
+  return *this;
+}
+
+TermStore::LazyRange::~LazyRange()
+{
+  delete details.load();
+}
+
+/**
+ * Several threads may decode the same term at once; the first to finish publishes its Term
+ * with a compare-and-swap, and the others discard theirs and return the published one.
+ */
+const Term *
+TermStore::lazy_details(int i) const
+{
+  if (static_cast<size_t>(i) >= lazy_ranges_.size() || lazy_ranges_[i].begin == lazy_ranges_[i].end) {
+    return nullptr;
+  }
+  const LazyRange &range = lazy_ranges_[i];
+  const Term *details = range.details.load(std::memory_order_acquire);
+  if (details == nullptr) {
+    auto decoded = std::make_unique<Term>(ids_[i], labels_[i]);
+    lazy_source_->materialize(*decoded, range.begin, range.end);
+    if (range.details.compare_exchange_strong(details, decoded.get(), std::memory_order_acq_rel)) {
+      details = decoded.release();
+    }
+  }
+  return details;
+}
+
+CivilDate
+TermStore::creation_date(int i) const
+{
+  if (creation_dates_[i].empty()) {
+    const Term *details = lazy_details(i);
+    if (details != nullptr) {
+      return parse_creation_date(details->property_values_);
+    }
+  }
+  return creation_dates_[i];
+}
+
+int
+TermStore::count_created_in(const DateWindow &window, int n) const
+{
+  if (lazy_source_) {
+    // the dates of lazy terms are decoded one by one
+    int count = 0;
+    for (int i = 0; i < n; ++i) {
+      CivilDate date = creation_date(i);
+      count += window.contains(date.empty() ? Term::DEFAULT_CREATION_DATE : date);
+    }
+    return count;
+  }
+  size_t count = window.count(creation_dates_.data(), n);
+  if (window.contains(Term::DEFAULT_CREATION_DATE)) {
+    // terms without a date
+    count += DateWindow{CivilDate(), CivilDate()}.count(creation_dates_.data(), n);
+  }
+  return static_cast<int>(count);
+}
+
+std::string_view
+TermStore::definition(int i) const
+{
+  const Term *details = lazy_details(i);
+  if (details != nullptr) {
+    return details->definition_;
+  }
+  return definitions_[i];
+}
+
+TermRange<Xref>
+TermStore::definition_xrefs(int i) const
+{
+  const Term *details = lazy_details(i);
+  return details ? TermRange<Xref>(details->definition_xref_list_) : pool_range(definition_xrefs_, definition_xref_offsets_, i);
+}
+
+TermRange<Xref>
+TermStore::term_xrefs(int i) const
+{
+  const Term *details = lazy_details(i);
+  return details ? TermRange<Xref>(details->term_xref_list_) : pool_range(term_xrefs_, term_xref_offsets_, i);
+}
+
+TermRange<PredicateValue>
+TermStore::property_values(int i) const
+{
+  const Term *details = lazy_details(i);
+  return details ? TermRange<PredicateValue>(details->property_values_) : pool_range(property_values_, property_value_offsets_, i);
+}
+
+TermRange<Synonym>
+TermStore::synonyms(int i) const
+{
+  const Term *details = lazy_details(i);
+  return details ? TermRange<Synonym>(details->synonym_list_) : pool_range(synonyms_, synonym_offsets_, i);
+}
+
+bool
+TermStore::is_materialized(int i) const
+{
+  return static_cast<size_t>(i) >= lazy_ranges_.size() || lazy_ranges_[i].begin == lazy_ranges_[i].end ||
+         lazy_ranges_[i].details.load(std::memory_order_acquire) != nullptr;
+}
+
+TermStore::LazyStats
+TermStore::lazy_stats() const
+{
+  LazyStats stats;
+  for (const LazyRange &range : lazy_ranges_) {
+    if (range.begin == range.end) {
+      continue;
+    }
+    ++stats.terms;
+    const Term *details = range.details.load(std::memory_order_acquire);
+    if (details != nullptr) {
+      ++stats.decoded;
+      stats.definition_bytes += details->definition_.size();
+    }
+  }
+  return stats;
+}
+
+Term
+TermStore::to_term(int i) const
+{
+  Term term{ids_[i], labels_[i]};
+  term.is_obsolete_ = obsolete_[i];
+  TermRange<TermId> alt_ids = alternative_ids(i);
+  term.alternative_id_list_.assign(alt_ids.begin(), alt_ids.end());
+  if (! is_materialized(i)) {
+    term.set_lazy_source(lazy_source_, lazy_ranges_[i].begin, lazy_ranges_[i].end);
+    return term;
+  }
+  term.definition_ = definition(i);
+  term.definition_xref_list_ = definition_xrefs(i).to_vector();
+  term.term_xref_list_ = term_xrefs(i).to_vector();
+  term.property_values_ = property_values(i).to_vector();
+  term.synonym_list_ = synonyms(i).to_vector();
+  return term;
+}
+
+bool
+TermView::is_alternative_id(const TermId &tid) const
+{
+  TermRange<TermId> alt_ids = alternative_ids();
+  return std::find(alt_ids.begin(), alt_ids.end(), tid) != alt_ids.end();
+}
+
+bool
+TermView::contains_xref_with_prefix(std::string_view prefix) const
+{
+  return contains_xref_with_prefix(term_xrefs(), prefix);
+}
+
+/** The prefix is looked up once; each xref is then checked with an integer comparison. */
+bool
+TermView::contains_xref_with_prefix(TermRange<Xref> xrefs, std::string_view prefix)
+{
+  int prefix_index = TermId::find_prefix_index(prefix);
+  if (prefix_index < 0) {
+    // no TermId has this prefix
+    return false;
+  }
+  for (const Xref &xr : xrefs) {
+    if (xr.has_prefix_index(prefix_index)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+CivilDate
+TermView::get_creation_date() const
+{
+  CivilDate date = store_->creation_date(index_);
+  return date.empty() ? Term::DEFAULT_CREATION_DATE : date;
+}
+
+
 std::ostream& operator<<(std::ostream& ost, const Edge& edge){
 	ost << edge.source_;
 	switch (edge.edge_type_){
@@ -212,69 +566,6 @@ std::ostream& operator<<(std::ostream& ost, const Edge& edge){
 	return ost;
 }
 
-Ontology::Ontology(const Ontology &other):
-	id_(other.id_),
-	predicate_values_(other.predicate_values_),
-  property_list_(other.property_list_),
-	term_map_(other.term_map_),
-	current_term_ids_(other.current_term_ids_),
-	obsolete_term_ids_(other.obsolete_term_ids_),
-  termid_to_index_(other.termid_to_index_),
-  offset_to_edge_(other.offset_to_edge_),
- // offset_from_edge_ (other.offset_from_edge_),
-	edge_to_(other.edge_to_)
- // edge_from_(other.edge_from_)
-	 {
-		// no-op
-	 }
-Ontology::Ontology(Ontology &other): 	id_(other.id_){
-	predicate_values_ = std::move(other.predicate_values_);
-  property_list_ = std::move(other.property_list_);
-	term_map_ = std::move(other.term_map_);
-	current_term_ids_ = std::move(other.current_term_ids_);
-  termid_to_index_ = std::move(other.termid_to_index_);
-	obsolete_term_ids_ = std::move(other.obsolete_term_ids_);
-	edge_to_ = std::move(other.edge_to_);
-  //edge_from_ = std::move(other.edge_from_);
-  offset_to_edge_ = std::move(other.offset_to_edge_);
-  //offset_from_edge_ = std::move(other.offset_from_edge_);
-}
-Ontology&
-Ontology::operator=(const Ontology &other){
-	if (this != &other) {
-		id_ = other.id_;
-		predicate_values_ = other.predicate_values_;
-    property_list_ = other.property_list_;
-		term_map_ = other.term_map_;
-    termid_to_index_ = other.termid_to_index_;
-		current_term_ids_ = other.current_term_ids_;
-		obsolete_term_ids_ = other.obsolete_term_ids_;
-		edge_to_ = other.edge_to_;
-    //edge_from_ = other.edge_from_;
-    offset_to_edge_ = other.offset_to_edge_;
-    //offset_from_edge_ = other.offset_from_edge_;
-	}
-	return *this;
-}
-Ontology&
-Ontology::operator=(Ontology &&other){
-	if (this != &other) {
-		id_ = std::move(other.id_);
-		predicate_values_ = std::move(other.predicate_values_);
-    property_list_ = std::move(other.property_list_);
-		term_map_ = std::move(other.term_map_);
-		current_term_ids_ = std::move(other.current_term_ids_);
-		obsolete_term_ids_ = std::move(other.obsolete_term_ids_);
-    termid_to_index_ = std::move(other.termid_to_index_);
-		edge_to_ = std::move(other.edge_to_);
-    //edge_from_ = std::move(other.edge_from_);
-    offset_to_edge_ = std::move(other.offset_to_edge_);
-    //offset_from_edge_ = std::move(other.offset_from_edge_);
-	}
-	return *this;
-}
-
-
 /**
   * Add a BasicPropetyValue of the ontology
   * These elements are stored in the section "basicPropertyValues"
@@ -296,6 +587,16 @@ Ontology::add_property(const Property & prop){
   property_list_.push_back(prop);
 }
 
+Ontology::Ontology(OntologyBuilder &&builder):
+  id_(std::move(builder.id_)),
+  version_(std::move(builder.version_)),
+  predicate_values_(std::move(builder.predicate_values_)),
+  property_list_(std::move(builder.properties_))
+{
+  add_all_terms(std::move(builder.terms_));
+  add_all_edges(builder.edges_, builder.edge_lenient_, builder.threads_);
+}
+
 Ontology::Ontology(const string &id,
 		   const vector<Term> &terms,
 		   vector<Edge> &edges,
@@ -325,165 +626,211 @@ Ontology::Ontology(const string &id,
 
 void
 Ontology::add_all_terms(const vector<Term> &terms){
-  auto N = terms.size();
-  for (auto t : terms) {
-    shared_ptr<Term> sptr = make_shared<Term>(t);
-    TermId tid = t.get_term_id();
-    string id = tid.get_id();
-    term_map_.insert(std::make_pair(tid,sptr));
-    if (t.obsolete()){
+  add_all_terms(vector<Term>(terms));
+}
+
+/**
+ * The strings and lists of each Term are moved into the columns of terms_, i.e., the terms of
+ * the parser are not copied. The current terms are sorted by id and come first, so that the
+ * index of a current term in terms_ is its vertex index; the obsolete terms follow in input order.
+ * A term that occurs in several graphs of the input (e.g., a class of an imported
+ * ontology) is only added once; the first occurrence is kept.
+ */
+void
+Ontology::add_all_terms(vector<Term> &&terms){
+  ancestor_closure_ = AncestorClosure();
+  reachability_index_ = ReachabilityIndex();
+  if (! terms_.empty()) {
+    // the order of the store depends on all terms, so it is built again
+    vector<Term> previous;
+    previous.reserve(terms_.size() + terms.size());
+    for (size_t i = 0; i < terms_.size(); ++i) {
+      previous.push_back(terms_.to_term(i));
+    }
+    std::move(terms.begin(), terms.end(), std::back_inserter(previous));
+    terms.swap(previous);
+    terms_ = TermStore();
+    term_index_ = TermIdMap<int>();
+    current_term_ids_.clear();
+    obsolete_term_ids_.clear();
+    termid_to_index_ = TermIdMap<int>();
+  }
+  TermIdMap<int> seen;
+  seen.reserve(terms.size());
+  vector<Term*> current;
+  vector<Term*> obsolete;
+  for (Term &t : terms) {
+    if (! seen.insert(t.id_, 0)) {
+      continue;
+    }
+    if (t.obsolete()) {
+      obsolete.push_back(&t);
+    } else {
+      current.push_back(&t);
+    }
+  }
+  std::sort(current.begin(), current.end(), [](const Term *a, const Term *b) { return a->id_ < b->id_; });
+  vector<Term*> order = std::move(current);
+  order.insert(order.end(), obsolete.begin(), obsolete.end());
+  terms_.reserve(order);
+  term_index_.reserve(terms.size());
+  for (Term *t : order) {
+    int i = terms_.append(std::move(*t));
+    const TermId &tid = terms_.id(i);
+    term_index_.insert(tid, i);
+    if (terms_.obsolete(i)) {
       obsolete_term_ids_.push_back(tid);
     } else {
       current_term_ids_.push_back(tid);
     }
-    if (t.has_alternative_ids()) {
-      vector<TermId> alt_ids = t.get_alternative_ids();
-      for (auto atid : alt_ids) {
-	      term_map_.insert(std::make_pair(atid,sptr));
-      }
-    }
-  }
-  std::sort(current_term_ids_.begin(), current_term_ids_.end());
-  if (current_term_ids_.size() + obsolete_term_ids_.size() != N) {
-    // sanity check
-    // should never ever happen. TODO add exception
-    throw PhenopacketException("[FATAL] Number of term ids not equal to number of terms");
   }
+  termid_to_index_.reserve(current_term_ids_.size());
   for (auto i=0u; i<current_term_ids_.size(); ++i) {
-    termid_to_index_[current_term_ids_[i]] = i;
+    termid_to_index_.insert(current_term_ids_[i], i);
+  }
+  // a primary id is never shadowed by the alternative id of another term
+  for (size_t i = 0; i < terms_.size(); ++i) {
+    for (const TermId &atid : terms_.alternative_ids(i)) {
+      term_index_.insert(atid, i);
+    }
   }
 }
 
 /**
- * Check whether source and destination terms are in the ontology.
- * This is needed to avoid problems with edges that are derived from
- * the logical definitions.
- * */
-bool
-Ontology::valid_edge(Edge e) const
+ * @return index of tid in current_term_ids_, or -1 if tid is not a current term of the ontology.
+ * Edges that are derived from the logical definitions may refer to terms of other ontologies.
+ */
+int
+Ontology::vertex_index(const TermId &tid) const
 {
-  TermId source = e.get_source();
-  auto it = termid_to_index_.find(source);
-  if (it == termid_to_index_.end()) {
-    return false;
+  const int *index = termid_to_index_.find(tid);
+  return index == nullptr ? -1 : *index;
+}
+
+/**
+ * Look up the vertex indices of the source and destination of edges[begin..end).
+ * The lookups are the only part of building the graph that is not linear in the
+ * number of edges, so large edge lists are split among several threads.
+ */
+void
+Ontology::resolve_edge_indices(const vector<Edge> &edges,
+                               vector<int> &source,
+                               vector<int> &destination,
+                               unsigned int threads) const
+{
+  // below this number of edges per thread, starting a thread costs more than it saves
+  const size_t MIN_EDGES_PER_THREAD = 1 << 14;
+  size_t n_edges = edges.size();
+  source.resize(n_edges);
+  destination.resize(n_edges);
+  auto resolve = [this, &edges, &source, &destination](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      source[i] = vertex_index(edges[i].get_source());
+      destination[i] = vertex_index(edges[i].get_destination());
+    }
+  };
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
   }
-  TermId dest = e.get_destination();
-  it = termid_to_index_.find(dest);
-  if (it == termid_to_index_.end()) {
-    return false;
+  size_t n_workers = std::min<size_t>(threads, n_edges / MIN_EDGES_PER_THREAD);
+  if (n_workers <= 1) {
+    resolve(0, n_edges);
+    return;
+  }
+  vector<std::thread> workers;
+  workers.reserve(n_workers);
+  size_t block = (n_edges + n_workers - 1) / n_workers;
+  for (size_t w = 0; w < n_workers; ++w) {
+    size_t begin = std::min(n_edges, w * block);
+    size_t end = std::min(n_edges, begin + block);
+    workers.emplace_back(resolve, begin, end);
+  }
+  for (std::thread &t : workers) {
+    t.join();
   }
-  return true;
+}
+
+void
+Ontology::add_all_edges(vector<Edge> &edges, bool edge_leniency){
+  add_all_edges(edges, edge_leniency, 1);
 }
 
 /**
- * Figure out how to be more efficient later.
+ * Build the CSR adjacency list from the edges. Every IS_A edge is also entered in the
+ * reverse direction as an IS_A_INVERSE edge. After the vertex indices have been looked up,
+ * the edges are placed by two counting sorts on the integer indices, first by destination
+ * and then (stably) by source, so that the edges of each vertex are ordered by destination
+ * and the whole construction takes O(V+E).
  */
 void
-Ontology::add_all_edges(vector<Edge> &edges, bool edge_leniency){
+Ontology::add_all_edges(const vector<Edge> &edges, bool edge_leniency, unsigned int threads){
+  ancestor_closure_ = AncestorClosure();
+  reachability_index_ = ReachabilityIndex();
   original_edge_count_ = edges.size();
   is_a_edge_count_ = 0;
   skipped_edge_count_ = 0;
-  vector<Edge> valid_edges; // edges with s/d TermIds in the ontology
-  // First we add inverse edges for all IS_A edges
-  vector<Edge> inverse_edges;
-  for (Edge e: edges) {
-    if (! valid_edge(e)) {
-      //cout << "[INFO] " << __FILE__ << "(" << __LINE__ << ") invalid edge: " << e << "\n";
+  vector<int> source;
+  vector<int> destination;
+  resolve_edge_indices(edges, source, destination, threads);
+  // keep the edges with s/d TermIds in the ontology and add the inverse IS_A edges
+  vector<int> from;
+  vector<int> to;
+  vector<EdgeType> types;
+  from.reserve(2 * edges.size());
+  to.reserve(2 * edges.size());
+  types.reserve(2 * edges.size());
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (source[i] < 0 || destination[i] < 0) {
       ++skipped_edge_count_;
-      if (edge_leniency) continue;
-      else {
+      if (! edge_leniency) {
         std::stringstream sstr;
-        sstr << "[FATAL] could not find TermId for edge:" << e;
+        sstr << "[FATAL] could not find TermId for edge:" << edges[i];
         throw PhenopacketException(sstr.str() );
       }
-    }
-    // if we get here the edge is OK
-    valid_edges.push_back(e);
-    if (e.is_is_a()) {
-      ++is_a_edge_count_;
-      inverse_edges.emplace_back(e.get_is_a_inverse());
-      valid_edges.emplace_back(e.get_is_a_inverse());
-    }
-  }
-  // now merge
-  edges.insert(edges.end(),inverse_edges.begin(), inverse_edges.end());
-  // First sort the edges on their source element
-  // this will mean that edges has the same oder of source
-  // TermIds as the current_term_ids_ list. If the source is the
-  // same, sort on the dest
-  std::sort(valid_edges.begin(),valid_edges.end(),[](const Edge &a, const Edge &b) {
-					return a.get_source() == b.get_source() ?
-					  a.get_destination() < b.get_destination() :
-					  a.get_source() < b.get_source();
-				      });
-  int n_vertices = current_term_ids_.size();
-  int number_isa_edges = std::count_if(valid_edges.begin(), valid_edges.end(), [](Edge e){return e.is_is_a();});
-  int total_edge_count = valid_edges.size() ;//+ number_isa_edges; // add this for the inverse edges
-  edge_to_.reserve(total_edge_count);
-  //edge_from_.reserve(edges.size());
-  edge_type_list_.reserve(edges.size());
-  offset_to_edge_.reserve(n_vertices+1);
- // offset_from_edge_.reserve(n_vertices+1);
-  // We perform two passes
-  // In the first pass, we count how many edges emanate from each
-  // source
-  map<int,int> index2edge_count;
-  for (const auto &e : valid_edges) {
-    TermId source = e.get_source();
-    auto it = termid_to_index_.find(source);
-    int idx = it->second;
-    auto p = index2edge_count.find(idx);
-    if (p == index2edge_count.end()) {
-      index2edge_count[idx] = 1; // first edge from this source index
-    } else {
-      index2edge_count[idx] =  1 + p->second; // increment
-    }
-  }
-  // second pass -- set the offset_to_edge_ according to the number of edges
-  // emanating from each source ids.
-  offset_to_edge_.push_back(0); // offset of zeroth source TermId is zero
-  int offset = 0;
-  for (auto i=0u; i < current_term_ids_.size(); ++i) {
-    // these i's are the indices of all of the TermIds
-    auto p = index2edge_count.find(i);
-    if (p != index2edge_count.end()) {
-      int n_edges = p->second;
-      offset += n_edges;
-    }
-    // note if we cannot find anything for i, then the i'th TermId
-    // has no outgoing edges
-    offset_to_edge_.push_back(offset);
-  }
-  // third pass -- add the actual edges
-  // use the offset variable to keep track of how many edges we have already
-  // entered for a given source index
-  int current_source_index = -1;
-  offset = 0;
-  for (const auto &e : valid_edges) {
-    TermId source = e.get_source();
-    TermId destination = e.get_destination();
-    // note we have already checked all of the source id's above
-    auto it = termid_to_index_.find(source);
-    int source_index = it->second;
-    auto p = termid_to_index_.find(destination);
-    if (p == termid_to_index_.end()) {
-      std::cerr <<"[ERROR] Could not find index of destination TermId " << destination << "\n";
       continue;
     }
-    int destination_index = p->second;
-    if (source_index != current_source_index) {
-      current_source_index = source_index;
-      offset = 0; // start a new block
-    } else {
-      offset++; // go to next index (for a new destination of the previous source)
-    }
-    //edge_to_[source_index + offset] = destination_index;
-    edge_to_.push_back(destination_index);
-    edge_type_list_.push_back(e.get_edge_type());
-    if (e.is_is_a()) {
-      is_a_edge_count_++;
+    from.push_back(source[i]);
+    to.push_back(destination[i]);
+    types.push_back(edges[i].get_edge_type());
+    if (edges[i].is_is_a()) {
+      ++is_a_edge_count_;
+      from.push_back(destination[i]);
+      to.push_back(source[i]);
+      types.push_back(EdgeType::IS_A_INVERSE);
     }
   }
+  int n_vertices = current_term_ids_.size();
+  size_t total_edge_count = from.size();
+  // first counting sort: order the edges by destination
+  vector<int> count(n_vertices + 1, 0);
+  for (int d : to) {
+    count[d + 1]++;
+  }
+  for (int v = 0; v < n_vertices; ++v) {
+    count[v + 1] += count[v];
+  }
+  vector<int> by_destination(total_edge_count);
+  for (size_t k = 0; k < total_edge_count; ++k) {
+    by_destination[count[to[k]]++] = k;
+  }
+  // second counting sort: the out-degree of each vertex gives offset_to_edge_, then
+  // the edges are scattered to their source block in the order of the first sort
+  offset_to_edge_.assign(n_vertices + 1, 0);
+  for (int s : from) {
+    offset_to_edge_[s + 1]++;
+  }
+  for (int v = 0; v < n_vertices; ++v) {
+    offset_to_edge_[v + 1] += offset_to_edge_[v];
+  }
+  vector<int> next_slot(offset_to_edge_.begin(), offset_to_edge_.end() - 1);
+  edge_to_.resize(total_edge_count);
+  edge_type_list_.resize(total_edge_count);
+  for (int k : by_destination) {
+    int slot = next_slot[from[k]]++;
+    edge_to_[slot] = to[k];
+    edge_type_list_[slot] = types[k];
+  }
+  remove_duplicate_edges();
   // When we get here, we are done! Print a message
   cout << "[INFO] Done parsing edges: n=" << original_edge_count_ 
       << " (including supplemental edges: "
@@ -493,11 +840,56 @@ Ontology::add_all_edges(vector<Edge> &edges, bool edge_leniency){
   }
 }
 
+/**
+ * Merged inputs (several graphs) may contain the same edge more than once. The edges of
+ * each vertex are ordered by destination, so a repeated edge is found in the run of edges
+ * with the same destination, and the rows are compacted in place in one pass.
+ */
+void
+Ontology::remove_duplicate_edges(){
+  int n_vertices = current_term_ids_.size();
+  int n_kept = 0;
+  for (int v = 0; v < n_vertices; ++v) {
+    int begin = offset_to_edge_[v];
+    int end = offset_to_edge_[v + 1];
+    offset_to_edge_[v] = n_kept;
+    for (int i = begin; i < end; ++i) {
+      bool duplicate = false;
+      for (int j = n_kept - 1; j >= offset_to_edge_[v] && edge_to_[j] == edge_to_[i]; --j) {
+        if (edge_type_list_[j] == edge_type_list_[i]) {
+          duplicate = true;
+          break;
+        }
+      }
+      if (! duplicate) {
+        edge_to_[n_kept] = edge_to_[i];
+        edge_type_list_[n_kept] = edge_type_list_[i];
+        ++n_kept;
+      }
+    }
+  }
+  offset_to_edge_[n_vertices] = n_kept;
+  size_t n_duplicates = edge_to_.size() - n_kept;
+  if (n_duplicates == 0) {
+    return;
+  }
+  edge_to_.resize(n_kept);
+  edge_type_list_.resize(n_kept);
+  is_a_edge_count_ = std::count(edge_type_list_.begin(), edge_type_list_.end(), EdgeType::IS_A);
+  cout << "[INFO] removed " << n_duplicates << " duplicate edges.\n";
+}
+
+TermView
+Ontology::term(const TermId &tid) const{
+	const int *p = term_index_.find(tid);
+	return p == nullptr ? TermView() : TermView(&terms_, *p);
+}
+
 std::optional<Term>
 Ontology::get_term(const TermId &tid) const{
-	auto p = term_map_.find(tid);
-	if (p != term_map_.end()) {
-		return *(p->second);
+	TermView view = term(tid);
+	if (view) {
+		return view.to_term();
 	} else {
 		return std::nullopt;
 	}
@@ -507,12 +899,12 @@ vector<TermId>
 Ontology::get_isa_parents(const TermId &child) const
 {
   vector<TermId> parents;
-  auto p = termid_to_index_.find(child);
-  if (p == termid_to_index_.end()) {
+  const int *p = termid_to_index_.find(child);
+  if (p == nullptr) {
     // not found, return empty vector
     return parents;
   }
-  int idx = p->second;
+  int idx = *p;
   for (int i = offset_to_edge_[idx]; i < offset_to_edge_[1+idx]; i++) {
     if (edge_type_list_[i] != EdgeType::IS_A) { 
       continue;
@@ -531,21 +923,27 @@ Ontology::get_isa_parents(const TermId &child) const
 bool
 Ontology::exists_path(const TermId &source, const TermId &dest) const
 {
-  auto p = termid_to_index_.find(source);
-  if (p == termid_to_index_.end()) {
+  const int *p = termid_to_index_.find(source);
+  if (p == nullptr) {
     // not found
     // should never happen, todo return exception
     return false;
   }
   std::stack<int> st;
-  int index = p->second;
+  int index = *p;
   p = termid_to_index_.find(dest);
-  if (p == termid_to_index_.end()) {
+  if (p == nullptr) {
     // not found
     // should never happen, todo return exception
     return false;
   }
-  int dest_idx = p->second;
+  int dest_idx = *p;
+  if (ancestor_closure_.built()) {
+    return index != dest_idx && ancestor_closure_.contains(index, dest_idx);
+  }
+  if (reachability_index_.built()) {
+    return reachability_index_.exists_path(index, dest_idx);
+  }
   st.push(index);
   while (! st.empty()) {
     index = st.top();
@@ -569,21 +967,24 @@ Ontology::exists_path(const TermId &source, const TermId &dest) const
 bool
 Ontology::exists_path(const TermId &source, const TermId &dest, EdgeType etype) const
 {
-  auto p = termid_to_index_.find(source);
-  if (p == termid_to_index_.end()) {
+  if (etype == EdgeType::IS_A) {
+    return exists_path(source, dest);
+  }
+  const int *p = termid_to_index_.find(source);
+  if (p == nullptr) {
     // not found
     // should never happen, todo return exception
     return false;
   }
   std::stack<int> st;
-  int index = p->second;
+  int index = *p;
   p = termid_to_index_.find(dest);
-  if (p == termid_to_index_.end()) {
+  if (p == nullptr) {
     // not found
     // should never happen, todo return exception
     return false;
   }
-  int dest_idx = p->second;
+  int dest_idx = *p;
   st.push(index);
   while (! st.empty()) {
     index = st.top();
@@ -607,14 +1008,22 @@ Ontology::exists_path(const TermId &source, const TermId &dest, EdgeType etype)
 std::set<TermId> 
 Ontology::get_ancestors(const TermId &tid) const
 {
-  auto p = termid_to_index_.find(tid);
-  if (p == termid_to_index_.end()) {
+  const int *p = termid_to_index_.find(tid);
+  if (p == nullptr) {
     // not found, should never happen
     throw PhenopacketException("Unrecognized TermId: " + tid.get_value());
   }
+  int t1_index = *p;
+  if (ancestor_closure_.built()) {
+    std::set<TermId> tid1_ancestors;
+    for (const int *a = ancestor_closure_.begin(t1_index); a != ancestor_closure_.end(t1_index); ++a) {
+      // the rows are sorted, as are the ids, so each insertion goes to the end of the set
+      tid1_ancestors.insert(tid1_ancestors.end(), current_term_ids_[*a]);
+    }
+    return tid1_ancestors;
+  }
   std::stack<int> st;
   std::set<int> t1_ancestors;
-  int t1_index = p->second;
   st.push(t1_index);
   while (! st.empty()) {
     int index = st.top();
@@ -635,30 +1044,76 @@ Ontology::get_ancestors(const TermId &tid) const
   return tid1_ancestors;
 }
 
+void
+Ontology::build_ancestor_closure()
+{
+  ancestor_closure_ = AncestorClosure(offset_to_edge_, edge_to_, edge_type_list_, EdgeType::IS_A);
+}
+
+void
+Ontology::build_reachability_index(int traversals)
+{
+  reachability_index_ = ReachabilityIndex(offset_to_edge_, edge_to_, edge_type_list_, EdgeType::IS_A, traversals);
+  if (! reachability_index_.built()) {
+    cerr << "[WARNING] the is_a graph of " << id_ << " has a cycle; exists_path will search the graph\n";
+  }
+}
+
+TermRange<int>
+Ontology::get_ancestor_indices(const TermId &tid) const
+{
+  if (! ancestor_closure_.built()) {
+    throw PhenopacketException("get_ancestor_indices: the ancestor closure of " + id_ + " was not built");
+  }
+  const int *p = termid_to_index_.find(tid);
+  if (p == nullptr) {
+    throw PhenopacketException("Unrecognized TermId: " + tid.get_value());
+  }
+  return TermRange<int>(ancestor_closure_.begin(*p), ancestor_closure_.end(*p));
+}
+
+/**
+ * With the closure, a binary search in the (short) row of tid; otherwise a search of the
+ * is_a graph from tid.
+ */
+bool
+Ontology::is_ancestor(const TermId &ancestor, const TermId &tid) const
+{
+  const int *p = termid_to_index_.find(tid);
+  const int *q = termid_to_index_.find(ancestor);
+  if (p == nullptr || q == nullptr) {
+    return false;
+  }
+  if (ancestor_closure_.built()) {
+    return ancestor_closure_.contains(*p, *q);
+  }
+  return *p == *q || exists_path(tid, ancestor);
+}
+
 bool
 Ontology::have_common_ancestor(const TermId &t1, const TermId &t2, const TermId &root) const
 {
   if (t1 == root || t2 == root) {
     return false; // by definition, if one of the terms (t1,t2) is root there is no non-root common anc
   }
-  auto p = termid_to_index_.find(t1);
-  if (p == termid_to_index_.end()) {
+  const int *p = termid_to_index_.find(t1);
+  if (p == nullptr) {
     // not found, should never happen
     throw PhenopacketException("Unrecognized TermId: " + t1.get_value());
   }
-  int t1_index = p->second;
+  int t1_index = *p;
   p = termid_to_index_.find(t2);
-  if (p == termid_to_index_.end()) {
+  if (p == nullptr) {
     // not found, should never happen
     throw PhenopacketException("Unrecognized TermId: " + t2.get_value());
   }
-  int t2_index = p->second;
+  int t2_index = *p;
   p = termid_to_index_.find(root);
-  if (p == termid_to_index_.end()) {
+  if (p == nullptr) {
     // not found, should never happen
     throw PhenopacketException("Unrecognized TermId: " + root.get_value());
   }
-  int root_index = p->second;
+  int root_index = *p;
   std::stack<int> st;
   std::set<int> t1_ancestors;
   st.push(t1_index);
@@ -731,6 +1186,9 @@ void
 Ontology::output_descriptive_statistics(std::ostream& ost) const
 {
   ost << "id: " << id_ << "\n";
+  if (! version_.empty()) {
+    ost << "version: " << version_ << "\n";
+  }
   for (const auto &pv : predicate_values_) {
 		ost << pv << "\n";
 	}
@@ -741,6 +1199,31 @@ Ontology::output_descriptive_statistics(std::ostream& ost) const
   ost << "total original edge count: " << edge_count()  << "\n";
   ost << "edge_count_with_supplemental_edges: " << edge_count_with_supplemental_edges() << "\n";
   ost << "property count: " << property_count() << "\n";
+  // the arena holds the strings of all ontologies that were loaded by this process
+  StringArena::Stats arena = StringArena::global().stats();
+  ost << "string_arena_bytes: " << arena.reserved_bytes << "\n";
+  ost << "string_arena_saved_bytes: " << arena.saved_bytes() << "\n";
+  ost << "string_arena_interned_bytes: " << arena.interned_bytes << "\n";
+  TermStore::LazyStats lazy = terms_.lazy_stats();
+  if (lazy.terms > 0) {
+    ost << "lazy_terms: " << lazy.terms << "\n";
+    ost << "lazy_terms_decoded: " << lazy.decoded << "\n";
+    ost << "lazy_definition_bytes: " << lazy.definition_bytes << "\n";
+  }
+  if (ancestor_closure_.built()) {
+    const AncestorClosure::Stats &closure = ancestor_closure_.stats();
+    ost << "ancestor_closure_entries: " << closure.entries << "\n";
+    ost << "ancestor_closure_max_ancestors: " << closure.max_row_length << "\n";
+    ost << "ancestor_closure_bytes: " << closure.bytes << "\n";
+    ost << "ancestor_closure_bit_matrix_bytes: " << closure.bit_matrix_bytes() << "\n";
+    ost << "ancestor_closure_build_ms: " << closure.build_ms << "\n";
+  }
+  if (reachability_index_.built()) {
+    const ReachabilityIndex::Stats &reach = reachability_index_.stats();
+    ost << "reachability_index_traversals: " << reach.traversals << "\n";
+    ost << "reachability_index_bytes: " << reach.bytes << "\n";
+    ost << "reachability_index_build_ms: " << reach.build_ms << "\n";
+  }
 }
 
 /**
@@ -758,17 +1241,14 @@ Ontology::debug_print() const
       int dest_idx = edge_to_.at(j);
       TermId source_id = current_term_ids_.at(i);
       TermId dest_id = current_term_ids_.at(dest_idx);
-      // if we get here, the following "has to" work
-      auto source = term_map_.at(source_id);
-      auto dest = term_map_.at(dest_id);
       EdgeType etype = edge_type_list_[j];
-      cout <<"i="<<i <<": " << source->get_label() << " [" << source_id << "]";
+      cout <<"i="<<i <<": " << terms_.label(i) << " [" << source_id << "]";
       if (etype == EdgeType::IS_A) {
         cout << " is_a ";
       } else {
         cout << " todo-edge ";
       }
-        cout << dest->get_label() << " [" << dest_id << "]\n";
+        cout << terms_.label(dest_idx) << " [" << dest_id << "]\n";
     }
   }
   cout <<"begins at e_to[offset_e[v]] and ends at e_to[offset_e[v+1]]-1.\n";
@@ -798,18 +1278,16 @@ Ontology::debug_print() const
 
 
 
+/**
+ * The current terms are the first entries of terms_, so this is a linear scan over its columns.
+ */
 int 
-Ontology::filter_terms(std::function<bool(Term*)> f, std::ostream& s)
+Ontology::filter_terms(std::function<bool(const TermView&)> f) const
 {
   int passed = 0;
-  for (TermId tid : current_term_ids_) {
-    auto p = term_map_.find(tid);
-    if (p != term_map_.end()) {
-      std::shared_ptr<Term> t = p->second;
-      if (f(t.get())) {
-        //s << t->get_label() << "\n";
-        passed++;
-      }
+  for (int i = 0; i < current_term_count(); ++i) {
+    if (f(TermView(&terms_, i))) {
+      passed++;
     }
   }
   return passed;
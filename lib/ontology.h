@@ -10,6 +10,7 @@
 #ifndef ONTOLOGY_H
 #define ONTOLOGY_H
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
@@ -18,11 +19,17 @@
 #include <optional>
 #include <variant>
 #include <functional>
-#include <ctime>
+#include <stdexcept>
+#include <string_view>
 
 #include "termid.h"
 #include "edge.h"
 #include "property.h"
+#include "termidmap.h"
+#include "stringarena.h"
+#include "civildate.h"
+#include "ancestorclosure.h"
+#include "reachabilityindex.h"
 
 #include <iostream> // remove after debug
 
@@ -32,21 +39,39 @@ using std::vector;
 using std::map;
 
 
+/**
+ * Cross reference of a term, either a TermId (e.g., UMLS:C1234567) or a URL. An Xref is a single
+ * 64-bit code: the code of the TermId, or, with the top bit set (which no TermId code has), the
+ * index of the URL in a process-wide table of URLs. This keeps the xref lists of MONDO small, and
+ * the prefix of an xref can be compared without building strings (see has_prefix_index).
+ */
 class Xref {
 private:
-  /** Intended to hold a TermId or a URL */
-  // consider using variant in the future. Not currently supported on macOS by c++17 compiler
-  //  std::variant<TermId, std::string> cargo_;
-  TermId term_id_;
-  string url_;
-  Xref();
+  static constexpr uint64_t URL_TAG = uint64_t(1) << 63;
+  uint64_t code_;
+  explicit Xref(uint64_t code): code_(code) {}
 public:
-    Xref(const TermId &tid): term_id_(tid){}
-    Xref(const Xref &txr);
+    Xref(const TermId &tid): code_(tid.code_){}
+    Xref(const Xref &txr) = default;
     Xref(Xref &&txr) = default;
-    Xref &operator=(const Xref &txr);
-    static Xref from_url(const string &url);
-    TermId get_termid() const { return term_id_; }
+    Xref &operator=(const Xref &txr) = default;
+    static Xref from_url(std::string_view url);
+    /**
+     * @return the Xref for s, a URL (if it contains "http") or a CURIE. If s is a malformed CURIE,
+     * error is set (and the Xref holds EMPTY_TERMID); nothing is thrown, since such xrefs are common.
+     */
+    static Xref parse(std::string_view s, TermIdError &error);
+    /** @return true if this Xref holds a URL rather than a TermId. */
+    bool is_url() const { return (code_ & URL_TAG) != 0; }
+    /** @return the TermId, or EMPTY_TERMID if this Xref holds a URL. */
+    TermId termid() const { return is_url() ? EMPTY_TERMID : TermId(code_); }
+    TermId get_termid() const { return termid(); }
+    /** @return the URL (a view into the StringArena), or an empty view if this Xref holds a TermId. */
+    std::string_view url() const;
+    string get_url() const { return string(url()); }
+    /** @return true if this Xref holds a TermId whose prefix has the index prefix_index (see TermId::find_prefix_index). */
+    bool has_prefix_index(int prefix_index) const { return ! is_url() && TermId(code_).prefix_index() == prefix_index; }
+    bool has_prefix(std::string_view prefix) const { return ! is_url() && TermId(code_).has_prefix(prefix); }
     friend std::ostream& operator<<(std::ostream& ost, const Xref& txref);
 };
 std::ostream& operator<<(std::ostream& ost, const Xref& txref);
@@ -58,16 +83,18 @@ class Synonym {
 private:
   enum SynonymType { EXACT, BROAD, NARROW, RELATED };
   SynonymType stype_;
-  string label_;
+  /** Interned in the StringArena; the same synonym often occurs in several terms. */
+  std::string_view label_;
 
 public:
-  Synonym(const string &lbl, const string &typ);
+  Synonym(const string &typ, std::string_view lbl);
   Synonym(const Synonym &) = default;
   Synonym(Synonym &&) = default;
   Synonym &operator=(const Synonym &) = default;
   Synonym &operator=(Synonym &&) = default;
   ~Synonym(){}
-  string get_label() const { return label_; }
+  std::string_view label() const { return label_; }
+  string get_label() const { return string(label_); }
   bool is_exact() const { return stype_ == SynonymType::EXACT; }
   bool is_broad() const { return stype_ == SynonymType::BROAD; }
   bool is_narrow() const { return stype_ == SynonymType::NARROW; }
@@ -76,59 +103,292 @@ public:
 };
 std::ostream& operator<<(std::ostream& ost, const Synonym& synonym);
 
+class Term;
+
+/**
+ * Source of the definition, xrefs, property values and synonyms of lazily loaded
+ * terms. Implementations keep the input buffer alive and decode the byte range
+ * [begin,end) that belongs to one term. materialize throws PhenopacketException if the range
+ * cannot be decoded, so that a term is never shown without the details it has.
+ */
+class LazyTermSource {
+public:
+  virtual ~LazyTermSource() {}
+  virtual void materialize(Term &term, size_t begin, size_t end) const = 0;
+};
+
 class Term {
 private:
+  friend class OntologySnapshot;
+  friend class Ontology;
+  friend class TermStore;
   TermId id_;
-  string label_;
-  string definition_;
-  vector<Xref> definition_xref_list_;
-  vector<Xref> term_xref_list_;
+  /** The label is interned and the definition stored in the StringArena. */
+  std::string_view label_;
+  /* The following fields are decoded on first access for lazily loaded terms
+   * (see materialize), which is why they may be modified by const accessors. */
+  mutable std::string_view definition_;
+  mutable vector<Xref> definition_xref_list_;
+  mutable vector<Xref> term_xref_list_;
   vector<TermId> alternative_id_list_;
-  vector<PredicateValue> property_values_;
-  vector<Synonym> synonym_list_;
+  mutable vector<PredicateValue> property_values_;
+  mutable vector<Synonym> synonym_list_;
   bool is_obsolete_ = false;
+  /** Set for a lazily loaded term until its fields have been decoded. */
+  mutable std::shared_ptr<const LazyTermSource> lazy_source_;
+  mutable size_t lazy_begin_ = 0;
+  mutable size_t lazy_end_ = 0;
+  /** Decode the lazy fields, if needed. Not thread safe; a lazy Term should not be shared between threads. */
+  void materialize() const { if (lazy_source_) decode_lazy_fields(); }
+  void decode_lazy_fields() const;
 
 public:
-  Term(const TermId &id, const string &label);
-  void add_definition(const string &def);
+  Term(const TermId &id, std::string_view label);
+  /**
+   * Store the definition in the StringArena. With intern, equal definitions share one copy;
+   * a LazyTermSource interns, because the same details may be decoded more than once (see
+   * TermStore) and the arena never frees a copy.
+   */
+  void add_definition(std::string_view def, bool intern = false);
   void add_definition_xref(const Xref &txref);
   void add_term_xref(const Xref &txref) { term_xref_list_.push_back(txref); }
   void add_predicate_value(const PredicateValue &pv);
-  void add_synonym(const string &pred, const string &lbl);
+  void add_synonym(const string &pred, std::string_view lbl);
+
+  /** Defer decoding of the definition, xrefs, property values and synonyms until they are requested. */
+  void set_lazy_source(std::shared_ptr<const LazyTermSource> source, size_t begin, size_t end);
+  bool is_materialized() const { return ! lazy_source_; }
+
+  /* The accessors return references to the fields of the term; the get_ functions return copies. */
+  const TermId &id() const { return id_; }
+  std::string_view label() const { return label_; }
+  std::string_view definition() const { materialize(); return definition_; }
+  const vector<Xref> &definition_xrefs() const { materialize(); return definition_xref_list_; }
+  const vector<Xref> &term_xrefs() const { materialize(); return term_xref_list_; }
+  const vector<TermId> &alternative_ids() const { return alternative_id_list_; }
+  const vector<PredicateValue> &property_values() const { materialize(); return property_values_; }
+  const vector<Synonym> &synonyms() const { materialize(); return synonym_list_; }
 
   TermId get_term_id() const { return id_; }
-  string get_label() const { return label_; }
-  string get_definition() const { return definition_; }
-  vector<Xref> get_definition_xref_list() const { return definition_xref_list_;}
-  vector<Xref> get_term_xref_list() const {return term_xref_list_;}
+  string get_label() const { return string(label()); }
+  string get_definition() const { return string(definition()); }
+  vector<Xref> get_definition_xref_list() const { return definition_xrefs(); }
+  vector<Xref> get_term_xref_list() const { return term_xrefs(); }
   bool has_alternative_ids() const { return ! alternative_id_list_.empty(); }
-  vector<TermId> get_alternative_ids() const { return alternative_id_list_; }
-  vector<PredicateValue> get_property_values() const { return property_values_; }
+  vector<TermId> get_alternative_ids() const { return alternative_ids(); }
+  vector<PredicateValue> get_property_values() const { return property_values(); }
   vector<TermId> get_isa_parents(const TermId &child) const;
-  vector<Synonym> get_synonyms() const { return synonym_list_; }
+  vector<Synonym> get_synonyms() const { return synonyms(); }
   void set_obsolete(bool obs) { is_obsolete_ = obs; }
   bool obsolete() const { return is_obsolete_; }
   bool is_alternative_id(const TermId &tid) const;
-  bool contains_xref_with_prefix(const string &prefix) const;
-  tm get_creation_date() const;
+  bool contains_xref_with_prefix(std::string_view prefix) const;
+  /** Terms without a creation date are taken to be from 2008 (the year the HPO was started). */
+  static constexpr CivilDate DEFAULT_CREATION_DATE{2008, 1, 1};
+  /** @return the creation date (CREATION_DATE or DATE property), or DEFAULT_CREATION_DATE. */
+  CivilDate get_creation_date() const;
   friend std::ostream& operator<<(std::ostream& ost, const Term& term);
 };
 std::ostream& operator<<(std::ostream& ost, const Term& term);
 
+/**
+ * Read-only view of a contiguous sequence of the elements of a term, e.g., its synonyms.
+ * It refers to the storage of the Ontology and is valid as long as the Ontology exists.
+ */
+template <typename T>
+class TermRange {
+private:
+  const T *begin_ = nullptr;
+  const T *end_ = nullptr;
+
+public:
+  TermRange() = default;
+  TermRange(const T *begin, const T *end): begin_(begin), end_(end) {}
+  explicit TermRange(const vector<T> &v): begin_(v.data()), end_(v.data() + v.size()) {}
+  const T *begin() const { return begin_; }
+  const T *end() const { return end_; }
+  size_t size() const { return end_ - begin_; }
+  bool empty() const { return begin_ == end_; }
+  const T &operator[](size_t i) const { return begin_[i]; }
+  const T &at(size_t i) const;
+  vector<T> to_vector() const { return vector<T>(begin_, end_); }
+};
+
+template <typename T>
+const T &
+TermRange<T>::at(size_t i) const
+{
+  if (i >= size()) {
+    throw std::out_of_range("TermRange::at: " + std::to_string(i));
+  }
+  return begin_[i];
+}
+
+/**
+ * The terms of an Ontology, stored column by column rather than as one heap object per term.
+ * Term i has its id in ids_[i], its label in labels_[i], and so on; sequences such as the
+ * synonyms of all terms are kept in one pool per field. The strings themselves are in the
+ * StringArena.
+ * The Ontology adds the current terms first, in the order of current_term_ids_, so that the
+ * index of a current term is its vertex index in the CSR arrays; the obsolete terms follow.
+ * A scan over the labels or obsolete flags of all terms thus reads contiguous memory.
+ *
+ * The details (definition, xrefs, property values, synonyms) of lazily loaded terms are not in
+ * the pools; they are decoded into a Term when they are first requested and kept. The const
+ * accessors may be called on several threads at once, also for lazy terms: the decoded Term
+ * is published atomically, so every thread sees the same details (if two threads decode the
+ * same term at once, one of the copies is discarded). The decoded definitions are interned
+ * in the StringArena, so decoding a term again (after a race, in a copy of the store, or in
+ * another load of the same file) does not grow the arena. Appending terms is not thread safe.
+ */
+class TermStore {
+private:
+  friend class OntologySnapshot;
+  vector<TermId> ids_;
+  /** The labels and definitions are views into the StringArena. */
+  vector<std::string_view> labels_;
+  vector<bool> obsolete_;
+  /** Empty if the term has no creation date (or it has not been decoded yet). */
+  vector<CivilDate> creation_dates_;
+  vector<TermId> alternative_ids_;
+  vector<uint32_t> alternative_id_offsets_{0};
+  vector<std::string_view> definitions_;
+  vector<Xref> definition_xrefs_;
+  vector<uint32_t> definition_xref_offsets_{0};
+  vector<Xref> term_xrefs_;
+  vector<uint32_t> term_xref_offsets_{0};
+  vector<PredicateValue> property_values_;
+  vector<uint32_t> property_value_offsets_{0};
+  vector<Synonym> synonyms_;
+  vector<uint32_t> synonym_offsets_{0};
+  /**
+   * Byte range of the details of a lazily loaded term in the input of lazy_source_, and the
+   * details once they have been decoded (owned by the range). Copying or moving a range is not
+   * atomic, which is fine because ranges are only copied or moved with the whole store. A copy
+   * does not share the details; it decodes them again.
+   */
+  struct LazyRange {
+    size_t begin = 0;
+    size_t end = 0;
+    mutable std::atomic<const Term *> details{nullptr};
+    LazyRange() = default;
+    LazyRange(size_t b, size_t e): begin(b), end(e) {}
+    LazyRange(const LazyRange &other): begin(other.begin), end(other.end) {}
+    LazyRange(LazyRange &&other) noexcept;
+    LazyRange &operator=(const LazyRange &other);
+    LazyRange &operator=(LazyRange &&other) noexcept;
+    ~LazyRange();
+  };
+  std::shared_ptr<const LazyTermSource> lazy_source_;
+  /** Only as long as the index of the last lazily loaded term. */
+  vector<LazyRange> lazy_ranges_;
+  /** @return the decoded details of a lazily loaded term, or nullptr if the details of term i are in the pools. Thread safe. */
+  const Term *lazy_details(int i) const;
+  template <typename T>
+  static TermRange<T> pool_range(const vector<T> &pool, const vector<uint32_t> &offsets, int i)
+  {
+    return TermRange<T>(pool.data() + offsets[i], pool.data() + offsets[i + 1]);
+  }
+
+public:
+  void reserve(size_t n);
+  /** Make room for the terms and for all their strings and lists, so that the pools are allocated once. */
+  void reserve(const vector<Term*> &terms);
+  /** Move term into the store. @return its index. */
+  int append(Term &&term);
+  size_t size() const { return ids_.size(); }
+  bool empty() const { return ids_.empty(); }
+  const TermId &id(int i) const { return ids_[i]; }
+  std::string_view label(int i) const { return labels_[i]; }
+  bool obsolete(int i) const { return obsolete_[i]; }
+  /** @return the creation date of term i, or an empty date if it has none. */
+  CivilDate creation_date(int i) const;
+  /** @return the number of the terms 0..n-1 that were created in window (see Term::DEFAULT_CREATION_DATE). */
+  int count_created_in(const DateWindow &window, int n) const;
+  TermRange<TermId> alternative_ids(int i) const { return pool_range(alternative_ids_, alternative_id_offsets_, i); }
+  std::string_view definition(int i) const;
+  TermRange<Xref> definition_xrefs(int i) const;
+  TermRange<Xref> term_xrefs(int i) const;
+  TermRange<PredicateValue> property_values(int i) const;
+  TermRange<Synonym> synonyms(int i) const;
+  bool is_materialized(int i) const;
+  struct LazyStats {
+    /** Number of lazily loaded terms, and how many of them have been decoded. */
+    size_t terms = 0;
+    size_t decoded = 0;
+    /** Length of the definitions of the decoded terms (interned in the StringArena). */
+    size_t definition_bytes = 0;
+  };
+  LazyStats lazy_stats() const;
+  /** @return a copy of term i as a Term object; the details of a lazy term are copied undecoded. */
+  Term to_term(int i) const;
+};
+
+/**
+ * Reference to a term of an Ontology (see Ontology::term); an empty view means that the
+ * term was not found. A view is valid as long as the Ontology exists. The accessors read
+ * the columns of the TermStore, and the details of lazily loaded terms are decoded once,
+ * when they are first used; views may be used on several threads at once (see TermStore).
+ * As with std::optional, the term can be used via ->, e.g., view->label().
+ */
+class TermView {
+private:
+  const TermStore *store_ = nullptr;
+  int index_ = -1;
+
+public:
+  TermView() = default;
+  TermView(const TermStore *store, int index): store_(store), index_(index) {}
+  explicit operator bool() const { return store_ != nullptr; }
+  bool has_value() const { return store_ != nullptr; }
+  const TermView *operator->() const { return this; }
+  /** @return the index of the term in the TermStore; for a current term, this is its vertex index. */
+  int index() const { return index_; }
+  const TermId &id() const { return store_->id(index_); }
+  std::string_view label() const { return store_->label(index_); }
+  std::string_view definition() const { return store_->definition(index_); }
+  TermRange<Xref> definition_xrefs() const { return store_->definition_xrefs(index_); }
+  TermRange<Xref> term_xrefs() const { return store_->term_xrefs(index_); }
+  TermRange<TermId> alternative_ids() const { return store_->alternative_ids(index_); }
+  TermRange<PredicateValue> property_values() const { return store_->property_values(index_); }
+  TermRange<Synonym> synonyms() const { return store_->synonyms(index_); }
+  bool obsolete() const { return store_->obsolete(index_); }
+  bool is_materialized() const { return store_->is_materialized(index_); }
+  string get_label() const { return string(label()); }
+  string get_definition() const { return string(definition()); }
+  bool has_alternative_ids() const { return ! alternative_ids().empty(); }
+  bool is_alternative_id(const TermId &tid) const;
+  bool contains_xref_with_prefix(std::string_view prefix) const;
+  /** @return true if one of xrefs is a TermId with the given prefix. */
+  static bool contains_xref_with_prefix(TermRange<Xref> xrefs, std::string_view prefix);
+  CivilDate get_creation_date() const;
+  /** @return a copy of the term as a Term object. */
+  Term to_term() const { return store_->to_term(index_); }
+};
+
+
+class OntologyBuilder;
 
 class Ontology {
 private:
+  friend class OntologySnapshot;
+  friend class OntologyBuilder;
   string id_;
-  int original_edge_count_;
+  /** Version IRI from the meta element of the ontology, e.g., http://purl.obolibrary.org/obo/hp/releases/2019-09-06 */
+  string version_;
+  int original_edge_count_ = 0;
   vector<PredicateValue> predicate_values_;
   vector<Property> property_list_;
-  map<TermId, std::shared_ptr<Term> > term_map_;
+  /** The terms; the current terms come first, at their vertex indices. */
+  TermStore terms_;
+  /** Key: primary and alternative ids. Value: index of the term in terms_. */
+  TermIdMap<int> term_index_;
   /** Current primary TermId's. */
   vector<TermId> current_term_ids_;
   /** obsoleted and alt ids. */
   vector<TermId> obsolete_term_ids_;
   /** Key: a TermId object. Value: Corresponding index in current_term_ids_. */
-  map<TermId, int> termid_to_index_;
+  TermIdMap<int> termid_to_index_;
   /**  offset_e stores offsets into e_to that indicate where the adjacency lists begin.
   The list for an arbitrary vertex begins at e_to[offset_e[v]] and ends at
   e_to[offset_e[v+1]]-1. */
@@ -143,12 +403,25 @@ private:
   vector<EdgeType> edge_type_list_;
 
   int is_a_edge_count_ = 0;
+  /** The is_a ancestors of each vertex; only built on request (see build_ancestor_closure). */
+  AncestorClosure ancestor_closure_;
+  /** Interval labels of the is_a graph for exists_path; only built on request (see build_reachability_index). */
+  ReachabilityIndex reachability_index_;
   /** Some edges are for the logical definitions. By default we skip these edges and only
    * include edges between vertices in the main node section of the json file. This variable
    * counts the number of edges skipped for this reason.
    */
-  int skipped_edge_count_;
-  bool valid_edge(Edge e) const;
+  int skipped_edge_count_ = 0;
+  int vertex_index(const TermId &tid) const;
+  void resolve_edge_indices(const vector<Edge> &edges, vector<int> &source, vector<int> &destination, unsigned int threads) const;
+  /** Used by OntologySnapshot, which fills in the remaining fields. */
+  explicit Ontology(const string &id): id_(id) {}
+  /** Used by OntologyBuilder::build; takes over the builder's terms and edges. */
+  explicit Ontology(OntologyBuilder &&builder);
+  void add_all_terms(vector<Term> &&terms);
+  void add_all_edges(const vector<Edge> &edges, bool edge_lenient, unsigned int threads);
+  /** Drop repeated edges (same source, destination and type) from the CSR arrays. */
+  void remove_duplicate_edges();
 
 
 public:
@@ -164,40 +437,81 @@ public:
           const vector<PredicateValue> &predicates,
           const vector<Property> &properties,
           bool edge_lenient);
-  Ontology(const Ontology &other);
-  Ontology(Ontology &other);
-  Ontology& operator=(const Ontology &other);
-  Ontology& operator=(Ontology &&other);
+  /** Copies and moves take all members, including the CSR arrays and the indexes built from them. */
+  Ontology(const Ontology &other) = default;
+  Ontology(Ontology &&other) = default;
+  Ontology& operator=(const Ontology &other) = default;
+  Ontology& operator=(Ontology &&other) = default;
   ~Ontology(){}
   void set_id(const string &id) { id_ = id; }
+  const string &id() const { return id_; }
   string get_id() const { return id_; }
+  void set_version(const string &version) { version_ = version; }
+  const string &version() const { return version_; }
+  string get_version() const { return version_; }
   void add_predicate_value(const PredicateValue &propval);
   void add_property(const Property & prop);
   void add_all_terms(const vector<Term> &terms);
   void add_all_edges(vector<Edge> &edges, bool edge_lenient);
   int current_term_count() const { return current_term_ids_.size(); }
-  int total_term_id_count() const { return term_map_.size(); }
+  int total_term_id_count() const { return term_index_.size(); }
   int edge_count() const { return original_edge_count_; }
   int edge_count_with_supplemental_edges() const { return edge_to_.size(); }
   int is_a_edge_count() const { return is_a_edge_count_;}
   int predicate_count() const { return predicate_values_.size(); }
   int property_count() const { return property_list_.size(); }
+  /** @return a view of the term with the (primary or alternative) id tid; empty if there is none. */
+  TermView term(const TermId &tid) const;
+  /** @return a view of the current term with the vertex index i (0 <= i < current_term_count()). */
+  TermView term_at(int i) const { return TermView(&terms_, i); }
+  /** @return a copy of the term with id tid (prefer term, which does not copy). */
   std::optional<Term> get_term(const TermId &tid) const;
   vector<TermId> get_isa_parents(const TermId &child) const;
-  /** @return true if there exists a path from source to dest */
+  /**
+   * @return true if there exists a path of is_a edges from source to dest. Uses the ancestor
+   * closure or the reachability index, if one of them was built.
+   */
   bool exists_path(const TermId &source, const TermId &dest) const;
   /** @return true if there exists a path of edges that have the indicated edgetype. */
   bool exists_path(const TermId &source, const TermId &dest, EdgeType etype) const;
   /** @return true if t1 and t2 have a common ancestor excluding root */
   bool have_common_ancestor(const TermId &t1, const TermId &t2, const TermId &root) const;
+  /** @return tid and its is_a ancestors; uses the ancestor closure if it was built. */
   std::set<TermId> get_ancestors(const TermId &tid) const;
+  /**
+   * Compute the is_a ancestors of all current terms (see AncestorClosure). Worthwhile before
+   * many ancestor queries; the closure is discarded if terms or edges are added afterwards.
+   */
+  void build_ancestor_closure();
+  bool has_ancestor_closure() const { return ancestor_closure_.built(); }
+  const AncestorClosure &ancestor_closure() const { return ancestor_closure_; }
+  /**
+   * @return the vertex indices of tid and its is_a ancestors, sorted; the TermId of vertex i is
+   * current_term_ids()[i]. Requires the ancestor closure.
+   */
+  TermRange<int> get_ancestor_indices(const TermId &tid) const;
+  /** @return true if ancestor is tid or one of its is_a ancestors (false if either is not a current term). */
+  bool is_ancestor(const TermId &ancestor, const TermId &tid) const;
+  /**
+   * Label the is_a graph so that exists_path answers most queries without a search (see
+   * ReachabilityIndex). It is smaller than the ancestor closure and quicker to build; the index
+   * is discarded if terms or edges are added afterwards.
+   */
+  void build_reachability_index(int traversals = 5);
+  bool has_reachability_index() const { return reachability_index_.built(); }
+  const ReachabilityIndex &reachability_index() const { return reachability_index_; }
   Ontology(vector<Term> terms,vector<Edge> edges,string id, vector<PredicateValue> properties);
+  /** @return the ids of the current (non-obsolete) terms, sorted. */
+  const vector<TermId> &current_term_ids() const { return current_term_ids_; }
   vector<TermId> get_current_term_ids() const { return current_term_ids_; }
   void debug_print() const;
   /** Output basic descriptive statistics about the ontology.*/
   void output_descriptive_statistics(std::ostream& s = std::cout) const;
   friend std::ostream& operator<<(std::ostream& ost, const Ontology& ontology);
-  int filter_terms(std::function<bool(Term*)> f, std::ostream& s = std::cout);
+  /** @return the number of current terms for which f returns true. */
+  int filter_terms(std::function<bool(const TermView&)> f) const;
+  /** @return the number of current terms that were created in window; a scan of the creation date column. */
+  int count_terms_created_in(const DateWindow &window) const { return terms_.count_created_in(window, current_term_count()); }
   vector<TermId> get_descendant_term_ids(const TermId &sourceTid) const;
 };
 std::ostream& operator<<(std::ostream& ost, const Ontology& ontology);
@@ -0,0 +1,18 @@
+/**
+ * @file ontologybuilder.cc
+ * @brief Collects the terms, edges and metadata of an ontology and hands them over to Ontology.
+ */
+#include "ontologybuilder.h"
+
+std::unique_ptr<Ontology>
+OntologyBuilder::build()
+{
+  // the constructor is private to Ontology and OntologyBuilder
+  std::unique_ptr<Ontology> ontology{new Ontology(std::move(*this))};
+  // release the memory of the buffers, not just their elements
+  terms_ = vector<Term>();
+  edges_ = vector<Edge>();
+  predicate_values_ = vector<PredicateValue>();
+  properties_ = vector<Property>();
+  return ontology;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file ontologybuilder.h
+ * @brief Collects the terms, edges and metadata of an ontology and hands them over to Ontology.
+ * @author Peter N Robinson
+ *
+ * The builder owns the buffers that a parser fills (terms, edges, property values
+ * and properties). build() moves them into the Ontology, which constructs its term
+ * map and CSR graph directly from them, so that no Term or Edge is copied on the way. The
+ * builder is move-only, to make accidental copies of these buffers impossible.
+ */
+#ifndef ONTOLOGYBUILDER_H
+#define ONTOLOGYBUILDER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "ontology.h"
+
+using std::string;
+using std::vector;
+
+class OntologyBuilder {
+private:
+  friend class Ontology;
+  string id_;
+  string version_;
+  vector<Term> terms_;
+  vector<Edge> edges_;
+  vector<PredicateValue> predicate_values_;
+  vector<Property> properties_;
+  /** If true, skip edges where we do not have the corresponding term (see Ontology::add_all_edges). */
+  bool edge_lenient_ = true;
+  /** Number of threads used to look up the vertices of the edges (0: one per core). */
+  unsigned int threads_ = 1;
+
+public:
+  explicit OntologyBuilder(const string &id) : id_(id) {}
+  OntologyBuilder(const OntologyBuilder &) = delete;
+  OntologyBuilder &operator=(const OntologyBuilder &) = delete;
+  OntologyBuilder(OntologyBuilder &&) = default;
+  OntologyBuilder &operator=(OntologyBuilder &&) = default;
+
+  OntologyBuilder &set_version(const string &version) { version_ = version; return *this; }
+  OntologyBuilder &set_terms(vector<Term> &&terms) { terms_ = std::move(terms); return *this; }
+  OntologyBuilder &set_edges(vector<Edge> &&edges) { edges_ = std::move(edges); return *this; }
+  OntologyBuilder &set_predicate_values(vector<PredicateValue> &&pvs) { predicate_values_ = std::move(pvs); return *this; }
+  OntologyBuilder &set_properties(vector<Property> &&properties) { properties_ = std::move(properties); return *this; }
+  OntologyBuilder &set_edge_lenient(bool lenient) { edge_lenient_ = lenient; return *this; }
+  OntologyBuilder &set_threads(unsigned int threads) { threads_ = threads; return *this; }
+
+  const string &get_id() const { return id_; }
+  const vector<Term> &get_terms() const { return terms_; }
+  const vector<Edge> &get_edges() const { return edges_; }
+  const vector<PredicateValue> &get_predicate_values() const { return predicate_values_; }
+  const vector<Property> &get_properties() const { return properties_; }
+
+  /** Create the Ontology from the collected data. The builder is empty afterwards. */
+  std::unique_ptr<Ontology> build();
+};
+
+#endif
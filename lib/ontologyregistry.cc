@@ -0,0 +1,173 @@
+/**
+ * @file ontologyregistry.cc
+ * @brief The ontologies of a run, keyed by the prefix of their term ids (HP, MONDO, GENO, ...).
+ */
+#include "ontologyregistry.h"
+#include "inputstream.h"
+#include "oboparser.h"
+#include "snapshot.h"
+#include "myexception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <thread>
+
+namespace {
+/** Formatted errors, followed by a line with the number of errors that were not retained. */
+void append_parse_errors(const vector<string> &formatted, const OboParseErrorList &records, vector<string> &errors)
+{
+  errors.insert(errors.end(), formatted.begin(), formatted.end());
+  if (records.dropped() > 0)
+  {
+    errors.push_back(std::to_string(records.dropped()) + " further errors were not retained (total: " +
+                     std::to_string(records.total()) + ")");
+  }
+}
+}
+
+string OntologyRegistry::key(const string &prefix)
+{
+  string k = prefix;
+  std::transform(k.begin(), k.end(), k.begin(), [](unsigned char c) { return std::toupper(c); });
+  return k;
+}
+
+void OntologyRegistry::add(const string &prefix, const string &path)
+{
+  Entry &e = entries_[key(prefix)];
+  if (e.path != path)
+  {
+    e.path = path;
+    e.ontology.reset();
+    e.errors.clear();
+  }
+}
+
+std::unique_ptr<Ontology>
+OntologyRegistry::load_file(const string &path, LoadProfile profile, vector<string> &errors, unsigned int threads)
+{
+  if (OntologySnapshot::is_snapshot(path))
+  {
+    TermLoading loading = profile == LoadProfile::FULL ? TermLoading::EAGER : TermLoading::LAZY;
+    std::unique_ptr<Ontology> ontology = OntologySnapshot::load(path, loading);
+    std::cout << "[INFO] Loaded snapshot of " << ontology->get_id() << " (" << ontology->get_version() << ")\n";
+    return ontology;
+  }
+  if (OboParser::is_obo_file(path))
+  {
+    OboOptions options;
+    options.profile = profile;
+    options.threads = threads;
+    OboParser parser{path, options};
+    append_parse_errors(parser.get_errors(), parser.get_error_records(), errors);
+    return parser.get_ontology();
+  }
+  JsonOboOptions options;
+  // the DOM parser converts the nodes on several threads; a compressed file is streamed, so
+  // that parsing overlaps with the decompression
+  options.mode = detect_compression(path) == Compression::NONE ? JsonParseMode::DOM : JsonParseMode::STREAMING;
+  options.profile = profile;
+  options.threads = threads;
+  JsonOboParser parser{path, options};
+  append_parse_errors(parser.get_errors(), parser.get_error_records(), errors);
+  return parser.get_ontology();
+}
+
+/**
+ * Each file is loaded once, even if several prefixes refer to it. The workers take the
+ * next file from a shared counter and only write to their own slot of the results. The
+ * threads are shared among the workers, which pass their share on to the parsers.
+ */
+void OntologyRegistry::load(LoadProfile profile, unsigned int threads)
+{
+  vector<string> paths;
+  for (const auto &p : entries_)
+  {
+    if (!p.second.ontology && std::find(paths.begin(), paths.end(), p.second.path) == paths.end())
+    {
+      paths.push_back(p.second.path);
+    }
+  }
+  vector<std::shared_ptr<const Ontology>> ontologies(paths.size());
+  vector<vector<string>> errors(paths.size());
+  if (threads == 0)
+  {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  size_t n_workers = std::min<size_t>(threads, paths.size());
+  unsigned int parser_threads = std::max<unsigned int>(1, threads / std::max<size_t>(1, n_workers));
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next++; i < paths.size(); i = next++)
+    {
+      try
+      {
+        ontologies[i] = OntologyRegistry::load_file(paths[i], profile, errors[i], parser_threads);
+      }
+      catch (const PhenopacketException &e)
+      {
+        errors[i].push_back("Could not load ontology " + paths[i] + ": " + e.what());
+      }
+    }
+  };
+  if (n_workers <= 1)
+  {
+    worker();
+  }
+  else
+  {
+    vector<std::thread> workers;
+    for (size_t w = 0; w < n_workers; ++w)
+    {
+      workers.emplace_back(worker);
+    }
+    for (std::thread &t : workers)
+    {
+      t.join();
+    }
+  }
+  for (auto &p : entries_)
+  {
+    auto it = std::find(paths.begin(), paths.end(), p.second.path);
+    if (it != paths.end())
+    {
+      size_t i = it - paths.begin();
+      p.second.ontology = ontologies[i];
+      p.second.errors = errors[i];
+    }
+  }
+}
+
+const Ontology *
+OntologyRegistry::get(const string &prefix) const
+{
+  auto p = entries_.find(key(prefix));
+  if (p == entries_.end())
+  {
+    return nullptr;
+  }
+  return p->second.ontology.get();
+}
+
+vector<string>
+OntologyRegistry::get_prefixes() const
+{
+  vector<string> prefixes;
+  for (const auto &p : entries_)
+  {
+    prefixes.push_back(p.first);
+  }
+  return prefixes;
+}
+
+vector<string>
+OntologyRegistry::get_errors(const string &prefix) const
+{
+  auto p = entries_.find(key(prefix));
+  if (p == entries_.end())
+  {
+    return vector<string>();
+  }
+  return p->second.errors;
+}
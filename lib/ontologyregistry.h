@@ -0,0 +1,66 @@
+/**
+ * @file ontologyregistry.h
+ * @brief The ontologies of a run, keyed by the prefix of their term ids (HP, MONDO, GENO, ...).
+ * @author Peter N Robinson
+ *
+ * A phenopacket uses terms of several ontologies (see MetaData::get_prefixes). The
+ * registry records which file holds the ontology for each prefix, loads all of them
+ * at once on separate threads, and keeps them for the lifetime of the registry, so
+ * that each file is parsed only once even if it serves several prefixes.
+ */
+#ifndef ONTOLOGYREGISTRY_H
+#define ONTOLOGYREGISTRY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+#include "ontology.h"
+#include "jsonobo.h"
+
+using std::string;
+using std::vector;
+using std::map;
+
+class OntologyRegistry {
+private:
+  struct Entry {
+    string path;
+    std::shared_ptr<const Ontology> ontology;
+    /** Parse errors of the file (shared by all prefixes that use the same file). */
+    vector<string> errors;
+  };
+  /** Key: upper-case prefix, e.g., HP. */
+  map<string, Entry> entries_;
+  static string key(const string &prefix);
+
+public:
+  OntologyRegistry() = default;
+  OntologyRegistry(const OntologyRegistry &) = delete;
+  OntologyRegistry &operator=(const OntologyRegistry &) = delete;
+  /** Use the ontology file at path (JSON, OBO or snapshot) for the terms with the given prefix. */
+  void add(const string &prefix, const string &path);
+  /** Load the files that have not been loaded yet, each on its own thread (at most threads at once, 0: one per core). */
+  void load(LoadProfile profile, unsigned int threads = 0);
+  bool has_ontology(const string &prefix) const { return get(prefix) != nullptr; }
+  /** @return the ontology for prefix, or nullptr if none was registered or it could not be loaded. */
+  const Ontology *get(const string &prefix) const;
+  /** @return the registered prefixes (upper case). */
+  vector<string> get_prefixes() const;
+  /** @return the errors encountered while loading the ontology for prefix. */
+  vector<string> get_errors(const string &prefix) const;
+  /**
+   * Load one ontology file: a binary snapshot (see OntologySnapshot), an .obo file, or OBO-JSON.
+   * Unless the profile is FULL, the term details of snapshots are loaded lazily. Uncompressed
+   * JSON is parsed into a DOM whose nodes are converted on threads threads (0: one per core);
+   * compressed JSON is parsed while it is decompressed. JSON terms are not loaded lazily (see
+   * JsonOboOptions::lazy_terms); the profile decides which of their fields are built. The parse
+   * errors are appended to errors; throws PhenopacketException if the file cannot be read or a
+   * snapshot cannot be loaded.
+   */
+  static std::unique_ptr<Ontology> load_file(const string &path, LoadProfile profile, vector<string> &errors,
+                                             unsigned int threads = 0);
+};
+
+#endif
@@ -12,6 +12,7 @@
 
 
 #include "phenotools.h"
+#include "ontologyregistry.h"
 #include <google/protobuf/timestamp.pb.h>
 #include <google/protobuf/util/time_util.h>
 #include <time.h>
@@ -1307,8 +1308,7 @@ std::ostream &operator<<(std::ostream& ost, const HtsFormat htsf)
         observed.push_back(tid);
       }
       // check whether the term is represented in the Ontology
-      std::optional<Term> term_opt = ontology_p->get_term(tid);
-      if (! term_opt) {
+      if (! ontology_p->term(tid)) {
         std::stringstream sstr;
         sstr << "[ERROR] Could not find " << tid.get_value()
             << " in the ontology";
@@ -1316,25 +1316,86 @@ std::ostream &operator<<(std::ostream& ost, const HtsFormat htsf)
         validation.push_back(v);
       }
     }
+    validate_redundant_terms(*ontology_p, observed, validation);
+    validate_metadata_prefixes(validation);
+    if (validation.empty()) {
+      std::cout << "[INFO] Semantic validation identified no errors.\n";
+    } else {
+      std::cout << "[INFO] Semantic validation identified " << validation.size() <<" issues\n";
+    }
+    return validation;
+
+  }
+
+  /**
+   * Each term is checked against the ontology registered for its prefix; terms of
+   * ontologies that are not in the registry are not checked. The redundancy check is
+   * done separately for the observed features of each ontology.
+   */
+  vector<Validation>
+  Phenopacket::semantically_validate(const OntologyRegistry &registry) const
+  {
+    vector<Validation> validation;
+    for (const string &id : get_ontology_class_ids()) {
+      if (id.find(':') == string::npos) {
+        continue; // reported by validate()
+      }
+      TermId tid = TermId::from_string(id);
+      const Ontology *ontology = registry.get(tid.get_prefix());
+      if (ontology != nullptr && ! ontology->term(tid)) {
+        std::stringstream sstr;
+        sstr << "[ERROR] Could not find " << tid.get_value()
+            << " in the " << tid.get_prefix() << " ontology";
+        Validation v = Validation::createError(ValidationCause::UNRECOGNIZED_TERMID, sstr.str());
+        validation.push_back(v);
+      }
+    }
+    map<string, vector<TermId>> observed_by_prefix;
+    for (auto pf : phenotypic_features_) {
+      if (! pf.is_negated() && pf.get_id().find(':') != string::npos) {
+        TermId tid = TermId::from_string(pf.get_id());
+        observed_by_prefix[tid.get_prefix()].push_back(tid);
+      }
+    }
+    for (const auto &p : observed_by_prefix) {
+      const Ontology *ontology = registry.get(p.first);
+      if (ontology != nullptr) {
+        validate_redundant_terms(*ontology, p.second, validation);
+      }
+    }
+    validate_metadata_prefixes(validation);
+    if (validation.empty()) {
+      std::cout << "[INFO] Semantic validation identified no errors.\n";
+    } else {
+      std::cout << "[INFO] Semantic validation identified " << validation.size() <<" issues\n";
+    }
+    return validation;
+  }
+
+  void
+  Phenopacket::validate_redundant_terms(const Ontology &ontology,
+                                        const vector<TermId> &observed,
+                                        vector<Validation> &validation) const
+  {
     for (auto i =0u; i < observed.size(); i++) {
       for (auto j = i+1; j < observed.size(); j++) {
-        if (ontology_p->exists_path(observed.at(i), observed.at(j), EdgeType::IS_A)) {
+        if (ontology.exists_path(observed.at(i), observed.at(j), EdgeType::IS_A)) {
           // if we get here, then the phenopacket includes
           // two terms which are ancestor-descendent to each other
           std::stringstream sstr;
           sstr << "[ERROR] Redundant terms: ";
-          string label_i = ontology_p->get_term(observed.at(i))->get_label();
-          string label_j = ontology_p->get_term(observed.at(j))->get_label();
+          std::string_view label_i = ontology.term(observed.at(i))->label();
+          std::string_view label_j = ontology.term(observed.at(j))->label();
           sstr << observed.at(i) << "(" << label_i << ")";
           sstr << " is a subclass of " << observed.at(j) << "(" << label_j << ")";
           Validation v = Validation::createError(ValidationCause::REDUNDANT_ANNOTATION, sstr.str());
           validation.push_back(v);
         }
-        if (ontology_p->exists_path(observed.at(j), observed.at(i), EdgeType::IS_A)) {
+        if (ontology.exists_path(observed.at(j), observed.at(i), EdgeType::IS_A)) {
           std::stringstream sstr;
           sstr << "[ERROR] Redundant terms: ";
-          string label_i = ontology_p->get_term(observed.at(i))->get_label();
-          string label_j = ontology_p->get_term(observed.at(j))->get_label();
+          std::string_view label_i = ontology.term(observed.at(i))->label();
+          std::string_view label_j = ontology.term(observed.at(j))->label();
           sstr << observed.at(j) << "(" << label_j << ")";
           sstr << " is a subclass of " << observed.at(i) << "(" << label_i << ")";
           Validation v = Validation::createError(ValidationCause::REDUNDANT_ANNOTATION, sstr.str());
@@ -1342,15 +1403,32 @@ std::ostream &operator<<(std::ostream& ost, const HtsFormat htsf)
         }
       }
     }
-    
-    validate_metadata_prefixes(validation);
-    if (validation.empty()) {
-      std::cout << "[INFO] Semantic validation identified no errors.\n";
-    } else {
-      std::cout << "[INFO] Semantic validation identified " << validation.size() <<" issues\n";
-    }
-    return validation;
+  }
 
+  vector<string>
+  Phenopacket::get_ontology_class_ids() const
+  {
+    vector<string> ids;
+    if (subject_ && subject_->get_taxon() != nullptr) {
+      ids.push_back(subject_->get_taxon()->get_id());
+    }
+    for (const Disease &d : diseases_) {
+      if (d.get_term() != nullptr) {
+        ids.push_back(d.get_term()->get_id());
+      }
+      if (d.has_class_of_onset()) {
+        ids.push_back(d.get_class_of_onset()->get_id());
+      }
+    }
+    for (const PhenotypicFeature &pf : phenotypic_features_) {
+      ids.push_back(pf.get_id());
+    }
+    for (const Variant &v : variants_) {
+      if (v.has_zygosity()) {
+        ids.push_back(v.get_zygosity()->get_id());
+      }
+    }
+    return ids;
   }
 
 
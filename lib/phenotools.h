@@ -12,6 +12,8 @@
 #include "base.pb.h"
 #include "ontology.h"
 
+class OntologyRegistry;
+
 using std::unique_ptr;
 using std::shared_ptr;
 using std::make_shared;
@@ -378,7 +380,7 @@ namespace phenotools {
     shared_ptr<Age> get_age_of_onset() const { return age_of_onset_; }
     bool has_age_range_of_onset() const { return nullptr != age_range_of_onset_; }
     shared_ptr<AgeRange> get_age_range_of_onset() const { return age_range_of_onset_; }
-    bool has_class_of_onset() { return nullptr != class_of_onset_; }
+    bool has_class_of_onset() const { return nullptr != class_of_onset_; }
     shared_ptr<OntologyClass> get_class_of_onset() const { return class_of_onset_; }
     friend std::ostream &operator<<(std::ostream& ost, const Disease& dis);
   };
@@ -527,12 +529,20 @@ namespace phenotools {
     shared_ptr<MetaData> metadata_;
     /** Check the semantics and consistency of the phenopacket. */
     void validate_metadata_prefixes(vector<Validation> &v) const;
+    /** @return the ids of all OntologyClass elements (taxon, diseases, phenotypic features, zygosity). */
+    vector<string> get_ontology_class_ids() const;
+    /** Report pairs of observed terms where one is a subclass of the other. */
+    void validate_redundant_terms(const Ontology &ontology,
+                                  const vector<TermId> &observed,
+                                  vector<Validation> &validation) const;
 
   public:
     Phenopacket(const org::phenopackets::schema::v1::Phenopacket &pp) ;
     ~Phenopacket(){}
     vector<Validation> validate() const;
     vector<Validation> semantically_validate(const std::unique_ptr<Ontology> &ptr) const;
+    /** Check the terms of every ontology in the registry, looking up the ontology by the prefix of each term. */
+    vector<Validation> semantically_validate(const OntologyRegistry &registry) const;
     void validate(vector<Validation> &v) const {}
     friend std::ostream& operator<<(std::ostream& ost, const Phenopacket& ppacket);
   };
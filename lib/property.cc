@@ -1,15 +1,14 @@
 #include "property.h"
 #include "myexception.h"
+#include "staticregistry.h"
 
 #include <iostream>
 using std::cerr;
 
 
-/**
- * map from String to value, static initialization.
- */
-map<string, Predicate>
-PredicateValue::predicate_registry_ = {
+namespace {
+/** The predicates of property values (the part after the last / of the IRI). */
+constexpr RegistryEntry<Predicate> PREDICATES[] = {
 		   {"oboInOwl#created_by", Predicate::CREATED_BY},
 		   {"oboInOwl#creation_date", Predicate::CREATION_DATE},
 		   {"oboInOwl#hasOBONamespace", Predicate::HAS_OBO_NAMESPACE},
@@ -49,16 +48,42 @@ PredicateValue::predicate_registry_ = {
 		   {"source",Predicate::SOURCE},
 		   {"homepage",Predicate::HOMEPAGE},
 };
+constexpr auto PREDICATE_REGISTRY = make_registry(PREDICATES);
+
+/** The ids of properties: labels, and the IRIs of the corresponding terms without their namespace. */
+constexpr RegistryEntry<AllowedPropertyValue> PROPERTIES[] = {
+  {"UK spelling", AllowedPropertyValue::UK_SPELLING},
+	{"HP_0045076", AllowedPropertyValue::UK_SPELLING},
+  {"abbreviation", AllowedPropertyValue::ABBREVIATION},
+	{"HP_0045077", AllowedPropertyValue::ABBREVIATION},
+  {"plural form", AllowedPropertyValue::PLURAL_FORM},
+	{"HP_0045078", AllowedPropertyValue::PLURAL_FORM},
+  {"layperson term", AllowedPropertyValue::LAYPERSON_TERM},
+	{"hp.owl#layperson", AllowedPropertyValue::LAYPERSON_TERM},
+  {"Consequence of a disorder in another organ system.", AllowedPropertyValue::CONSEQUENCE_OF_A_DISORDER_IN_ANOTHER_ORGAN_SYSTEM},
+	{"hp#secondary_consequence", AllowedPropertyValue::CONSEQUENCE_OF_A_DISORDER_IN_ANOTHER_ORGAN_SYSTEM},
+	{"display label", AllowedPropertyValue::DISPLAY_LABEL},
+	{"HP_0031940", AllowedPropertyValue::DISPLAY_LABEL},
+	{"hp#hposlim_core", AllowedPropertyValue::HPO_SLIM},
+	{"unknown", AllowedPropertyValue::UNKNOWN},
+	{"HP_0031859", AllowedPropertyValue::OBSOLETE_SYNONYM},
+	{"mondo#DUBIOUS", AllowedPropertyValue::DUBIOUS},
+	{"mondo#may_be_merged_into", AllowedPropertyValue::MAY_BE_MERGED_INTO},
+	{"RO_0002161", AllowedPropertyValue::NEVER_IN_TAXON},
+	{"RO_0002162", AllowedPropertyValue::IN_TAXON}
+};
+constexpr auto PROPERTY_REGISTRY = make_registry(PROPERTIES);
+}
 
 Predicate
-PredicateValue::string_to_predicate(const string &s)
+PredicateValue::string_to_predicate(std::string_view s)
 {
-  auto p = PredicateValue::predicate_registry_.find(s);
-  if (p == PredicateValue::predicate_registry_.end()) {
+  const Predicate *p = PREDICATE_REGISTRY.find(s);
+  if (p == nullptr) {
     cerr<< "[WARNING] Unrecognized property: " << s << "\n";
     return Predicate::UNKNOWN;
   }
-  return p->second;
+  return *p;
 }
 
 
@@ -84,76 +109,46 @@ std::ostream& operator<<(std::ostream& ost, const PredicateValue& pv) {
   return ost;
 }
 
-/**
- * map from String to value, static initialization.
- */
-map<string, AllowedPropertyValue>
-Property::property_registry_ = {
-  {"UK spelling", AllowedPropertyValue::UK_SPELLING},
-	{"HP_0045076", AllowedPropertyValue::UK_SPELLING},
-  {"abbreviation", AllowedPropertyValue::ABBREVIATION},
-	{"HP_0045077", AllowedPropertyValue::ABBREVIATION},
-  {"plural form", AllowedPropertyValue::PLURAL_FORM},
-	{"HP_0045078", AllowedPropertyValue::PLURAL_FORM},
-  {"layperson term", AllowedPropertyValue::LAYPERSON_TERM},
-	{"hp.owl#layperson", AllowedPropertyValue::LAYPERSON_TERM},
-  {"Consequence of a disorder in another organ system.", AllowedPropertyValue::CONSEQUENCE_OF_A_DISORDER_IN_ANOTHER_ORGAN_SYSTEM},
-	{"hp#secondary_consequence", AllowedPropertyValue::CONSEQUENCE_OF_A_DISORDER_IN_ANOTHER_ORGAN_SYSTEM},
-	{"display label", AllowedPropertyValue::DISPLAY_LABEL},
-	{"HP_0031940", AllowedPropertyValue::DISPLAY_LABEL},
-	{"hp#hposlim_core", AllowedPropertyValue::HPO_SLIM},
-	{"unknown", AllowedPropertyValue::UNKNOWN},
-	{"HP_0031859", AllowedPropertyValue::OBSOLETE_SYNONYM},
-	{"mondo#DUBIOUS", AllowedPropertyValue::DUBIOUS},
-	{"mondo#may_be_merged_into", AllowedPropertyValue::MAY_BE_MERGED_INTO},
-	{"RO_0002161", AllowedPropertyValue::NEVER_IN_TAXON},
-	{"RO_0002162", AllowedPropertyValue::IN_TAXON}
-};
 
 
-map<AllowedPropertyValue, string>
-Property::apv_to_label_ = {
-	{AllowedPropertyValue::UK_SPELLING, "UK spelling"},
-	{AllowedPropertyValue::ABBREVIATION, "abbreviation"},
-  {AllowedPropertyValue::PLURAL_FORM, "plural form"},
-  {AllowedPropertyValue::LAYPERSON_TERM, "layperson term"},
-  {AllowedPropertyValue::CONSEQUENCE_OF_A_DISORDER_IN_ANOTHER_ORGAN_SYSTEM, "secondary consequence"},
-  {AllowedPropertyValue::DISPLAY_LABEL, "display label"},
-  {AllowedPropertyValue::HPO_SLIM, "hpo slim"},
-  {AllowedPropertyValue::OBSOLETE_SYNONYM, "obsolete synonym"},
-  {AllowedPropertyValue::DUBIOUS, "dubious"},
-  {AllowedPropertyValue::MAY_BE_MERGED_INTO, "may_be_merged_into"},
-  {AllowedPropertyValue::UNKNOWN,"unknown"},
-  {AllowedPropertyValue::IN_TAXON,"IN_TAXON"},
-   {AllowedPropertyValue::NEVER_IN_TAXON,"NEVER_IN_TAXON"}
-};
-
+std::string_view
+Property::property_label(AllowedPropertyValue apv)
+{
+  switch (apv) {
+  case AllowedPropertyValue::UK_SPELLING: return "UK spelling";
+  case AllowedPropertyValue::ABBREVIATION: return "abbreviation";
+  case AllowedPropertyValue::PLURAL_FORM: return "plural form";
+  case AllowedPropertyValue::LAYPERSON_TERM: return "layperson term";
+  case AllowedPropertyValue::CONSEQUENCE_OF_A_DISORDER_IN_ANOTHER_ORGAN_SYSTEM: return "secondary consequence";
+  case AllowedPropertyValue::DISPLAY_LABEL: return "display label";
+  case AllowedPropertyValue::HPO_SLIM: return "hpo slim";
+  case AllowedPropertyValue::OBSOLETE_SYNONYM: return "obsolete synonym";
+  case AllowedPropertyValue::DUBIOUS: return "dubious";
+  case AllowedPropertyValue::MAY_BE_MERGED_INTO: return "may_be_merged_into";
+  case AllowedPropertyValue::UNKNOWN: return "unknown";
+  case AllowedPropertyValue::IN_TAXON: return "IN_TAXON";
+  case AllowedPropertyValue::NEVER_IN_TAXON: return "NEVER_IN_TAXON";
+  }
+  return std::string_view();
+}
 
 Property::Property(AllowedPropertyValue apv):
-	apv_(apv)
+	apv_(apv),
+	label_(property_label(apv))
 {
-	auto p = apv_to_label_.find(apv);
-	if (p != apv_to_label_.end()) {
-		label_ = p->second;
-	} else {
+	if (label_.empty()) {
 		cerr << "[ERROR] Could not find property label\n";
 	}
 }
 
 AllowedPropertyValue
-Property::id_to_property(const string &s)
+Property::id_to_property(std::string_view s)
 {
-	std::size_t i = s.find_last_of('/');
-	string prp = s;
-  	if (i != string::npos){
-    	prp = s.substr(i+1);;
-  	} 
-  	//cerr << "id_to_property: s="<<s<<", prp="<<prp<<"\n";
-  	auto p = Property::property_registry_.find(prp);
-  	if (p == Property ::property_registry_.end()) {
-		throw PhenopacketException("[WARNING] Unrecognized property: " + s);
+  	const AllowedPropertyValue *p = PROPERTY_REGISTRY.find(strip_iri(s));
+  	if (p == nullptr) {
+		throw PhenopacketException("[WARNING] Unrecognized property: " + string(s));
   	}
-  	return p->second;
+  	return *p;
 }
 
 Property::Property(const Property &p):
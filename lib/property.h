@@ -3,13 +3,13 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <string_view>
 
 #include "termid.h"
+#include "stringarena.h"
 //#include "myexception.h"
 
 using std::vector;
-using std::map;
 using std::string;
 
 enum class Predicate {
@@ -61,15 +61,17 @@ enum class Predicate {
 class PredicateValue {
 private:
   Predicate predicate_;
-  string value_;
-  static map<string, Predicate> predicate_registry_;
+  /** Interned in the StringArena; many values (creators, dates) repeat across terms. */
+  std::string_view value_;
 public:
-  PredicateValue(Predicate p, const string &v):predicate_(p),value_(v){}
+  PredicateValue(Predicate p, std::string_view v):predicate_(p),value_(StringArena::global().intern(v)){}
   //static PropertyValue of(const rapidjson::Value &val);
   bool is_alternate_id() const { return predicate_ == Predicate::HAS_ALTERNATIVE_ID; }
   Predicate get_property() const { return predicate_; }
-  string get_value() const { return value_; }
-  static Predicate string_to_predicate(const string &s);
+  std::string_view value() const { return value_; }
+  string get_value() const { return string(value_); }
+  /** Look up a predicate such as oboInOwl#created_by (the IRI without its namespace); UNKNOWN (with a warning) if not recognized. */
+  static Predicate string_to_predicate(std::string_view s);
   friend std::ostream& operator<<(std::ostream& ost, const PredicateValue& pv);
 };
 std::ostream& operator<<(std::ostream& ost, const PredicateValue& pv);
@@ -102,9 +104,6 @@ class Property {
 private:
   AllowedPropertyValue apv_;
   string label_;
-  static map<string, AllowedPropertyValue> property_registry_;
-  /** key, label of a property, value: corresponding term id */
-  static map<AllowedPropertyValue, string> apv_to_label_;
 public:
   Property(AllowedPropertyValue apv);
   Property(const Property &p);
@@ -112,7 +111,11 @@ public:
   ~Property(){}
   Property &operator=(const Property &p);
   Property &operator=(Property &&p);
-  static AllowedPropertyValue id_to_property(const string &s);
+  /** Look up the property with the id s (a label, or an IRI such as http://purl.obolibrary.org/obo/HP_0045076); throws PhenopacketException if unknown. */
+  static AllowedPropertyValue id_to_property(std::string_view s);
+  /** @return the label of apv, e.g., "UK spelling". */
+  static std::string_view property_label(AllowedPropertyValue apv);
+  AllowedPropertyValue get_allowed_property_value() const { return apv_; }
   friend std::ostream& operator<<(std::ostream& ost, const Property& prop);
 };
 std::ostream& operator<<(std::ostream& ost, const Property& prop);
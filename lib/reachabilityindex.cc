@@ -0,0 +1,223 @@
+/**
+ * @file reachabilityindex.cc
+ * @brief Interval labels that answer most path queries of the is_a graph without a search.
+ */
+#include "reachabilityindex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <random>
+#include <utility>
+
+ReachabilityIndex::ReachabilityIndex(const vector<int> &offsets, const vector<int> &edge_to,
+                                     const vector<EdgeType> &edge_types, EdgeType etype, int traversals)
+{
+  auto start = std::chrono::steady_clock::now();
+  const int n = offsets.empty() ? 0 : static_cast<int>(offsets.size()) - 1;
+  // reverse the child -> parent edges with a counting sort
+  child_offsets_.assign(n + 1, 0);
+  vector<bool> has_parent(n, false);
+  for (int v = 0; v < n; ++v) {
+    for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+      if (edge_types[e] == etype) {
+        ++child_offsets_[edge_to[e] + 1];
+        has_parent[v] = true;
+      }
+    }
+  }
+  for (int v = 0; v < n; ++v) {
+    child_offsets_[v + 1] += child_offsets_[v];
+  }
+  children_.resize(child_offsets_[n]);
+  vector<int> fill(child_offsets_.begin(), child_offsets_.end() - 1);
+  for (int v = 0; v < n; ++v) {
+    for (int e = offsets[v]; e < offsets[v + 1]; ++e) {
+      if (edge_types[e] == etype) {
+        children_[fill[edge_to[e]]++] = v;
+      }
+    }
+  }
+
+  stride_ = 2 + 2 * traversals;
+  labels_.assign(static_cast<size_t>(n) * stride_, 0);
+  vector<int> low(n);
+  vector<int> tree_low(n);
+  vector<int> visited(n, -1);
+  vector<bool> on_stack(n, false);
+  // the vertices in the post-order of the first traversal
+  vector<int> finished;
+  finished.reserve(n);
+  // vertex, number of children visited so far, first child to visit
+  struct Frame { int v; int i; int first; };
+  vector<Frame> stack;
+  std::mt19937 rng(2010);
+  for (int t = 0; t < traversals; ++t) {
+    int rank = 0;
+    for (int root = 0; root < n; ++root) {
+      if (has_parent[root] || visited[root] == t) {
+        continue;
+      }
+      auto push = [&](int v) {
+        visited[v] = t;
+        on_stack[v] = true;
+        low[v] = INT_MAX;
+        tree_low[v] = INT_MAX;
+        int degree = child_offsets_[v + 1] - child_offsets_[v];
+        // the first traversal visits the children in order, the others start at a random child
+        int first = (t == 0 || degree == 0) ? 0 : static_cast<int>(rng() % degree);
+        stack.push_back(Frame{v, 0, first});
+      };
+      push(root);
+      while (! stack.empty()) {
+        Frame &f = stack.back();
+        int v = f.v;
+        int degree = child_offsets_[v + 1] - child_offsets_[v];
+        if (f.i == degree) {
+          stack.pop_back();
+          on_stack[v] = false;
+          int post = rank++;
+          low[v] = std::min(low[v], post);
+          tree_low[v] = std::min(tree_low[v], post);
+          int *label = labels_.data() + static_cast<size_t>(v) * stride_;
+          if (t == 0) {
+            label[0] = tree_low[v];
+            finished.push_back(v);
+          }
+          label[2 + 2 * t] = low[v];
+          label[3 + 2 * t] = post;
+          if (! stack.empty()) {
+            int parent = stack.back().v;
+            low[parent] = std::min(low[parent], low[v]);
+            tree_low[parent] = std::min(tree_low[parent], tree_low[v]);
+          }
+          continue;
+        }
+        int c = children_[child_offsets_[v] + (f.first + f.i) % degree];
+        ++f.i;
+        if (on_stack[c]) {
+          // a cycle; the intervals would not be valid
+          labels_.clear();
+          stats_.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+          return;
+        }
+        if (visited[c] == t) {
+          low[v] = std::min(low[v], low[c]);
+        } else {
+          push(c);
+        }
+      }
+    }
+    if (std::count(visited.begin(), visited.end(), t) != n) {
+      // vertices that cannot be reached from a root lie on a cycle
+      labels_.clear();
+      break;
+    }
+  }
+  // depth: the length of the longest path from a root; in the reversed post-order, parents
+  // come before their children
+  for (auto it = finished.rbegin(); built() && it != finished.rend(); ++it) {
+    int v = *it;
+    int depth = labels_[static_cast<size_t>(v) * stride_ + 1];
+    for (int i = child_offsets_[v]; i < child_offsets_[v + 1]; ++i) {
+      int &child_depth = labels_[static_cast<size_t>(children_[i]) * stride_ + 1];
+      child_depth = std::max(child_depth, depth + 1);
+    }
+  }
+  stats_.vertices = n;
+  stats_.traversals = traversals;
+  stats_.bytes = (labels_.capacity() + child_offsets_.capacity() + children_.capacity()) * sizeof(int);
+  stats_.build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool
+ReachabilityIndex::may_contain(const int *a, const int *d) const
+{
+  for (int i = 2; i < stride_; i += 2) {
+    if (d[i] < a[i] || d[i + 1] > a[i + 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ReachabilityIndex::Decision
+ReachabilityIndex::decide(int source, int dest) const
+{
+  if (source == dest) {
+    return Decision::YES;
+  }
+  const int *s = label(source);
+  const int *d = label(dest);
+  // a descendant lies deeper than its ancestors
+  if (s[1] <= d[1]) {
+    return Decision::NO;
+  }
+  // post of the first traversal in the tree interval of dest
+  if (d[0] <= s[3] && s[3] <= d[3]) {
+    return Decision::YES;
+  }
+  return may_contain(d, s) ? Decision::SEARCH : Decision::NO;
+}
+
+bool
+ReachabilityIndex::exists_path(int source, int dest) const
+{
+  if (source == dest) {
+    // the graph is acyclic
+    return false;
+  }
+  switch (decide(source, dest)) {
+    case Decision::YES: return true;
+    case Decision::NO: return false;
+    default: return search(source, dest);
+  }
+}
+
+/**
+ * Depth-first search from dest towards its descendants. A child is only entered if its
+ * intervals contain those of source; the stamps mark the vertices visited by this search.
+ */
+bool
+ReachabilityIndex::search(int source, int dest) const
+{
+  thread_local vector<uint32_t> stamps;
+  thread_local uint32_t generation = 0;
+  const size_t n = child_offsets_.size() - 1;
+  if (stamps.size() < n) {
+    stamps.assign(n, 0);
+    generation = 0;
+  }
+  if (++generation == 0) {
+    std::fill(stamps.begin(), stamps.end(), 0);
+    generation = 1;
+  }
+  const int *s = label(source);
+  thread_local vector<int> stack;
+  stack.clear();
+  stack.push_back(dest);
+  stamps[dest] = generation;
+  while (! stack.empty()) {
+    int v = stack.back();
+    stack.pop_back();
+    for (int i = child_offsets_[v]; i < child_offsets_[v + 1]; ++i) {
+      int c = children_[i];
+      if (stamps[c] == generation) {
+        continue;
+      }
+      stamps[c] = generation;
+      if (c == source) {
+        return true;
+      }
+      const int *l = label(c);
+      if (l[0] <= s[3] && s[3] <= l[3]) {
+        return true;
+      }
+      if (l[1] < s[1] && may_contain(l, s)) {
+        stack.push_back(c);
+      }
+    }
+  }
+  return false;
+}
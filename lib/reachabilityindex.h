@@ -0,0 +1,78 @@
+/**
+ * @file reachabilityindex.h
+ * @brief Interval labels that answer most path queries of the is_a graph without a search.
+ * @author Peter N Robinson
+ *
+ * Ontology::exists_path(source, dest) asks whether dest is an ancestor of source. Without an
+ * index, this is a search upwards from source, which in a DAG with multiple inheritance reaches
+ * the shared ancestors once per path. The index follows GRAIL (Yildirim, Chaoji and Zaki,
+ * VLDB 2010): the graph is traversed downwards (from parents to children) several times, with the
+ * children in a different random order each time. Each traversal gives every vertex v the rank
+ * post(v) of v in the post-order and low(v), the smallest rank among the descendants of v. If
+ * source is a descendant of dest, then [low(source), post(source)] lies inside
+ * [low(dest), post(dest)] in every traversal. If one traversal does not contain the interval,
+ * the answer is no, after two comparisons.
+ *
+ * In addition, the first traversal records the interval of the depth-first spanning tree, and
+ * the depth of each vertex (the longest path from a root) is stored. A descendant is deeper
+ * than its ancestors, so a query in which source is not deeper than dest is answered no. A
+ * vertex whose rank lies in the tree interval of dest is a descendant of dest. In HPO most
+ * terms have a single parent, so the tree holds most of the is_a edges and most positive answers
+ * come from this check. Only the queries that neither check settles need a search; the search
+ * visits each vertex at most once and skips the children whose intervals do not contain the
+ * interval of source.
+ *
+ * The labels take (2 * traversals + 2) ints per vertex.
+ */
+#ifndef REACHABILITYINDEX_H
+#define REACHABILITYINDEX_H
+
+#include <cstddef>
+#include <vector>
+
+#include "edge.h"
+
+using std::vector;
+
+class ReachabilityIndex {
+public:
+  /** How a query was answered (see decide). */
+  enum class Decision { YES, NO, SEARCH };
+  struct Stats {
+    size_t vertices = 0;
+    int traversals = 0;
+    /** Bytes of the labels and of the child lists that the search uses. */
+    size_t bytes = 0;
+    double build_ms = 0;
+  };
+  /** An empty index (built() is false). */
+  ReachabilityIndex() = default;
+  /**
+   * Label the graph given by the CSR arrays of Ontology; the edges of type etype point from a
+   * child to its parents. If the graph is not acyclic, the index is left empty.
+   */
+  ReachabilityIndex(const vector<int> &offsets, const vector<int> &edge_to,
+                    const vector<EdgeType> &edge_types, EdgeType etype = EdgeType::IS_A, int traversals = 5);
+  bool built() const { return ! labels_.empty(); }
+  /** @return true if there is a path of one or more edges from source to dest. */
+  bool exists_path(int source, int dest) const;
+  /** @return YES or NO if the labels settle whether dest is source or an ancestor of it, SEARCH otherwise. */
+  Decision decide(int source, int dest) const;
+  const Stats &stats() const { return stats_; }
+
+private:
+  /** Per vertex: the start of its tree interval, its depth, then low and post of each traversal. */
+  vector<int> labels_;
+  int stride_ = 0;
+  /** The children of each vertex (the reversed edges), in CSR form. */
+  vector<int> child_offsets_;
+  vector<int> children_;
+  Stats stats_;
+
+  const int *label(int v) const { return labels_.data() + static_cast<size_t>(v) * stride_; }
+  /** @return false if the interval of d is not inside the interval of a in some traversal. */
+  bool may_contain(const int *a, const int *d) const;
+  bool search(int source, int dest) const;
+};
+
+#endif
@@ -0,0 +1,626 @@
+/**
+ * @file snapshot.cc
+ * @brief Compact binary snapshot of an Ontology that can be loaded via mmap.
+ */
+#include "snapshot.h"
+#include "mappedfile.h"
+#include "myexception.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using std::vector;
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'P', 'H', 'T', 'S', 'N', 'A', 'P', '\0'};
+/** Written in native byte order; a snapshot is not portable between architectures of different endianness. */
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t format_version;
+  uint32_t byte_order;
+  uint64_t records_offset;
+  uint64_t records_size;
+  uint64_t strings_offset;
+  uint64_t strings_size;
+  /** Position of the ontology version in the string pool (so that it can be read without the records). */
+  uint32_t version_offset;
+  uint32_t version_length;
+};
+
+enum XrefKind : uint8_t { XREF_TERMID = 0, XREF_URL = 1 };
+
+/**
+ * Collects the record section and the string pool. Strings are referenced from
+ * the records by (offset, length) into the pool.
+ */
+class SnapshotWriter {
+private:
+  string records_;
+  string strings_;
+
+public:
+  template <typename T>
+  void put(T val) { records_.append(reinterpret_cast<const char *>(&val), sizeof(T)); }
+  /** Overwrite a value that was written at pos (e.g., a size that was not known in advance). */
+  template <typename T>
+  void patch(size_t pos, T val) { records_.replace(pos, sizeof(T), reinterpret_cast<const char *>(&val), sizeof(T)); }
+  size_t position() const { return records_.size(); }
+  void put_string(std::string_view s)
+  {
+    put<uint32_t>(static_cast<uint32_t>(strings_.size()));
+    put<uint32_t>(static_cast<uint32_t>(s.size()));
+    strings_.append(s.data(), s.size());
+  }
+  /** Pad the records so that the following array starts at an aligned offset. */
+  void align(size_t alignment)
+  {
+    while (records_.size() % alignment != 0)
+    {
+      records_.push_back('\0');
+    }
+  }
+  template <typename T>
+  void put_array(const vector<T> &v)
+  {
+    put<uint32_t>(static_cast<uint32_t>(v.size()));
+    align(alignof(T));
+    records_.append(reinterpret_cast<const char *>(v.data()), v.size() * sizeof(T));
+  }
+  const string &records() const { return records_; }
+  const string &strings() const { return strings_; }
+};
+
+/**
+ * @return code as a value of the enum E, of which last is the largest value. The largest values
+ * must be updated here when Predicate, AllowedPropertyValue or EdgeType is extended.
+ */
+template <typename E>
+E snapshot_enum(uint8_t code, E last)
+{
+  if (code > static_cast<uint8_t>(last))
+  {
+    throw PhenopacketException("Corrupt enum value " + std::to_string(code) + " in ontology snapshot");
+  }
+  return static_cast<E>(code);
+}
+
+/** Reads the record section of a mapped snapshot. */
+class SnapshotReader {
+private:
+  const char *records_;
+  size_t size_;
+  size_t pos_ = 0;
+  const char *strings_;
+  size_t strings_size_;
+
+  void require(size_t n) const
+  {
+    if (pos_ + n > size_)
+    {
+      throw PhenopacketException("Truncated ontology snapshot");
+    }
+  }
+
+public:
+  SnapshotReader(const char *records, size_t size, const char *strings, size_t strings_size) : records_(records),
+                                                                                                size_(size),
+                                                                                                strings_(strings),
+                                                                                                strings_size_(strings_size) {}
+  template <typename T>
+  T get()
+  {
+    require(sizeof(T));
+    T val;
+    std::memcpy(&val, records_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return val;
+  }
+  std::string_view get_string_view()
+  {
+    uint32_t offset = get<uint32_t>();
+    uint32_t length = get<uint32_t>();
+    if (static_cast<size_t>(offset) + length > strings_size_)
+    {
+      throw PhenopacketException("Corrupt string reference in ontology snapshot");
+    }
+    return std::string_view(strings_ + offset, length);
+  }
+  string get_string() { return string(get_string_view()); }
+  /** Read an enum value stored as one byte; last is the largest value of the enum. */
+  template <typename E>
+  E get_enum(E last)
+  {
+    return snapshot_enum<E>(get<uint8_t>(), last);
+  }
+  size_t position() const { return pos_; }
+  void skip(size_t n)
+  {
+    require(n);
+    pos_ += n;
+  }
+  void align(size_t alignment)
+  {
+    while (pos_ % alignment != 0)
+    {
+      ++pos_;
+    }
+  }
+  template <typename T>
+  void get_array(vector<T> &v)
+  {
+    uint32_t n = get<uint32_t>();
+    align(alignof(T));
+    require(n * sizeof(T));
+    v.resize(n);
+    std::memcpy(v.data(), records_ + pos_, n * sizeof(T));
+    pos_ += n * sizeof(T);
+  }
+};
+
+void put_termid(SnapshotWriter &w, const TermId &tid)
+{
+  w.put_string(tid.get_value());
+  w.put<uint32_t>(static_cast<uint32_t>(tid.prefix().size()));
+}
+
+void put_xrefs(SnapshotWriter &w, TermRange<Xref> xrefs)
+{
+  w.put<uint32_t>(static_cast<uint32_t>(xrefs.size()));
+  for (const Xref &xr : xrefs)
+  {
+    if (xr.is_url())
+    {
+      w.put<uint8_t>(XREF_URL);
+      w.put_string(xr.url());
+    }
+    else
+    {
+      w.put<uint8_t>(XREF_TERMID);
+      put_termid(w, xr.termid());
+    }
+  }
+}
+
+uint8_t synonym_type_code(const Synonym &s)
+{
+  if (s.is_broad())
+    return 1;
+  if (s.is_narrow())
+    return 2;
+  if (s.is_related())
+    return 3;
+  return 0;
+}
+
+const char *synonym_type_from_code(uint8_t code)
+{
+  switch (code)
+  {
+  case 1:
+    return "hasBroadSynonym";
+  case 2:
+    return "hasNarrowSynonym";
+  case 3:
+    return "hasRelatedSynonym";
+  default:
+    return "hasExactSynonym";
+  }
+}
+
+/**
+ * Decodes the details of lazily loaded terms from the record section. It shares
+ * ownership of the mapped snapshot with all terms that have not been materialized yet.
+ */
+class SnapshotTermSource : public LazyTermSource {
+private:
+  std::shared_ptr<MappedFile> input_;
+  SnapshotHeader header_;
+
+public:
+  SnapshotTermSource(std::shared_ptr<MappedFile> input, const SnapshotHeader &header) : input_(std::move(input)),
+                                                                                          header_(header) {}
+  void materialize(Term &term, size_t begin, size_t end) const override;
+};
+
+void read_header(const MappedFile &input, const string &path, SnapshotHeader &header)
+{
+  if (input.size() < sizeof(SnapshotHeader))
+  {
+    throw PhenopacketException("Not an ontology snapshot (file too small): " + path);
+  }
+  std::memcpy(&header, input.data(), sizeof(SnapshotHeader));
+  if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+  {
+    throw PhenopacketException("Not an ontology snapshot: " + path);
+  }
+  if (header.byte_order != BYTE_ORDER_MARK)
+  {
+    throw PhenopacketException("Ontology snapshot was written on a machine with different byte order: " + path);
+  }
+  if (header.format_version != OntologySnapshot::FORMAT_VERSION)
+  {
+    throw PhenopacketException("Ontology snapshot has format version " + std::to_string(header.format_version) +
+                               " but this version of phenotools reads version " +
+                               std::to_string(OntologySnapshot::FORMAT_VERSION) + ". Please recompile " + path);
+  }
+  if (header.records_offset + header.records_size > input.size() ||
+      header.strings_offset + header.strings_size > input.size() ||
+      static_cast<uint64_t>(header.version_offset) + header.version_length > header.strings_size)
+  {
+    throw PhenopacketException("Truncated ontology snapshot: " + path);
+  }
+}
+
+} // namespace
+
+/** The separator position is stored, so that TermId::from_string does not need to run again. */
+TermId
+OntologySnapshot::make_termid(const string &value, uint32_t separator_pos)
+{
+  return TermId{value, separator_pos};
+}
+
+static TermId snapshot_get_termid(SnapshotReader &r)
+{
+  string value = r.get_string();
+  uint32_t pos = r.get<uint32_t>();
+  return OntologySnapshot::make_termid(value, pos);
+}
+
+static Xref snapshot_get_xref(SnapshotReader &r)
+{
+  uint8_t kind = r.get<uint8_t>();
+  if (kind == XREF_URL)
+  {
+    return Xref::from_url(r.get_string_view());
+  }
+  return Xref{snapshot_get_termid(r)};
+}
+
+/**
+ * Read the part of a term record that can be loaded lazily (definition, xrefs,
+ * property values and synonyms). lazy: called by SnapshotTermSource (see Term::add_definition).
+ */
+static void snapshot_get_term_details(SnapshotReader &r, Term &term, bool lazy)
+{
+  term.add_definition(r.get_string_view(), lazy);
+  uint32_t m = r.get<uint32_t>();
+  for (uint32_t j = 0; j < m; ++j)
+  {
+    term.add_definition_xref(snapshot_get_xref(r));
+  }
+  m = r.get<uint32_t>();
+  for (uint32_t j = 0; j < m; ++j)
+  {
+    term.add_term_xref(snapshot_get_xref(r));
+  }
+  m = r.get<uint32_t>();
+  for (uint32_t j = 0; j < m; ++j)
+  {
+    Predicate pred = r.get_enum(Predicate::HOMEPAGE);
+    term.add_predicate_value(PredicateValue{pred, r.get_string_view()});
+  }
+  m = r.get<uint32_t>();
+  for (uint32_t j = 0; j < m; ++j)
+  {
+    const char *stype = synonym_type_from_code(r.get<uint8_t>());
+    term.add_synonym(stype, r.get_string_view());
+  }
+}
+
+void SnapshotTermSource::materialize(Term &term, size_t begin, size_t end) const
+{
+  const char *base = input_->data();
+  SnapshotReader r{base + header_.records_offset + begin, end - begin,
+                   base + header_.strings_offset, header_.strings_size};
+  snapshot_get_term_details(r, term, true);
+}
+
+void OntologySnapshot::write(const Ontology &ontology, const string &path)
+{
+  SnapshotWriter w;
+  w.put_string(ontology.id_);
+  w.put_string(ontology.version_);
+  w.put<uint32_t>(static_cast<uint32_t>(ontology.predicate_values_.size()));
+  for (const PredicateValue &pv : ontology.predicate_values_)
+  {
+    w.put<uint8_t>(static_cast<uint8_t>(pv.get_property()));
+    w.put_string(pv.value());
+  }
+  w.put<uint32_t>(static_cast<uint32_t>(ontology.property_list_.size()));
+  for (const Property &p : ontology.property_list_)
+  {
+    w.put<uint8_t>(static_cast<uint8_t>(p.get_allowed_property_value()));
+  }
+  // Each term is stored once, also if it is reachable via alternative ids. The terms are
+  // written in the order of the TermStore, so that the loader can append them as they are.
+  const TermStore &terms = ontology.terms_;
+  w.put<uint32_t>(static_cast<uint32_t>(terms.size()));
+  for (size_t i = 0; i < terms.size(); ++i)
+  {
+    put_termid(w, terms.id(i));
+    w.put_string(terms.label(i));
+    w.put<uint8_t>(terms.obsolete(i) ? 1 : 0);
+    w.put<uint32_t>(terms.creation_date(i).day_number());
+    TermRange<TermId> alt_ids = terms.alternative_ids(i);
+    w.put<uint32_t>(static_cast<uint32_t>(alt_ids.size()));
+    for (const TermId &alt : alt_ids)
+    {
+      put_termid(w, alt);
+    }
+    // The size of the details lets a lazy loader skip them
+    size_t details_size_pos = w.position();
+    w.put<uint32_t>(0);
+    size_t details_begin = w.position();
+    w.put_string(terms.definition(i));
+    put_xrefs(w, terms.definition_xrefs(i));
+    put_xrefs(w, terms.term_xrefs(i));
+    TermRange<PredicateValue> property_values = terms.property_values(i);
+    w.put<uint32_t>(static_cast<uint32_t>(property_values.size()));
+    for (const PredicateValue &pv : property_values)
+    {
+      w.put<uint8_t>(static_cast<uint8_t>(pv.get_property()));
+      w.put_string(pv.value());
+    }
+    TermRange<Synonym> synonyms = terms.synonyms(i);
+    w.put<uint32_t>(static_cast<uint32_t>(synonyms.size()));
+    for (const Synonym &syn : synonyms)
+    {
+      w.put<uint8_t>(synonym_type_code(syn));
+      w.put_string(syn.label());
+    }
+    w.patch<uint32_t>(details_size_pos, static_cast<uint32_t>(w.position() - details_begin));
+  }
+  w.put<int32_t>(ontology.original_edge_count_);
+  w.put<int32_t>(ontology.is_a_edge_count_);
+  w.put<int32_t>(ontology.skipped_edge_count_);
+  // current_term_ids_ is sorted and defines the vertex indices of the CSR arrays
+  w.put<uint32_t>(static_cast<uint32_t>(ontology.current_term_ids_.size()));
+  for (const TermId &tid : ontology.current_term_ids_)
+  {
+    put_termid(w, tid);
+  }
+  vector<int32_t> offsets(ontology.offset_to_edge_.begin(), ontology.offset_to_edge_.end());
+  w.put_array(offsets);
+  vector<int32_t> edge_to(ontology.edge_to_.begin(), ontology.edge_to_.end());
+  w.put_array(edge_to);
+  vector<uint8_t> edge_types;
+  edge_types.reserve(ontology.edge_type_list_.size());
+  for (EdgeType et : ontology.edge_type_list_)
+  {
+    edge_types.push_back(static_cast<uint8_t>(et));
+  }
+  w.put_array(edge_types);
+
+  SnapshotHeader header{};
+  std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.format_version = FORMAT_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.records_offset = sizeof(SnapshotHeader);
+  header.records_size = w.records().size();
+  header.strings_offset = header.records_offset + header.records_size;
+  header.strings_size = w.strings().size();
+  // the ontology id is the first string in the pool, the version the second
+  header.version_offset = static_cast<uint32_t>(ontology.id_.size());
+  header.version_length = static_cast<uint32_t>(ontology.version_.size());
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.good())
+  {
+    throw PhenopacketException("Could not open " + path + " for writing");
+  }
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(w.records().data(), w.records().size());
+  out.write(w.strings().data(), w.strings().size());
+  if (!out.good())
+  {
+    throw PhenopacketException("Could not write ontology snapshot to " + path);
+  }
+}
+
+std::unique_ptr<Ontology>
+OntologySnapshot::load(const string &path)
+{
+  return load(path, TermLoading::EAGER);
+}
+
+std::unique_ptr<Ontology>
+OntologySnapshot::load(const string &path, TermLoading loading)
+{
+  auto input = std::make_shared<MappedFile>(path);
+  SnapshotHeader header;
+  read_header(*input, path, header);
+  SnapshotReader r{input->data() + header.records_offset, header.records_size,
+                   input->data() + header.strings_offset, header.strings_size};
+  std::shared_ptr<const LazyTermSource> source;
+  if (loading == TermLoading::LAZY)
+  {
+    source = std::make_shared<SnapshotTermSource>(input, header);
+  }
+  string id = r.get_string();
+  std::unique_ptr<Ontology> ontology{new Ontology(id)};
+  ontology->version_ = r.get_string();
+  uint32_t n = r.get<uint32_t>();
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    Predicate pred = r.get_enum(Predicate::HOMEPAGE);
+    ontology->predicate_values_.emplace_back(pred, r.get_string_view());
+  }
+  n = r.get<uint32_t>();
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    ontology->property_list_.emplace_back(r.get_enum(AllowedPropertyValue::UNKNOWN));
+  }
+  n = r.get<uint32_t>();
+  TermStore &terms = ontology->terms_;
+  terms.reserve(n);
+  ontology->term_index_.reserve(n);
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    TermId tid = snapshot_get_termid(r);
+    Term term{tid, r.get_string_view()};
+    term.is_obsolete_ = r.get<uint8_t>() != 0;
+    CivilDate creation_date = CivilDate::from_day_number(r.get<uint32_t>());
+    uint32_t m = r.get<uint32_t>();
+    for (uint32_t j = 0; j < m; ++j)
+    {
+      term.alternative_id_list_.push_back(snapshot_get_termid(r));
+    }
+    uint32_t details_size = r.get<uint32_t>();
+    if (source)
+    {
+      size_t details_begin = r.position();
+      r.skip(details_size);
+      term.set_lazy_source(source, details_begin, r.position());
+    }
+    else
+    {
+      snapshot_get_term_details(r, term, false);
+    }
+    int index = terms.append(std::move(term));
+    // known without decoding the details of a lazy term
+    terms.creation_dates_[index] = creation_date;
+    ontology->term_index_.insert(tid, index);
+    if (terms.obsolete(index))
+    {
+      ontology->obsolete_term_ids_.push_back(tid);
+    }
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    for (const TermId &alt : terms.alternative_ids(i))
+    {
+      ontology->term_index_.insert(alt, i);
+    }
+  }
+  ontology->original_edge_count_ = r.get<int32_t>();
+  ontology->is_a_edge_count_ = r.get<int32_t>();
+  ontology->skipped_edge_count_ = r.get<int32_t>();
+  n = r.get<uint32_t>();
+  ontology->current_term_ids_.reserve(n);
+  ontology->termid_to_index_.reserve(n);
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    ontology->current_term_ids_.push_back(snapshot_get_termid(r));
+    ontology->termid_to_index_.insert(ontology->current_term_ids_.back(), i);
+    if (i >= terms.size() || terms.id(i) != ontology->current_term_ids_.back())
+    {
+      throw PhenopacketException("Current terms do not match the term records in ontology snapshot: " + path);
+    }
+    // the vertex indices follow the order of the ids
+    if (i > 0 && ! (ontology->current_term_ids_[i - 1] < ontology->current_term_ids_[i]))
+    {
+      throw PhenopacketException("Current terms are not sorted in ontology snapshot: " + path);
+    }
+  }
+  vector<int32_t> ints;
+  r.get_array(ints);
+  ontology->offset_to_edge_.assign(ints.begin(), ints.end());
+  r.get_array(ints);
+  ontology->edge_to_.assign(ints.begin(), ints.end());
+  vector<uint8_t> edge_types;
+  r.get_array(edge_types);
+  ontology->edge_type_list_.reserve(edge_types.size());
+  for (uint8_t et : edge_types)
+  {
+    ontology->edge_type_list_.push_back(snapshot_enum(et, EdgeType::REALIZED_IN));
+  }
+  if (ontology->offset_to_edge_.size() != ontology->current_term_ids_.size() + 1 ||
+      ontology->edge_to_.size() != ontology->edge_type_list_.size())
+  {
+    throw PhenopacketException("Inconsistent CSR arrays in ontology snapshot: " + path);
+  }
+  const vector<int> &offsets = ontology->offset_to_edge_;
+  const int edge_count = static_cast<int>(ontology->edge_to_.size());
+  if (offsets.front() != 0 || offsets.back() != edge_count ||
+      ! std::is_sorted(offsets.begin(), offsets.end()))
+  {
+    throw PhenopacketException("Corrupt edge offsets in ontology snapshot: " + path);
+  }
+  const int vertex_count = static_cast<int>(ontology->current_term_ids_.size());
+  for (int to : ontology->edge_to_)
+  {
+    if (to < 0 || to >= vertex_count)
+    {
+      throw PhenopacketException("Corrupt edge target in ontology snapshot: " + path);
+    }
+  }
+  if (source)
+  {
+    // the terms only touch their own details from now on
+    input->drop_resident_pages();
+  }
+  return ontology;
+}
+
+std::unique_ptr<Ontology>
+OntologySnapshot::load(const string &path, const string &expected_version)
+{
+  string version = read_version(path);
+  if (version != expected_version)
+  {
+    throw PhenopacketException("Ontology snapshot " + path + " has version \"" + version +
+                               "\" but version \"" + expected_version + "\" was requested");
+  }
+  return load(path);
+}
+
+bool OntologySnapshot::is_snapshot(const string &path)
+{
+  std::ifstream in(path, std::ios::binary);
+  char magic[sizeof(SNAPSHOT_MAGIC)];
+  if (!in.read(magic, sizeof(magic)))
+  {
+    return false;
+  }
+  return std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+}
+
+string
+OntologySnapshot::read_version(const string &path)
+{
+  MappedFile input{path};
+  SnapshotHeader header;
+  read_header(input, path, header);
+  return string(input.data() + header.strings_offset + header.version_offset, header.version_length);
+}
+
+string
+OntologySnapshot::default_file_name(const Ontology &ontology)
+{
+  // id: http://purl.obolibrary.org/obo/hp.json -> hp
+  string stem = ontology.get_id();
+  size_t pos = stem.find_last_of('/');
+  if (pos != string::npos)
+  {
+    stem = stem.substr(pos + 1);
+  }
+  pos = stem.find('.');
+  if (pos != string::npos)
+  {
+    stem = stem.substr(0, pos);
+  }
+  if (stem.empty())
+  {
+    stem = "ontology";
+  }
+  // version: http://purl.obolibrary.org/obo/hp/releases/2019-09-06 -> 2019-09-06
+  string version = ontology.get_version();
+  pos = version.find_last_of('/');
+  if (pos != string::npos)
+  {
+    version = version.substr(pos + 1);
+  }
+  if (version.empty())
+  {
+    return stem + ".phsnap";
+  }
+  return stem + "-" + version + ".phsnap";
+}
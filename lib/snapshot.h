@@ -0,0 +1,57 @@
+/**
+ * @file snapshot.h
+ * @brief Compact binary snapshot of an Ontology that can be loaded via mmap.
+ * @author Peter N Robinson
+ *
+ * Parsing hp.json and building the CSR graph takes most of the run time of short
+ * phenotools invocations. A snapshot stores the result of that work once, keyed by
+ * the version IRI from the meta block of the ontology. The file consists of a fixed
+ * header, a record section (counts, enum codes, string references and the raw CSR
+ * arrays offset_to_edge_, edge_to_ and edge_type_list_), and a string pool. Loading
+ * maps the file, checks the header, bulk-copies the CSR arrays and appends the terms
+ * to the TermStore of the Ontology in the order in which they were written (current
+ * terms in vertex order, then obsolete terms); no text parsing is performed. The
+ * record of each term starts with the fields needed to build the graph (and its
+ * creation date) and is followed by the size of the remaining details, so that
+ * these can be skipped and decoded lazily.
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#include "ontology.h"
+
+using std::string;
+
+/** EAGER decodes all fields of all terms while loading; LAZY decodes definitions, xrefs, property values and synonyms on first access. */
+enum class TermLoading { EAGER, LAZY };
+
+class OntologySnapshot {
+public:
+  /**
+   * Increment whenever the layout, any of the serialized enums (EdgeType, Predicate, AllowedPropertyValue),
+   * or the order of TermIds (which defines the vertex indices) changes.
+   */
+  static constexpr uint32_t FORMAT_VERSION = 5;
+  /** Write the ontology to path. Throws PhenopacketException if the file cannot be written. */
+  static void write(const Ontology &ontology, const string &path);
+  /** Load an ontology that was written by write(). Throws PhenopacketException if the file is not a valid snapshot. */
+  static std::unique_ptr<Ontology> load(const string &path);
+  /** Load; with TermLoading::LAZY the snapshot stays mapped until all terms were materialized or destroyed. */
+  static std::unique_ptr<Ontology> load(const string &path, TermLoading loading);
+  /** Load, but reject a snapshot whose ontology version differs from expected_version. */
+  static std::unique_ptr<Ontology> load(const string &path, const string &expected_version);
+  /** @return true if the file starts with the snapshot magic bytes. */
+  static bool is_snapshot(const string &path);
+  /** @return the ontology version stored in the snapshot header. */
+  static string read_version(const string &path);
+  /** @return a file name such as hp-2019-09-06.phsnap derived from the ontology id and version. */
+  static string default_file_name(const Ontology &ontology);
+  /** Used by the loader to restore a TermId without parsing its value again. */
+  static TermId make_termid(const string &value, uint32_t separator_pos);
+};
+
+#endif
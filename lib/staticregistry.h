@@ -0,0 +1,127 @@
+/**
+ * @file staticregistry.h
+ * @brief Lookup tables from fixed strings to enum values that are built at compile time.
+ * @author Peter N Robinson
+ *
+ * The parsers map the predicate of every edge and property value to an EdgeType or a
+ * Predicate. The keys are known when the program is compiled, so make_registry finds a
+ * seed for which the hash function maps the keys to distinct slots of a small table
+ * (a perfect hash) while compiling. A lookup then hashes the key once and compares it
+ * with the single candidate entry; nothing is allocated and no map is built during
+ * static initialization.
+ *
+ *   constexpr RegistryEntry<EdgeType> EDGE_TYPES[] = { {"is_a", EdgeType::IS_A}, ... };
+ *   constexpr auto EDGE_TYPE_REGISTRY = make_registry(EDGE_TYPES);
+ *   const EdgeType *et = EDGE_TYPE_REGISTRY.find("is_a");
+ */
+#ifndef STATICREGISTRY_H
+#define STATICREGISTRY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+template <typename V>
+struct RegistryEntry {
+  std::string_view key;
+  V value;
+};
+
+/** FNV-1a, seeded. */
+constexpr uint32_t
+registry_hash(std::string_view s, uint32_t seed)
+{
+  uint32_t h = 2166136261u ^ seed;
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 16777619u;
+  }
+  return h ^ (h >> 16);
+}
+
+/** @return the number of slots for n keys: a power of two, at least 4n, so that a seed is found after a few tries. */
+constexpr size_t
+registry_slot_count(size_t n)
+{
+  size_t m = 8;
+  while (m < 4 * n) {
+    m <<= 1;
+  }
+  return m;
+}
+
+/** @return the substring after the last '/' of an IRI such as http://purl.obolibrary.org/obo/RO_0004029. */
+constexpr std::string_view
+strip_iri(std::string_view iri)
+{
+  size_t pos = iri.find_last_of('/');
+  return pos == std::string_view::npos ? iri : iri.substr(pos + 1);
+}
+
+template <typename V, size_t N>
+class StaticRegistry {
+public:
+  static constexpr size_t SLOTS = registry_slot_count(N);
+  static_assert(N < 255, "a registry holds at most 254 entries");
+
+  /** @return the value for key, or nullptr if key is not in the registry. */
+  constexpr const V *find(std::string_view key) const
+  {
+    uint8_t i = slots_[registry_hash(key, seed_) & (SLOTS - 1)];
+    return i != EMPTY && entries_[i].key == key ? &entries_[i].value : nullptr;
+  }
+  constexpr size_t size() const { return N; }
+  /** @return the entries in the order in which they were given. */
+  constexpr const std::array<RegistryEntry<V>, N> &entries() const { return entries_; }
+
+private:
+  template <typename W, size_t M>
+  friend constexpr StaticRegistry<W, M> make_registry(const RegistryEntry<W> (&entries)[M]);
+  static constexpr uint8_t EMPTY = 0xFF;
+  std::array<RegistryEntry<V>, N> entries_{};
+  std::array<uint8_t, SLOTS> slots_{};
+  uint32_t seed_ = 0;
+};
+
+/**
+ * Build the registry for entries. This is meant to be evaluated at compile time (assign the
+ * result to a constexpr variable); duplicate keys then cause a compilation error.
+ */
+template <typename V, size_t N>
+constexpr StaticRegistry<V, N>
+make_registry(const RegistryEntry<V> (&entries)[N])
+{
+  StaticRegistry<V, N> registry;
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      if (entries[i].key == entries[j].key) {
+        throw std::logic_error("duplicate key in registry");
+      }
+    }
+    registry.entries_[i] = entries[i];
+  }
+  constexpr size_t mask = StaticRegistry<V, N>::SLOTS - 1;
+  for (uint32_t seed = 0; seed < 100000; ++seed) {
+    for (size_t s = 0; s <= mask; ++s) {
+      registry.slots_[s] = StaticRegistry<V, N>::EMPTY;
+    }
+    bool perfect = true;
+    for (size_t i = 0; i < N && perfect; ++i) {
+      size_t s = registry_hash(entries[i].key, seed) & mask;
+      if (registry.slots_[s] != StaticRegistry<V, N>::EMPTY) {
+        perfect = false;
+      } else {
+        registry.slots_[s] = static_cast<uint8_t>(i);
+      }
+    }
+    if (perfect) {
+      registry.seed_ = seed;
+      return registry;
+    }
+  }
+  throw std::logic_error("no perfect hash seed found for registry");
+}
+
+#endif
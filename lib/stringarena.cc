@@ -0,0 +1,127 @@
+/**
+ * @file stringarena.cc
+ * @brief Append-only storage for the strings of ontology terms.
+ */
+#include "stringarena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+StringArena &
+StringArena::global()
+{
+  // function-local static, so that it exists before any static Term or PredicateValue is created
+  static StringArena arena;
+  return arena;
+}
+
+std::string_view
+StringArena::copy(std::string_view s)
+{
+  if (s.size() > remaining_) {
+    // a string longer than a block gets a block of its own
+    size_t n = std::max(BLOCK_SIZE, s.size());
+    blocks_.emplace_back(new char[n]);
+    cursor_ = blocks_.back().get();
+    remaining_ = n;
+    stats_.reserved_bytes += n;
+  }
+  std::memcpy(cursor_, s.data(), s.size());
+  std::string_view view{cursor_, s.size()};
+  cursor_ += s.size();
+  remaining_ -= s.size();
+  ++stats_.strings;
+  stats_.stored_bytes += s.size();
+  return view;
+}
+
+/** @return the slot that holds s, or the empty slot where it would be inserted (linear probing). */
+size_t
+StringArena::probe(std::string_view s) const
+{
+  size_t mask = slots_.size() - 1;
+  size_t i = std::hash<std::string_view>{}(s) & mask;
+  while (slots_[i].data() != nullptr && slots_[i] != s) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+void
+StringArena::grow()
+{
+  std::vector<std::string_view> old(std::max<size_t>(1024, 2 * slots_.size()));
+  old.swap(slots_);
+  for (std::string_view s : old) {
+    if (s.data() != nullptr) {
+      slots_[probe(s)] = s;
+    }
+  }
+}
+
+std::string_view
+StringArena::intern(std::string_view s)
+{
+  if (s.empty()) {
+    return std::string_view();
+  }
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (! slots_.empty()) {
+      std::string_view found = slots_[probe(s)];
+      if (found.data() != nullptr) {
+        requests_.fetch_add(1, std::memory_order_relaxed);
+        requested_bytes_.fetch_add(s.size(), std::memory_order_relaxed);
+        return found;
+      }
+    }
+  }
+  requests_.fetch_add(1, std::memory_order_relaxed);
+  requested_bytes_.fetch_add(s.size(), std::memory_order_relaxed);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  // the load factor is kept at or below 1/2
+  if (2 * (interned_ + 1) > slots_.size()) {
+    grow();
+  }
+  size_t i = probe(s);
+  if (slots_[i].data() == nullptr) {
+    slots_[i] = copy(s);
+    ++interned_;
+    stats_.interned_bytes += s.size();
+  }
+  return slots_[i];
+}
+
+std::string_view
+StringArena::store(std::string_view s)
+{
+  if (s.empty()) {
+    return std::string_view();
+  }
+  requests_.fetch_add(1, std::memory_order_relaxed);
+  requested_bytes_.fetch_add(s.size(), std::memory_order_relaxed);
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return copy(s);
+}
+
+StringArena::Stats
+StringArena::stats() const
+{
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  Stats s = stats_;
+  s.requests = requests_.load(std::memory_order_relaxed);
+  s.requested_bytes = requested_bytes_.load(std::memory_order_relaxed);
+  return s;
+}
+
+void
+StringArena::print_stats(std::ostream &ost) const
+{
+  Stats s = stats();
+  ost << "[INFO] string arena: " << s.strings << " strings, " << s.stored_bytes / 1024 << " kB stored ("
+      << s.interned_bytes / 1024 << " kB of them interned, including lazily decoded definitions) in "
+      << s.reserved_bytes / 1024 << " kB of blocks; " << s.requests - s.strings << " repeated strings ("
+      << s.saved_bytes() / 1024 << " kB) were not stored again.\n";
+}
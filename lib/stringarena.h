@@ -0,0 +1,74 @@
+/**
+ * @file stringarena.h
+ * @brief Append-only storage for the strings of ontology terms.
+ * @author Peter N Robinson
+ *
+ * A Term used to own a std::string for its label and definition, and each of its
+ * synonyms, xrefs and property values another one. Most of these are separate heap
+ * allocations, and many of them repeat: the creator IRIs and created_by values of
+ * the property values, synonyms that are the labels of other terms, and so on.
+ * The StringArena copies strings into large blocks and hands out views into them.
+ * intern() returns the same view for equal strings, so a repeated value is stored once;
+ * store() only appends (for long, mostly unique strings such as definitions).
+ * Strings are never removed, so the views remain valid for the lifetime of the process.
+ */
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+class StringArena {
+public:
+  struct Stats {
+    /** Number of intern() and store() calls with a non-empty string, and their total length. */
+    size_t requests = 0;
+    size_t requested_bytes = 0;
+    /** Number and total length of the strings that were copied into the arena. */
+    size_t strings = 0;
+    size_t stored_bytes = 0;
+    /** The part of stored_bytes that intern() copied; these strings are stored once however often they are requested. */
+    size_t interned_bytes = 0;
+    /** Bytes of the blocks, including the unused rest of each block. */
+    size_t reserved_bytes = 0;
+    size_t saved_bytes() const { return requested_bytes - stored_bytes; }
+  };
+  /** The arena shared by all ontologies (the parsers create terms on several threads). */
+  static StringArena &global();
+  StringArena() = default;
+  StringArena(const StringArena &) = delete;
+  StringArena &operator=(const StringArena &) = delete;
+  /** @return a view of a copy of s in the arena; equal strings yield the same view. */
+  std::string_view intern(std::string_view s);
+  /** @return a view of a new copy of s in the arena. */
+  std::string_view store(std::string_view s);
+  Stats stats() const;
+  /** Print the number of stored strings and the bytes saved by interning. */
+  void print_stats(std::ostream &ost = std::cout) const;
+
+private:
+  static constexpr size_t BLOCK_SIZE = 1 << 20;
+  mutable std::shared_mutex mutex_;
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char *cursor_ = nullptr;
+  size_t remaining_ = 0;
+  /** Open-addressing set of the interned strings; an empty slot has a null data pointer. */
+  std::vector<std::string_view> slots_;
+  size_t interned_ = 0;
+  /** strings, stored_bytes and reserved_bytes; changed under the exclusive lock. */
+  Stats stats_;
+  /** Also counted by lookups under the shared lock. */
+  std::atomic<size_t> requests_{0};
+  std::atomic<size_t> requested_bytes_{0};
+  /** Copy s into the current block (or a new one). The caller holds the lock. */
+  std::string_view copy(std::string_view s);
+  size_t probe(std::string_view s) const;
+  void grow();
+};
+
+#endif
@@ -1,118 +1,373 @@
 #include "termid.h"
 #include "myexception.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
 using std::cout;
 
+namespace {
+const int PREFIX_SHIFT = 48;
+const int DIGITS_SHIFT = 44;
+/** The top bit of a code is left free for other types to tag values that are not TermIds (see Xref). */
+const uint64_t MAX_PREFIXES = 1 << 15;
+const uint64_t LOCAL_MASK = (uint64_t(1) << DIGITS_SHIFT) - 1;
+/** Longest all-digit local id that is stored as a number (10^12 < 2^44). */
+const std::size_t MAX_DIGITS = 12;
+
+/**
+ * Strings that are referred to by their index. Strings are never removed, so an index
+ * stays valid for the lifetime of the process. The parsers create TermIds on several
+ * threads, hence the lock for interning. Looking up the string of an index does not lock
+ * (operator< compares the strings): the views are kept in segments of 1024, 2048, 4096, ...
+ * entries that are allocated once and never moved, and a segment is published before any
+ * index in it is handed out.
+ */
+class InternTable {
+private:
+  static const int FIRST_SEGMENT_BITS = 10;
+  /** Enough segments for 2^50 strings, more than a TermId can refer to. */
+  static const int SEGMENTS = 40;
+  mutable std::shared_mutex mutex_;
+  /** A deque does not move its elements, so the views in index_ and segments_ refer into it. */
+  std::deque<string> strings_;
+  std::unordered_map<std::string_view, uint64_t> index_;
+  std::atomic<std::string_view *> segments_[SEGMENTS] = {};
+
+  /** @return the position of the highest set bit of x (x > 0). */
+  static int highest_bit(uint64_t x)
+  {
+    int h = 0;
+    for (int shift = 32; shift > 0; shift /= 2) {
+      if (x >> shift) {
+        x >>= shift;
+        h += shift;
+      }
+    }
+    return h;
+  }
+
+public:
+  ~InternTable()
+  {
+    for (auto &segment : segments_) {
+      delete[] segment.load();
+    }
+  }
+  uint64_t intern(std::string_view s)
+  {
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto p = index_.find(s);
+      if (p != index_.end()) {
+        return p->second;
+      }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto p = index_.find(s);
+    if (p != index_.end()) {
+      return p->second;
+    }
+    uint64_t i = strings_.size();
+    uint64_t j = i + (uint64_t(1) << FIRST_SEGMENT_BITS);
+    int h = highest_bit(j);
+    std::atomic<std::string_view *> &segment = segments_[h - FIRST_SEGMENT_BITS];
+    std::string_view *views = segment.load(std::memory_order_relaxed);
+    if (views == nullptr) {
+      views = new std::string_view[uint64_t(1) << h];
+      segment.store(views, std::memory_order_release);
+    }
+    strings_.emplace_back(s);
+    views[j - (uint64_t(1) << h)] = strings_.back();
+    index_.emplace(std::string_view(strings_.back()), i);
+    return i;
+  }
+  /** @return true and set i to the index of s if s has been interned. */
+  bool find(std::string_view s, uint64_t &i) const
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto p = index_.find(s);
+    if (p == index_.end()) {
+      return false;
+    }
+    i = p->second;
+    return true;
+  }
+  /** i must have been returned by intern. The strings are never moved or changed, so the view stays valid. */
+  std::string_view get(uint64_t i) const
+  {
+    uint64_t j = i + (uint64_t(1) << FIRST_SEGMENT_BITS);
+    int h = highest_bit(j);
+    return segments_[h - FIRST_SEGMENT_BITS].load(std::memory_order_acquire)[j - (uint64_t(1) << h)];
+  }
+};
+
+// function-local statics, so that the tables exist before EMPTY_TERMID is initialized
+InternTable &prefix_table()
+{
+  static InternTable table;
+  return table;
+}
+
+InternTable &local_id_table()
+{
+  static InternTable table;
+  return table;
+}
+
+/**
+ * Nearly all ids of a parse share a few prefixes, so each thread remembers the last one.
+ * @return the index of prefix, or MAX_PREFIXES if the table is full.
+ */
+uint64_t intern_prefix(std::string_view prefix)
+{
+  thread_local string last_prefix;
+  thread_local uint64_t last_index = MAX_PREFIXES;
+  if (last_index != MAX_PREFIXES && prefix == last_prefix) {
+    return last_index;
+  }
+  uint64_t i = prefix_table().intern(prefix);
+  if (i >= MAX_PREFIXES) {
+    return MAX_PREFIXES;
+  }
+  last_prefix.assign(prefix.data(), prefix.size());
+  last_index = i;
+  return i;
+}
+
+/** @return the part of s after the last /, or s if it is not an IRI. */
+inline std::string_view last_segment(std::string_view s)
+{
+  std::size_t i = s.find_last_of('/');
+  return i == std::string_view::npos ? s : s.substr(i + 1);
+}
+}
 
 TermId::TermId(const string &s,std::size_t pos):
-  value_(s),
-  separator_pos_(pos)
+  code_(EMPTY_TERMID.code_)
 {
+  TermIdResult r = make(std::string_view(s).substr(0, pos), std::string_view(s).substr(pos + 1));
+  if (! r) {
+    throw PhenopacketException(error_message(r.error, s));
+  }
+  code_ = r.value.code_;
 }
 
-TermId
-TermId::from_string(const string &s)
+TermIdResult
+TermId::make(std::string_view prefix, std::string_view local_id)
 {
-  string cp = s;
-  std::size_t i = cp.find_last_of('/');
-  if (i != string::npos) {
-    cp = cp.substr(i+1);
-  }
-  i = cp.find(':');
-  if (string::npos == i ) {
-    if (string::npos != s.find("hgnc")) {
-      string hgnc = "HGNC:" + cp;
-      return TermId{hgnc,4};
-    } else if (string::npos != s.find("ICD10")) {
-        string icd = "ICD10:" + cp;
-      return TermId{icd,5};
+  uint64_t digits = 0;
+  uint64_t local = 0;
+  if (!local_id.empty() && local_id.size() <= MAX_DIGITS &&
+      std::all_of(local_id.begin(), local_id.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+    digits = local_id.size();
+    for (char c : local_id) {
+      local = 10 * local + (c - '0');
     }
-    // if we get here, we could not find one of the two
-    // above cases
   } else {
-    return TermId{cp,i}; // rely on RVO/move
+    local = local_id_table().intern(local_id);
+    if (local > LOCAL_MASK) {
+      return TermIdResult{EMPTY_TERMID, TermIdError::TOO_MANY_LOCAL_IDS};
+    }
   }
-  i = cp.find('_'); // some terms are with _
-  if (i != string::npos) {
-    cp[i] = ':';
-    TermId t{cp,i};
-    return TermId{cp,i}; // rely on RVO/move
+  uint64_t p = intern_prefix(prefix);
+  if (p == MAX_PREFIXES) {
+    return TermIdResult{EMPTY_TERMID, TermIdError::TOO_MANY_PREFIXES};
   }
-  // orcid.org/0000-0001-5208-3432
-  i = s.find("orcid.org/");
-  if (i != string::npos) {
-    string orcid= "ORCID:" + cp;
-    return TermId{orcid,5};
+  return TermIdResult{TermId((p << PREFIX_SHIFT) | (digits << DIGITS_SHIFT) | local), TermIdError::NONE};
+}
+
+/**
+ * The interned strings are compared instead of their indices, which depend on the order in
+ * which the strings were first seen. Looking them up does not lock (see InternTable).
+ */
+bool
+TermId::less_by_strings(const TermId &rhs) const
+{
+  if (prefix_index() != rhs.prefix_index()) {
+    return prefix() < rhs.prefix();
+  }
+  if (has_numeric_id() != rhs.has_numeric_id()) {
+    return has_numeric_id();
   }
-  throw PhenopacketException("Could not create TermId from string: Malformed ontology term id: " +s);
+  if (has_numeric_id()) {
+    return code_ < rhs.code_;
+  }
+  return local_id_table().get(code_ & LOCAL_MASK) < local_id_table().get(rhs.code_ & LOCAL_MASK);
 }
 
-TermId
-TermId::from_url(const string &s){
+/**
+ * The forms we accept, with the part after the last '/' if s is an IRI:
+ * HP:0001234, HP_0001234, and the local ids of HGNC, ICD10 and ORCID IRIs, e.g.,
+ * http://identifiers.org/hgnc/4851 and https://orcid.org/0000-0001-5208-3432.
+ */
+TermIdResult
+TermId::parse(std::string_view s)
+{
+  std::string_view id = last_segment(s);
+  std::size_t i = id.find(':');
+  if (i != std::string_view::npos) {
+    return make(id.substr(0, i), id.substr(i + 1));
+  }
+  if (s.find("hgnc") != std::string_view::npos) {
+    return make("HGNC", id);
+  }
+  if (s.find("ICD10") != std::string_view::npos) {
+    return make("ICD10", id);
+  }
+  // some terms are with _
+  i = id.find('_');
+  if (i != std::string_view::npos) {
+    return make(id.substr(0, i), id.substr(i + 1));
+  }
+  if (s.find("orcid.org/") != std::string_view::npos) {
+    return make("ORCID", id);
+  }
+  return TermIdResult{EMPTY_TERMID, TermIdError::MALFORMED};
+}
+
+TermIdResult
+TermId::parse_url(std::string_view s)
+{
   std::size_t i = s.find("hgnc/");
-  if (i != string::npos) {
-    string hgnc = "HGNC:" + s.substr(i+5);
-    return TermId{hgnc,4};
+  if (i != std::string_view::npos) {
+    return make("HGNC", s.substr(i + 5));
   }
   i = s.find_last_of('/');
-  if (i == string::npos){
-    throw PhenopacketException("Could not create TermId from URL: Malformed TermId URL: " + s);
+  if (i == std::string_view::npos) {
+    return TermIdResult{EMPTY_TERMID, TermIdError::MALFORMED};
   }
-  string st = s.substr(i+1);
-  TermId t = TermId::from_string(st);
-  return t;
+  return parse(s.substr(i + 1));
 }
 
+TermId
+TermId::from_string(std::string_view s)
+{
+  TermIdResult r = parse(s);
+  if (! r) {
+    throw PhenopacketException(error_message(r.error, s));
+  }
+  return r.value;
+}
 
-
-TermId::TermId(const TermId &tid):
-  value_(tid.value_),
-  separator_pos_(tid.separator_pos_) {
+TermId
+TermId::from_url(std::string_view s){
+  TermIdResult r = parse_url(s);
+  if (r.error == TermIdError::MALFORMED) {
+    throw PhenopacketException("Could not create TermId from URL: Malformed TermId URL: " + string(s));
+  } else if (! r) {
+    throw PhenopacketException(error_message(r.error, s));
+  }
+  return r.value;
 }
 
-TermId::TermId(TermId &&tid):
-  value_(std::move(tid.value_)),
-  separator_pos_(tid.separator_pos_)
+size_t
+TermId::parse_all(const std::vector<std::string_view> &ids, std::vector<TermId> &out, std::vector<TermIdError> *errors)
 {
+  out.clear();
+  out.reserve(ids.size());
+  if (errors != nullptr) {
+    errors->assign(ids.size(), TermIdError::NONE);
+  }
+  size_t parsed = 0;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    TermIdResult r = parse(ids[i]);
+    out.push_back(r.value);
+    if (r) {
+      ++parsed;
+    } else if (errors != nullptr) {
+      (*errors)[i] = r.error;
+    }
+  }
+  return parsed;
 }
 
-TermId &
-TermId::operator=(const TermId &tid){
-    value_ = tid.value_;
-    separator_pos_ = tid.separator_pos_;
-    return *this;
-}
-TermId &
-TermId::operator=(TermId &&tid){
-  value_ = std::move(tid.value_);
-  separator_pos_ = tid.separator_pos_;
-  return *this;
+string
+TermId::error_message(TermIdError error, std::string_view s)
+{
+  switch (error) {
+  case TermIdError::NONE:
+    return string();
+  case TermIdError::TOO_MANY_PREFIXES:
+    return "Could not create TermId: too many prefixes (" + string(s) + ")";
+  case TermIdError::TOO_MANY_LOCAL_IDS:
+    return "Could not create TermId: too many local ids (" + string(s) + ")";
+  case TermIdError::MALFORMED:
+    break;
+  }
+  return "Could not create TermId from string: Malformed ontology term id: " + string(s);
 }
 
+/** Scans ask for the same prefix once per term, so each thread remembers the last one it found. */
+int
+TermId::find_prefix_index(std::string_view prefix)
+{
+  thread_local string last_prefix;
+  thread_local int last_index = -1;
+  if (last_index >= 0 && prefix == last_prefix) {
+    return last_index;
+  }
+  uint64_t i;
+  if (! prefix_table().find(prefix, i)) {
+    // not cached, since the prefix may still be interned later
+    return -1;
+  }
+  last_prefix.assign(prefix.data(), prefix.size());
+  last_index = static_cast<int>(i);
+  return last_index;
+}
 
-std::ostream& operator<<(std::ostream& ost, const TermId& tid){
- ost << tid.value_;
- return ost;
+std::string_view
+TermId::prefix() const {
+  return prefix_table().get(code_ >> PREFIX_SHIFT);
 }
 
-bool
-operator==(const TermId& lhs, const TermId& rhs)
+/**
+ * Write the local id to buffer (at least MAX_DIGITS long) unless it is interned.
+ * @return the local id, a view into buffer or into the interned string.
+ */
+static std::string_view
+format_local_id(uint64_t code, char *buffer)
 {
-  return lhs.value_ == rhs.value_;
+  std::size_t digits = (code >> DIGITS_SHIFT) & 0xF;
+  uint64_t local = code & LOCAL_MASK;
+  if (digits == 0) {
+    return local_id_table().get(local);
+  }
+  for (std::size_t i = digits; i > 0; --i) {
+    buffer[i - 1] = static_cast<char>('0' + local % 10);
+    local /= 10;
+  }
+  return std::string_view(buffer, digits);
 }
 
+string
+TermId::get_id() const {
+  char buffer[MAX_DIGITS];
+  return string(format_local_id(code_, buffer));
+}
 
-bool 
-operator!=(const TermId& lhs, const TermId& rhs)
-{
-  return lhs.value_ != rhs.value_;
+string
+TermId::get_value() const {
+  char buffer[MAX_DIGITS];
+  std::string_view p = prefix();
+  std::string_view id = format_local_id(code_, buffer);
+  string value;
+  value.reserve(p.size() + 1 + id.size());
+  value.append(p).append(1, ':').append(id);
+  return value;
 }
-/** Comparison operator is used when we use TermId as a key for std::map */
-bool
-TermId::operator<(const TermId& rhs) const {
-		return value_ < rhs.value_;
+
+
+std::ostream& operator<<(std::ostream& ost, const TermId& tid){
+ char buffer[MAX_DIGITS];
+ ost << tid.prefix() << ':' << format_local_id(tid.code_, buffer);
+ return ost;
 }
 
 
-const TermId EMPTY_TERMID = TermId::from_string("Empty:Empty");
\ No newline at end of file
+const TermId EMPTY_TERMID = TermId::from_string("Empty:Empty");
@@ -2,39 +2,133 @@
 #define TERMID_H
 
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <vector>
 using std::string;
 
+struct TermIdResult;
+
+/** Why a string could not be converted to a TermId (see TermId::parse). */
+enum class TermIdError {
+  NONE,
+  MALFORMED,          // neither a CURIE nor an IRI, HGNC, ICD10 or ORCID id that we recognize
+  TOO_MANY_PREFIXES,  // the prefix table is full
+  TOO_MANY_LOCAL_IDS  // the table of non-numeric local ids is full
+};
+
 /**
  * Class to represent the identifier of an ontology term, e.g., HP:0001234.
+ *
+ * A TermId is a single 64-bit code, so that it can be copied, compared and hashed as an
+ * integer. The prefix (HP) is interned in a process-wide table and stored as its index.
+ * A local id of up to 12 decimal digits (0001234) is stored as its value together with the
+ * number of digits, so that leading zeros are kept; any other local id (e.g., C4024355 or
+ * 0000-0001-5208-3432) is interned as well. The CURIE is only put together again for output
+ * (get_value, operator<<).
+ *
+ * The top bit of the code is never set (there are at most 2^15 prefixes), so that other
+ * types can store a TermId or a tagged value of their own in 64 bits (see Xref).
+ *
+ * The order defined by operator< sorts the ids by the prefix string and, within a prefix,
+ * puts the numeric local ids first, sorted by number of digits and then numerically, followed
+ * by the other local ids in string order. It does not depend on the order in which prefixes
+ * and local ids were interned, so it is the same in every run. Ids with the same prefix and
+ * numeric local ids, nearly all ids of an ontology, are compared as integers.
  */
 class TermId {
  private:
-  string value_;
-  std::size_t separator_pos_;
+  friend class OntologySnapshot;
+  friend struct std::hash<TermId>;
+  friend class Xref;
+  /** 0 (1 bit) | prefix index (15 bits) | number of digits of the local id, 0 if interned (4 bits) | local id (44 bits) */
+  uint64_t code_;
   TermId(const string &s, std::size_t pos);
+  explicit TermId(uint64_t code): code_(code) {}
+  static TermIdResult make(std::string_view prefix, std::string_view local_id);
+  bool has_numeric_id() const { return ((code_ >> 44) & 0xF) != 0; }
+  /** operator< for ids with different prefixes or non-numeric local ids. */
+  bool less_by_strings(const TermId &rhs) const;
 
  public:
-  TermId(const TermId  &tid);
-  TermId(TermId &&tid);
-  TermId &operator=(const TermId &tid);
-  TermId &operator=(TermId &&tid);
-  bool operator<(const TermId& rhs) const;
-  ~TermId(){}
-  static TermId from_string(const string &s);
-  static TermId from_url(const string &s);
-  string get_value() const { return value_; }
-  string get_prefix() const { return value_.substr(0,separator_pos_); }
-  string get_id() const { return value_.substr(separator_pos_+1); }
+  TermId(const TermId  &tid) = default;
+  TermId(TermId &&tid) = default;
+  TermId &operator=(const TermId &tid) = default;
+  TermId &operator=(TermId &&tid) = default;
+  bool operator<(const TermId& rhs) const
+  {
+    if (prefix_index() == rhs.prefix_index() && has_numeric_id() && rhs.has_numeric_id()) {
+      return code_ < rhs.code_;
+    }
+    return less_by_strings(rhs);
+  }
+  ~TermId() = default;
+  /** Convert a CURIE (HP:0001234) or the last segment of an IRI (HP_0001234); throws PhenopacketException if malformed. */
+  static TermId from_string(std::string_view s);
+  /** Convert an IRI (http://purl.obolibrary.org/obo/HP_0001234); throws PhenopacketException if malformed. */
+  static TermId from_url(std::string_view s);
+  /**
+   * Same as from_string, but a malformed id is reported in the result instead of by an
+   * exception; no string is built. Use this where malformed ids are expected (e.g., xrefs).
+   */
+  static TermIdResult parse(std::string_view s);
+  /** Same as from_url, but without exceptions (see parse). */
+  static TermIdResult parse_url(std::string_view s);
+  /**
+   * Convert a column of ids (see parse). out[i] is EMPTY_TERMID where errors[i] is not NONE.
+   * @return the number of ids that were converted.
+   */
+  static size_t parse_all(const std::vector<std::string_view> &ids, std::vector<TermId> &out,
+                          std::vector<TermIdError> *errors = nullptr);
+  /** @return the message from_string and from_url throw for error. */
+  static string error_message(TermIdError error, std::string_view s);
+  /** @return the prefix, e.g., HP. The view refers to the interned prefix and remains valid. */
+  std::string_view prefix() const;
+  bool has_prefix(std::string_view prefix) const { return this->prefix() == prefix; }
+  /** @return the index of the prefix in the process-wide prefix table; equal prefixes have equal indices. */
+  int prefix_index() const { return static_cast<int>(code_ >> 48); }
+  /**
+   * @return the index of prefix (see prefix_index), or -1 if no TermId with this prefix exists.
+   * Look the index up once to compare the prefixes of many ids as integers.
+   */
+  static int find_prefix_index(std::string_view prefix);
+  /** @return the CURIE, e.g., HP:0001234. */
+  string get_value() const;
+  string get_prefix() const { return string(prefix()); }
+  /** @return the local id, e.g., 0001234. Numeric ids are not stored as text, so this formats a new string. */
+  string get_id() const;
+  /** @return the integer code of this id (equal ids have equal codes). */
+  uint64_t get_code() const { return code_; }
   friend bool operator==(const TermId& lhs, const TermId& tid);
   friend bool operator!=(const TermId& lhs, const TermId& tid);
   friend std::ostream& operator<<(std::ostream& ost, const TermId& tid);
 };
-bool operator==(const TermId& lhs, const TermId& tid);
-bool operator!=(const TermId& lhs, const TermId& tid);
+inline bool operator==(const TermId& lhs, const TermId& rhs) { return lhs.code_ == rhs.code_; }
+inline bool operator!=(const TermId& lhs, const TermId& rhs) { return lhs.code_ != rhs.code_; }
 std::ostream& operator<<(std::ostream& ost, const TermId& tid);
 
+namespace std {
+template <>
+struct hash<TermId> {
+  size_t operator()(const TermId &tid) const noexcept
+  {
+    // Fibonacci hashing, so that the prefix bits also reach the low bits
+    uint64_t h = tid.code_ * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+};
+}
+
 // static instance
 extern const TermId EMPTY_TERMID;
 
+/** A TermId, or the reason why a string could not be converted (then value is EMPTY_TERMID). */
+struct TermIdResult {
+  TermId value;
+  TermIdError error;
+  explicit operator bool() const { return error == TermIdError::NONE; }
+};
+
 #endif
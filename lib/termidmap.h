@@ -0,0 +1,119 @@
+/**
+ * @file termidmap.h
+ * @brief Open-addressing hash table keyed by TermId.
+ * @author Peter N Robinson
+ *
+ * The terms of an ontology do not change after it has been built, and every query
+ * (get_term, get_isa_parents, exists_path, ...) starts by looking up a TermId. A TermId
+ * is a 64-bit code (see termid.h), so the table only stores the codes in one array and
+ * the values in a parallel array. A lookup hashes the code and scans the key array
+ * from there (linear probing), which usually touches a single cache line.
+ * Entries cannot be removed.
+ */
+#ifndef TERMIDMAP_H
+#define TERMIDMAP_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "termid.h"
+
+template <typename V>
+class TermIdMap {
+private:
+  /** No TermId has this code (its digit-count field would be 15, see termid.cc). */
+  static constexpr uint64_t EMPTY = ~uint64_t(0);
+  std::vector<uint64_t> keys_;
+  std::vector<V> values_;
+  size_t size_ = 0;
+  /** 64 - log2(number of slots); the slot of a key is taken from the high bits of its hash. */
+  int shift_ = 64;
+
+  size_t slot(uint64_t code) const { return static_cast<size_t>((code * 0x9E3779B97F4A7C15ULL) >> shift_); }
+  size_t mask() const { return keys_.size() - 1; }
+  /** @return the slot that holds code, or the empty slot where it would be inserted. */
+  size_t probe(uint64_t code) const
+  {
+    size_t i = slot(code);
+    while (keys_[i] != code && keys_[i] != EMPTY) {
+      i = (i + 1) & mask();
+    }
+    return i;
+  }
+  void rehash(size_t n_slots)
+  {
+    std::vector<uint64_t> keys(n_slots, EMPTY);
+    std::vector<V> values(n_slots);
+    keys.swap(keys_);
+    values.swap(values_);
+    shift_ = 64;
+    for (size_t n = n_slots; n > 1; n >>= 1) {
+      --shift_;
+    }
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (keys[i] != EMPTY) {
+        size_t j = probe(keys[i]);
+        keys_[j] = keys[i];
+        values_[j] = std::move(values[i]);
+      }
+    }
+  }
+
+public:
+  TermIdMap() = default;
+  /** Make room for n entries, so that no rehash is needed while they are inserted. */
+  void reserve(size_t n)
+  {
+    size_t n_slots = 8;
+    // the load factor is kept at or below 1/2
+    while (n_slots < 2 * n) {
+      n_slots <<= 1;
+    }
+    if (n_slots > keys_.size()) {
+      rehash(n_slots);
+    }
+  }
+  /** Add tid with value unless tid is already present (as std::map::insert). @return true if it was added. */
+  bool insert(const TermId &tid, V value)
+  {
+    if (2 * (size_ + 1) > keys_.size()) {
+      reserve(size_ + 1);
+    }
+    size_t i = probe(tid.get_code());
+    if (keys_[i] != EMPTY) {
+      return false;
+    }
+    keys_[i] = tid.get_code();
+    values_[i] = std::move(value);
+    ++size_;
+    return true;
+  }
+  /** @return the value for tid, or nullptr if tid is not in the map. */
+  const V *find(const TermId &tid) const
+  {
+    if (size_ == 0) {
+      return nullptr;
+    }
+    size_t i = probe(tid.get_code());
+    return keys_[i] == EMPTY ? nullptr : &values_[i];
+  }
+  V *find(const TermId &tid)
+  {
+    return const_cast<V *>(static_cast<const TermIdMap &>(*this).find(tid));
+  }
+  /** @return the value for tid; throws std::out_of_range if tid is not in the map (as std::map::at). */
+  const V &at(const TermId &tid) const
+  {
+    const V *v = find(tid);
+    if (v == nullptr) {
+      throw std::out_of_range("TermIdMap::at: " + tid.get_value());
+    }
+    return *v;
+  }
+  bool contains(const TermId &tid) const { return find(tid) != nullptr; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+};
+
+#endif
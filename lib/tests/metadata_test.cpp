@@ -16,6 +16,7 @@
 #include "../phenotools.h"
 #include "../ontology.h"
 #include "../jsonobo.h"
+#include "../ontologyregistry.h"
 #include <google/protobuf/message.h>
 #include <google/protobuf/util/json_util.h>
 
@@ -91,4 +92,51 @@ TEST_CASE("Check Metadata", "[metadata_has_redundant]") {
   REQUIRE(val.get_cause() == phenotools::ValidationCause::METADATA_HAS_SUPERFLUOUS_ONTOLOGY);
   REQUIRE(val.is_warning());
 
-}
\ No newline at end of file
+}
+
+
+TEST_CASE("Semantic validation with an ontology registry", "[ontology_registry]") {
+  OntologyRegistry registry;
+  registry.add("hp", "../testdata/hp.small.json");
+  // stand-in for GENO, so that the zygosity GENO:0000134 is not found
+  registry.add("GENO", "../testdata/hp.small.obo");
+  registry.add("HPO", "../testdata/hp.small.json");
+  registry.load(LoadProfile::GRAPH_LABELS, 2);
+  REQUIRE(3 == registry.get_prefixes().size());
+  REQUIRE(registry.has_ontology("HP"));
+  REQUIRE_FALSE(registry.has_ontology("MONDO"));
+  REQUIRE(registry.get_errors("HP").empty());
+  // each file is loaded once
+  REQUIRE(registry.get("HP") == registry.get("HPO"));
+  REQUIRE(registry.get("HP") != registry.get("GENO"));
+  REQUIRE(5 == registry.get("geno")->current_term_count());
+
+  std::ifstream inFile("../testdata/small-phenopacket-1.json");
+  std::stringstream sstr;
+  sstr << inFile.rdbuf();
+  ::google::protobuf::util::JsonParseOptions options;
+  ::org::phenopackets::schema::v1::Phenopacket phenopacketpb;
+  ::google::protobuf::util::JsonStringToMessage (sstr.str(), &phenopacketpb, options);
+  phenotools::Phenopacket ppacket(phenopacketpb);
+  vector<phenotools::Validation> validation = ppacket.semantically_validate(registry);
+  // the five issues of the single-ontology validation plus the unknown GENO term
+  REQUIRE(6 == validation.size());
+  REQUIRE(validation.at(0).get_cause() == phenotools::ValidationCause::UNRECOGNIZED_TERMID);
+  REQUIRE("[ERROR] Could not find GENO:0000134 in the GENO ontology" == validation.at(0).message());
+  REQUIRE(validation.at(1).get_cause() == phenotools::ValidationCause::REDUNDANT_ANNOTATION);
+}
+
+TEST_CASE("Ontology registry with a missing file", "[ontology_registry]") {
+  OntologyRegistry registry;
+  registry.add("HP", "../testdata/hp.small.json");
+  registry.add("MONDO", "../testdata/does-not-exist.json");
+  registry.add("GENO", "../testdata/does-not-exist.obo");
+  registry.load(LoadProfile::GRAPH_LABELS, 2);
+  REQUIRE(registry.has_ontology("HP"));
+  REQUIRE(registry.get_errors("HP").empty());
+  REQUIRE_FALSE(registry.has_ontology("MONDO"));
+  REQUIRE(1 == registry.get_errors("MONDO").size());
+  REQUIRE(registry.get_errors("MONDO").at(0).find("does-not-exist.json") != string::npos);
+  REQUIRE_FALSE(registry.has_ontology("GENO"));
+  REQUIRE(1 == registry.get_errors("GENO").size());
+}
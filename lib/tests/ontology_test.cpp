@@ -7,6 +7,14 @@
 
 #include <memory>
 #include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <random>
+#include <thread>
 
 #include "catch.hpp"
 #include "../base.pb.h"
@@ -15,6 +23,8 @@
 #include "../phenotools.h"
 #include "../ontology.h"
 #include "../jsonobo.h"
+#include "../snapshot.h"
+#include "../ontologybuilder.h"
 #include <google/protobuf/message.h>
 #include <google/protobuf/util/json_util.h>
 
@@ -88,6 +98,134 @@ TEST_CASE("Test exists path algorithm with specific edge type","[exists_path_edg
   REQUIRE_FALSE(ontology->exists_path(t5, t2));
 }
 
+TEST_CASE("Ancestor closure agrees with the graph search","[ancestor_closure]") {
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboParser parser {hp_json_path};
+  std::unique_ptr<Ontology>  ontology = parser.get_ontology();
+  TermId t1 = TermId::from_string("HP:0000001");
+  TermId t3 = TermId::from_string("HP:0000003");
+  TermId t4 = TermId::from_string("HP:0000004");
+  TermId t5 = TermId::from_string("HP:0000005");
+  REQUIRE_FALSE(ontology->has_ancestor_closure());
+  REQUIRE_THROWS_AS(ontology->get_ancestor_indices(t3), PhenopacketException);
+  vector<std::set<TermId>> expected;
+  for (const TermId &tid : ontology->current_term_ids()) {
+    expected.push_back(ontology->get_ancestors(tid));
+  }
+  REQUIRE(ontology->is_ancestor(t1, t5));
+  ontology->build_ancestor_closure();
+  REQUIRE(ontology->has_ancestor_closure());
+  const vector<TermId> &termids = ontology->current_term_ids();
+  for (size_t i = 0; i < termids.size(); ++i) {
+    REQUIRE(ontology->get_ancestors(termids[i]) == expected[i]);
+    TermRange<int> row = ontology->get_ancestor_indices(termids[i]);
+    REQUIRE(row.size() == expected[i].size());
+    REQUIRE(std::is_sorted(row.begin(), row.end()));
+    for (const TermId &a : termids) {
+      REQUIRE(ontology->is_ancestor(a, termids[i]) == (expected[i].count(a) > 0));
+    }
+  }
+  REQUIRE(ontology->is_ancestor(t5, t5));
+  REQUIRE(ontology->is_ancestor(t4, t5));
+  REQUIRE_FALSE(ontology->is_ancestor(t3, t5));
+  REQUIRE_FALSE(ontology->is_ancestor(t5, t1));
+  AncestorClosure::Stats stats = ontology->ancestor_closure().stats();
+  REQUIRE(stats.vertices == termids.size());
+  REQUIRE(stats.entries >= termids.size());
+  REQUIRE(stats.bytes >= stats.entries * sizeof(int));
+  // copies and moves keep the edge types and counts along with the CSR arrays and the closure
+  Ontology copy{*ontology};
+  REQUIRE(copy.has_ancestor_closure());
+  REQUIRE(copy.edge_count() == ontology->edge_count());
+  REQUIRE(copy.is_a_edge_count() == ontology->is_a_edge_count());
+  REQUIRE(copy.get_isa_parents(t5) == ontology->get_isa_parents(t5));
+  Ontology moved{std::move(copy)};
+  REQUIRE(moved.get_ancestors(t5) == ontology->get_ancestors(t5));
+  moved = *ontology;
+  REQUIRE(moved.get_isa_parents(t4) == ontology->get_isa_parents(t4));
+}
+
+/** A DAG of n terms in which term i has one to three parents among the terms before it. */
+static std::unique_ptr<Ontology> random_dag(int n, unsigned int seed)
+{
+  std::mt19937 rng(seed);
+  vector<Term> terms;
+  vector<Edge> edges;
+  for (int i = 1; i <= n; ++i) {
+    TermId tid = TermId::from_string("HP:" + std::to_string(1000000 + i).substr(1));
+    terms.emplace_back(tid, "term " + std::to_string(i));
+    for (int k = 0; i > 1 && k < 1 + static_cast<int>(rng() % 3); ++k) {
+      int parent = 1 + static_cast<int>(rng() % (i - 1));
+      edges.push_back(Edge::of(tid, EdgeType::IS_A, terms[parent - 1].get_term_id()));
+    }
+  }
+  return std::make_unique<Ontology>("hp", terms, edges, vector<PredicateValue>(), vector<Property>());
+}
+
+TEST_CASE("Reachability index agrees with the ancestor closure","[reachability_index]") {
+  std::unique_ptr<Ontology> ontology = random_dag(300, 7);
+  const vector<TermId> &termids = ontology->current_term_ids();
+  ontology->build_reachability_index(2);
+  REQUIRE(ontology->has_reachability_index());
+  vector<bool> indexed;
+  for (const TermId &s : termids) {
+    for (const TermId &d : termids) {
+      indexed.push_back(ontology->exists_path(s, d));
+    }
+  }
+  ontology->build_ancestor_closure();
+  size_t k = 0;
+  size_t n_paths = 0;
+  for (const TermId &s : termids) {
+    for (const TermId &d : termids) {
+      bool expected = ontology->exists_path(s, d);
+      REQUIRE(indexed[k++] == expected);
+      n_paths += expected;
+    }
+  }
+  REQUIRE(n_paths > termids.size());
+  // the small test ontology, with the answers of the graph search
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboParser parser {hp_json_path};
+  std::unique_ptr<Ontology> small = parser.get_ontology();
+  vector<bool> searched;
+  for (const TermId &s : small->current_term_ids()) {
+    for (const TermId &d : small->current_term_ids()) {
+      searched.push_back(small->exists_path(s, d));
+    }
+  }
+  small->build_reachability_index();
+  k = 0;
+  for (const TermId &s : small->current_term_ids()) {
+    for (const TermId &d : small->current_term_ids()) {
+      REQUIRE(small->exists_path(s, d) == searched[k++]);
+      REQUIRE(small->exists_path(s, d, EdgeType::IS_A) == searched[k - 1]);
+    }
+  }
+  REQUIRE(small->reachability_index().stats().vertices == small->current_term_ids().size());
+  // a copy answers from its own copy of the index, and from the edge types for the graph search
+  Ontology copy{*ontology};
+  REQUIRE(copy.has_reachability_index());
+  k = 0;
+  for (const TermId &s : termids) {
+    for (const TermId &d : termids) {
+      REQUIRE(copy.exists_path(s, d) == indexed[k]);
+      REQUIRE(copy.exists_path(s, d, EdgeType::IS_A) == indexed[k++]);
+    }
+  }
+}
+
+TEST_CASE("Reachability index is not built for a cyclic graph","[reachability_index]") {
+  TermId a = TermId::from_string("HP:0000001");
+  TermId b = TermId::from_string("HP:0000002");
+  TermId c = TermId::from_string("HP:0000003");
+  vector<Term> terms{Term(a, "a"), Term(b, "b"), Term(c, "c")};
+  vector<Edge> edges{Edge::of(b, EdgeType::IS_A, a), Edge::of(c, EdgeType::IS_A, b), Edge::of(b, EdgeType::IS_A, c)};
+  Ontology ontology("hp", terms, edges, vector<PredicateValue>(), vector<Property>());
+  ontology.build_reachability_index();
+  REQUIRE_FALSE(ontology.has_reachability_index());
+}
+
 TEST_CASE("Have common ancestor","[have_common_anc]") {
   string hp_json_path = "../testdata/hp.small.json";
   JsonOboParser parser {hp_json_path};
@@ -115,12 +253,237 @@ TEST_CASE("Test Term date", "[term_date]") {
   std::optional<Term> term = ontology->get_term(t1);
   REQUIRE(term.has_value());
   // : "2012-04-22T04:38:20Z"
-  tm expected_date = {};
-  expected_date.tm_year = 2012 - 1900;
-  expected_date.tm_mon  = 3;// zero-based
-  expected_date.tm_mday = 22; // zero-based
-  tm creation_date = term->get_creation_date();
-  REQUIRE(expected_date.tm_year == creation_date.tm_year);
-  REQUIRE(expected_date.tm_mon == creation_date.tm_mon);
-  REQUIRE(expected_date.tm_mday == creation_date.tm_mday);
+  CivilDate creation_date = term->get_creation_date();
+  REQUIRE(CivilDate(2012, 4, 22) == creation_date);
+  REQUIRE(2012 == creation_date.year());
+  REQUIRE(4 == creation_date.month());
+  REQUIRE(22 == creation_date.day());
+  REQUIRE(creation_date == ontology->term(t1)->get_creation_date());
+}
+
+TEST_CASE("CivilDate and date windows", "[civil_date]") {
+  REQUIRE(CivilDate(2012, 4, 22) == CivilDate::parse("2012-04-22T04:38:20Z"));
+  REQUIRE(CivilDate(2009, 1, 14) == CivilDate::parse("2009-1-14"));
+  REQUIRE(CivilDate::parse("2019-02-29").empty());
+  REQUIRE(CivilDate::parse("22.04.2012").empty());
+  REQUIRE(CivilDate::parse("").empty());
+  static_assert(CivilDate(2020, 2, 29) < CivilDate(2020, 3, 1), "compared as integers");
+  REQUIRE(1 == CivilDate(2020, 3, 1).day_number() - CivilDate(2020, 2, 29).day_number());
+  CivilDate d = CivilDate::parse("2000-02-29");
+  REQUIRE(2000 == d.year());
+  REQUIRE(2 == d.month());
+  REQUIRE(29 == d.day());
+  REQUIRE("2000-02-29" == d.to_string());
+  REQUIRE(d == CivilDate::from_day_number(d.day_number()));
+  REQUIRE(CivilDate() < CivilDate(1, 1, 1));
+
+  DateWindow window{CivilDate(2010, 1, 1), CivilDate(2012, 12, 31)};
+  REQUIRE(window.contains(CivilDate(2012, 12, 31)));
+  REQUIRE_FALSE(window.contains(CivilDate(2013, 1, 1)));
+  REQUIRE_FALSE(window.contains(CivilDate()));
+  vector<CivilDate> dates = {CivilDate(2009, 12, 31), CivilDate(2010, 1, 1), CivilDate(), CivilDate(2011, 6, 1)};
+  REQUIRE(2 == window.count(dates.data(), dates.size()));
+
+  JsonOboParser parser {"../testdata/hp.small.json"};
+  std::unique_ptr<Ontology> ontology = parser.get_ontology();
+  REQUIRE(4 == ontology->count_terms_created_in(window));
+  for (DateWindow w : {window, DateWindow{CivilDate(2008, 1, 1), CivilDate(2008, 1, 1)}}) {
+    int expected = ontology->filter_terms([&w](const TermView &t) { return w.contains(t.get_creation_date()); });
+    REQUIRE(expected == ontology->count_terms_created_in(w));
+  }
+}
+
+
+TEST_CASE("Build ontology from parser with OntologyBuilder","[builder]") {
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboParser parser {hp_json_path};
+  OntologyBuilder builder = parser.release_builder();
+  REQUIRE(5 == builder.get_terms().size());
+  REQUIRE(4 == builder.get_edges().size());
+  std::unique_ptr<Ontology> ontology = builder.build();
+  // build() takes over the buffers of the builder
+  REQUIRE(builder.get_terms().empty());
+  REQUIRE(builder.get_edges().empty());
+  REQUIRE(5 == ontology->current_term_count());
+  REQUIRE(4 == ontology->edge_count());
+  // each IS_A edge is counted once and stored together with its inverse
+  REQUIRE(4 == ontology->is_a_edge_count());
+  REQUIRE(8 == ontology->edge_count_with_supplemental_edges());
+  REQUIRE("http://purl.obolibrary.org/obo/hp/releases/2019-09-06" == ontology->get_version());
+  REQUIRE(ontology->exists_path(TermId::from_string("HP:0000003"), TermId::from_string("HP:0000001")));
+}
+
+
+TEST_CASE("Term views refer to the terms of the ontology","[termview]") {
+  JsonOboParser parser {"../testdata/hp.small.json"};
+  std::unique_ptr<Ontology> ontology = parser.get_ontology();
+  TermId t4 = TermId::from_string("HP:0000004");
+  TermView view = ontology->term(t4);
+  REQUIRE(view);
+  REQUIRE("Fake term 4" == view->label());
+  REQUIRE("Definition for HP:0000004." == view->definition());
+  // no copy: each lookup refers to the same stored label
+  REQUIRE(view->label().data() == ontology->term(t4)->label().data());
+  REQUIRE(view->label() == ontology->get_term(t4)->get_label());
+  REQUIRE_FALSE(ontology->term(TermId::from_string("HP:0000999")));
+  // current terms are stored at their vertex index
+  const vector<TermId> &ids = ontology->current_term_ids();
+  for (int i = 0; i < ontology->current_term_count(); ++i) {
+    REQUIRE(i == ontology->term(ids[i]).index());
+    REQUIRE(ids[i] == ontology->term_at(i).id());
+  }
+  REQUIRE(1 == view->synonyms().size());
+  REQUIRE(2012 == ontology->term(TermId::from_string("HP:0000001"))->get_creation_date().year());
+  REQUIRE(5 == ontology->filter_terms([](const TermView &t) { return t.label().find("Fake") == 0; }));
+}
+
+
+TEST_CASE("Merge the imported graphs of an ontology","[imports]") {
+  // the second graph repeats HP:0000004 and the edge HP:0000005 -> HP:0000004
+  string hp_json_path = "../testdata/hp.imports.json";
+  JsonOboOptions options;
+  options.threads = 2;
+  for (JsonParseMode mode : {JsonParseMode::DOM, JsonParseMode::STREAMING}) {
+    options.mode = mode;
+    JsonOboParser parser {hp_json_path, options};
+    OntologyBuilder builder = parser.release_builder();
+    REQUIRE(7 == builder.get_terms().size());
+    REQUIRE(6 == builder.get_edges().size());
+    std::unique_ptr<Ontology> ontology = builder.build();
+    REQUIRE(6 == ontology->current_term_count());
+    REQUIRE(6 == ontology->edge_count());
+    REQUIRE(5 == ontology->is_a_edge_count());
+    REQUIRE(10 == ontology->edge_count_with_supplemental_edges());
+    // id and version are taken from the main graph
+    REQUIRE("http://purl.obolibrary.org/obo/hp.json" == ontology->get_id());
+    REQUIRE("http://purl.obolibrary.org/obo/hp/releases/2019-09-06" == ontology->get_version());
+    std::optional<Term> term = ontology->get_term(TermId::from_string("HP:0000004"));
+    REQUIRE(term);
+    REQUIRE("Fake term 4" == term->get_label());
+    TermId t6 = TermId::from_string("HP:0000006");
+    REQUIRE(ontology->exists_path(t6, TermId::from_string("HP:0000001")));
+    REQUIRE(1 == ontology->get_isa_parents(TermId::from_string("HP:0000005")).size());
+  }
+}
+
+
+TEST_CASE("Test ontology snapshot round trip","[snapshot]") {
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboParser parser {hp_json_path};
+  std::unique_ptr<Ontology>  ontology = parser.get_ontology();
+  REQUIRE("http://purl.obolibrary.org/obo/hp/releases/2019-09-06" == ontology->get_version());
+  REQUIRE("hp-2019-09-06.phsnap" == OntologySnapshot::default_file_name(*ontology));
+  string snapshot_path = "hp.small.phsnap";
+  OntologySnapshot::write(*ontology, snapshot_path);
+  REQUIRE(OntologySnapshot::is_snapshot(snapshot_path));
+  REQUIRE_FALSE(OntologySnapshot::is_snapshot(hp_json_path));
+  REQUIRE(ontology->get_version() == OntologySnapshot::read_version(snapshot_path));
+  std::unique_ptr<Ontology> loaded = OntologySnapshot::load(snapshot_path, ontology->get_version());
+  REQUIRE(ontology->get_id() == loaded->get_id());
+  REQUIRE(ontology->current_term_count() == loaded->current_term_count());
+  REQUIRE(ontology->edge_count() == loaded->edge_count());
+  REQUIRE(ontology->edge_count_with_supplemental_edges() == loaded->edge_count_with_supplemental_edges());
+  REQUIRE(ontology->predicate_count() == loaded->predicate_count());
+  TermId t1 = TermId::from_string("HP:0000001");
+  TermId t3 = TermId::from_string("HP:0000003");
+  TermId t4 = TermId::from_string("HP:0000004");
+  REQUIRE(loaded->exists_path(t3,t1));
+  REQUIRE_FALSE(loaded->exists_path(t3,t4));
+  std::optional<Term> term = loaded->get_term(t4);
+  REQUIRE(term);
+  REQUIRE("Fake term 4" == term->get_label());
+  REQUIRE("Definition for HP:0000004." == term->get_definition());
+  REQUIRE(1 == term->get_synonyms().size());
+  REQUIRE(term->get_synonyms().at(0).is_exact());
+  REQUIRE(3 == term->get_property_values().size());
+  std::unique_ptr<Ontology> lazy = OntologySnapshot::load(snapshot_path, TermLoading::LAZY);
+  std::optional<Term> lazy_term = lazy->get_term(t4);
+  REQUIRE(lazy_term);
+  REQUIRE_FALSE(lazy_term->is_materialized());
+  REQUIRE("Fake term 4" == lazy_term->get_label());
+  REQUIRE("Definition for HP:0000004." == lazy_term->get_definition());
+  REQUIRE(1 == lazy_term->get_synonyms().size());
+  REQUIRE(3 == lazy_term->get_property_values().size());
+  REQUIRE_THROWS_AS(OntologySnapshot::load(snapshot_path, "2000-01-01"), PhenopacketException);
+  std::remove(snapshot_path.c_str());
+}
+
+TEST_CASE("Lazy snapshot terms can be read on several threads","[snapshot]") {
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboParser parser {hp_json_path};
+  std::unique_ptr<Ontology>  ontology = parser.get_ontology();
+  string snapshot_path = "hp.small.threads.phsnap";
+  OntologySnapshot::write(*ontology, snapshot_path);
+  std::unique_ptr<const Ontology> lazy = OntologySnapshot::load(snapshot_path, TermLoading::LAZY);
+  const vector<TermId> &tids = lazy->current_term_ids();
+  // each thread decodes every term; the views must all return the published details
+  vector<vector<const char *>> definitions(4);
+  vector<std::thread> threads;
+  for (size_t t = 0; t < definitions.size(); ++t) {
+    threads.emplace_back([&, t]() {
+      for (const TermId &tid : tids) {
+        definitions[t].push_back(lazy->term(tid)->definition().data());
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  std::stringstream stats;
+  lazy->output_descriptive_statistics(stats);
+  REQUIRE(stats.str().find("lazy_terms_decoded: " + std::to_string(tids.size())) != string::npos);
+  // decoding the same details again does not add to the arena
+  size_t stored_bytes = StringArena::global().stats().stored_bytes;
+  std::unique_ptr<const Ontology> reloaded = OntologySnapshot::load(snapshot_path, TermLoading::LAZY);
+  for (const TermId &tid : tids) {
+    reloaded->term(tid)->definition();
+  }
+  REQUIRE(stored_bytes == StringArena::global().stats().stored_bytes);
+  for (size_t i = 0; i < tids.size(); ++i) {
+    REQUIRE(lazy->term(tids[i])->is_materialized());
+    REQUIRE(ontology->term(tids[i])->get_definition() == lazy->term(tids[i])->get_definition());
+    for (size_t t = 1; t < definitions.size(); ++t) {
+      REQUIRE(definitions[0][i] == definitions[t][i]);
+    }
+  }
+  std::remove(snapshot_path.c_str());
+}
+
+/** Copy the snapshot at path, overwriting the width bytes that start back bytes before the string pool with value. */
+static void corrupt_snapshot(const string &path, const string &corrupt_path, size_t back, int32_t value, size_t width)
+{
+  std::ifstream in(path, std::ios::binary);
+  string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  // strings_offset follows the magic, the format version, the byte order mark, records_offset and records_size
+  uint64_t strings_offset;
+  std::memcpy(&strings_offset, bytes.data() + 32, sizeof(strings_offset));
+  std::memcpy(&bytes[strings_offset - back], &value, width);
+  std::ofstream out(corrupt_path, std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), bytes.size());
+}
+
+TEST_CASE("Test corrupted ontology snapshot","[snapshot]") {
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboParser parser {hp_json_path};
+  std::unique_ptr<Ontology>  ontology = parser.get_ontology();
+  string snapshot_path = "hp.small.corrupt.phsnap";
+  string corrupt_path = "hp.small.corrupt2.phsnap";
+  OntologySnapshot::write(*ontology, snapshot_path);
+  // the records end with the edge offsets, the edge targets and the edge types, each preceded by its length
+  const size_t edges = ontology->edge_count_with_supplemental_edges();
+  const size_t last_type = 1;
+  const size_t last_target = edges + 4 + 4;
+  const size_t last_offset = edges + 4 + 4 * edges + 4 + 4;
+  corrupt_snapshot(snapshot_path, corrupt_path, last_type, 0, 1);
+  REQUIRE_NOTHROW(OntologySnapshot::load(corrupt_path));
+  corrupt_snapshot(snapshot_path, corrupt_path, last_type, 200, 1);
+  REQUIRE_THROWS_AS(OntologySnapshot::load(corrupt_path), PhenopacketException);
+  corrupt_snapshot(snapshot_path, corrupt_path, last_target, ontology->current_term_count(), 4);
+  REQUIRE_THROWS_AS(OntologySnapshot::load(corrupt_path), PhenopacketException);
+  corrupt_snapshot(snapshot_path, corrupt_path, last_target, -1, 4);
+  REQUIRE_THROWS_AS(OntologySnapshot::load(corrupt_path), PhenopacketException);
+  corrupt_snapshot(snapshot_path, corrupt_path, last_offset, edges - 1, 4);
+  REQUIRE_THROWS_AS(OntologySnapshot::load(corrupt_path), PhenopacketException);
+  std::remove(snapshot_path.c_str());
+  std::remove(corrupt_path.c_str());
 }
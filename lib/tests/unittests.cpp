@@ -2,6 +2,11 @@
 
 #include <memory>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
 
 #include "catch.hpp"
 #include "../base.pb.h"
@@ -9,7 +14,11 @@
 #include "../interpretation.pb.h"
 #include "../phenotools.h"
 #include "../ontology.h"
+#include "../termidmap.h"
+#include "../stringarena.h"
+#include "../staticregistry.h"
 #include "../jsonobo.h"
+#include "../oboparser.h"
 #include <google/protobuf/message.h>
 #include <google/protobuf/util/json_util.h>
 
@@ -402,6 +411,198 @@ TEST_CASE("Procedure","[procedure]") {
   procedurepb.release_code();
 }
 
+TEST_CASE("TermId is stored as an integer code","[termid]")
+{
+  REQUIRE(8 == sizeof(TermId));
+  TermId hp = TermId::from_string("HP:0001166");
+  REQUIRE("HP:0001166" == hp.get_value());
+  REQUIRE("HP" == hp.get_prefix());
+  REQUIRE("0001166" == hp.get_id());
+  REQUIRE(hp == TermId::from_url("http://purl.obolibrary.org/obo/HP_0001166"));
+  REQUIRE(std::hash<TermId>{}(hp) == std::hash<TermId>{}(TermId::from_string("HP:0001166")));
+  // leading zeros are part of the id
+  REQUIRE(hp != TermId::from_string("HP:1166"));
+  REQUIRE("1166" == TermId::from_string("HP:1166").get_id());
+  REQUIRE(TermId::from_string("HP:0000118") < hp);
+  // local ids that are not numbers are interned
+  TermId umls = TermId::from_string("UMLS:C4024355");
+  REQUIRE("UMLS:C4024355" == umls.get_value());
+  TermId orcid = TermId::from_string("https://orcid.org/0000-0001-5208-3432");
+  REQUIRE("ORCID:0000-0001-5208-3432" == orcid.get_value());
+  REQUIRE("ICD10:Q87.1" == TermId::from_string("http://purl.bioontology.org/ontology/ICD10/Q87.1").get_value());
+  REQUIRE("HGNC:12345" == TermId::from_url("http://identifiers.org/hgnc/12345").get_value());
+  REQUIRE("Empty:Empty" == EMPTY_TERMID.get_value());
+  // the prefix is a view of the interned string
+  REQUIRE(hp.prefix().data() == TermId::from_string("HP:0000118").prefix().data());
+  REQUIRE(hp.has_prefix("HP"));
+  REQUIRE_FALSE(hp.has_prefix("HPO"));
+  std::stringstream sstr;
+  sstr << hp << " " << umls;
+  REQUIRE("HP:0001166 UMLS:C4024355" == sstr.str());
+}
+
+TEST_CASE("TermId order does not depend on the interning order","[termid_order]")
+{
+  // interned in reverse order: ZZORDER before AAORDER, zeta before alpha
+  TermId zz = TermId::from_string("ZZORDER:0000001");
+  TermId zeta = TermId::from_string("AAORDER:zeta");
+  TermId aa = TermId::from_string("AAORDER:0000002");
+  TermId alpha = TermId::from_string("AAORDER:alpha");
+  REQUIRE(TermId::find_prefix_index("ZZORDER") < TermId::find_prefix_index("AAORDER"));
+  REQUIRE(aa < zz);
+  REQUIRE_FALSE(zz < aa);
+  REQUIRE(alpha < zeta);
+  REQUIRE_FALSE(zeta < alpha);
+  // numeric local ids come before the others
+  REQUIRE(aa < alpha);
+  REQUIRE(zeta < zz);
+  REQUIRE_FALSE(aa < aa);
+  vector<TermId> tids = {zz, zeta, alpha, aa};
+  std::sort(tids.begin(), tids.end());
+  REQUIRE(tids == vector<TermId>({aa, alpha, zeta, zz}));
+  // enough interned local ids to fill several segments of the intern table, in reverse order
+  vector<TermId> many;
+  for (int i = 2999; i >= 0; --i) {
+    many.push_back(TermId::from_string("AAORDER:x" + std::to_string(i)));
+  }
+  REQUIRE("x0" == many.back().get_id());
+  std::sort(many.begin(), many.end());
+  REQUIRE(std::is_sorted(many.begin(), many.end(), [](const TermId &a, const TermId &b) { return a.get_id() < b.get_id(); }));
+}
+
+TEST_CASE("TermId::parse reports malformed ids without throwing","[termid_parse]")
+{
+  TermIdResult r = TermId::parse("HP:0001166");
+  REQUIRE(r);
+  REQUIRE(TermId::from_string("HP:0001166") == r.value);
+  REQUIRE(TermId::from_url("http://purl.obolibrary.org/obo/HP_0001166") == TermId::parse_url("http://purl.obolibrary.org/obo/HP_0001166").value);
+  REQUIRE("HGNC:12345" == TermId::parse_url("http://identifiers.org/hgnc/12345").value.get_value());
+  r = TermId::parse("not a term id");
+  REQUIRE_FALSE(r);
+  REQUIRE(TermIdError::MALFORMED == r.error);
+  REQUIRE(EMPTY_TERMID == r.value);
+  REQUIRE(TermIdError::MALFORMED == TermId::parse_url("HP_0001166").error);
+  REQUIRE_THROWS_AS(TermId::from_string("not a term id"), PhenopacketException);
+  REQUIRE(string::npos != TermId::error_message(TermIdError::MALFORMED, "not a term id").find("not a term id"));
+
+  vector<std::string_view> column = {"HP:0000118", "MONDO_0000001", "malformed", "UMLS:C4024355"};
+  vector<TermId> ids;
+  vector<TermIdError> errors;
+  REQUIRE(3 == TermId::parse_all(column, ids, &errors));
+  REQUIRE(4 == ids.size());
+  REQUIRE("MONDO:0000001" == ids[1].get_value());
+  REQUIRE(EMPTY_TERMID == ids[2]);
+  REQUIRE(TermIdError::MALFORMED == errors[2]);
+  REQUIRE(TermIdError::NONE == errors[3]);
+
+  TermIdError error;
+  Xref xref = Xref::parse("https://en.wikipedia.org/wiki/Arachnodactyly", error);
+  REQUIRE(TermIdError::NONE == error);
+  REQUIRE(xref.is_url());
+  xref = Xref::parse("malformed", error);
+  REQUIRE(TermIdError::MALFORMED == error);
+}
+
+
+TEST_CASE("TermIdMap lookups","[termidmap]")
+{
+  TermIdMap<int> map;
+  REQUIRE(map.find(TermId::from_string("HP:0000001")) == nullptr);
+  // more entries than the initial table has slots, so that it grows
+  for (int i = 0; i < 100; ++i) {
+    REQUIRE(map.insert(TermId::from_string("HP:" + std::to_string(1000000 + i)), i));
+  }
+  REQUIRE(100 == map.size());
+  // an existing entry is not replaced
+  REQUIRE_FALSE(map.insert(TermId::from_string("HP:1000042"), -1));
+  REQUIRE(42 == map.at(TermId::from_string("HP:1000042")));
+  const int *p = map.find(TermId::from_string("HP:1000099"));
+  REQUIRE(p != nullptr);
+  REQUIRE(99 == *p);
+  REQUIRE_FALSE(map.contains(TermId::from_string("MP:1000042")));
+  REQUIRE_THROWS_AS(map.at(TermId::from_string("HP:2000000")), std::out_of_range);
+}
+
+
+TEST_CASE("Xref holds a TermId or a URL in one code","[xref]")
+{
+  REQUIRE(8 == sizeof(Xref));
+  Xref tid_xref{TermId::from_string("UMLS:C4024355")};
+  REQUIRE_FALSE(tid_xref.is_url());
+  REQUIRE(TermId::from_string("UMLS:C4024355") == tid_xref.termid());
+  REQUIRE(tid_xref.url().empty());
+  REQUIRE(tid_xref.has_prefix("UMLS"));
+  REQUIRE(tid_xref.has_prefix_index(TermId::find_prefix_index("UMLS")));
+  Xref url_xref = Xref::from_url("https://en.wikipedia.org/wiki/Arachnodactyly");
+  REQUIRE(url_xref.is_url());
+  REQUIRE("https://en.wikipedia.org/wiki/Arachnodactyly" == url_xref.url());
+  REQUIRE(EMPTY_TERMID == url_xref.termid());
+  REQUIRE_FALSE(url_xref.has_prefix("Empty"));
+  std::stringstream sstr;
+  sstr << tid_xref << " " << url_xref;
+  REQUIRE("UMLS:C4024355 https://en.wikipedia.org/wiki/Arachnodactyly" == sstr.str());
+  REQUIRE(-1 == TermId::find_prefix_index("NOSUCHPREFIX"));
+}
+
+
+TEST_CASE("StringArena interns repeated strings","[stringarena]")
+{
+  StringArena arena;
+  string creator = "https://orcid.org/0000-0001-5208-3432";
+  std::string_view a = arena.intern(creator);
+  std::string_view b = arena.intern(string(creator));
+  REQUIRE(a == creator);
+  // the second copy is not stored
+  REQUIRE(a.data() == b.data());
+  std::string_view c = arena.store(creator);
+  REQUIRE(c == creator);
+  REQUIRE(c.data() != a.data());
+  REQUIRE(arena.intern("").empty());
+  // more strings than the initial table has slots, so that it grows
+  for (int i = 0; i < 2000; ++i) {
+    arena.intern("HPO:probinson" + std::to_string(i % 1000));
+  }
+  StringArena::Stats stats = arena.stats();
+  REQUIRE(1002 == stats.strings);
+  REQUIRE(2003 == stats.requests);
+  REQUIRE(stats.saved_bytes() == creator.size() + (stats.requested_bytes - 3 * creator.size()) / 2);
+  // PredicateValue and Synonym use the global arena
+  PredicateValue pv1{Predicate::CREATED_BY, "HPO:probinson"};
+  PredicateValue pv2{Predicate::CREATED_BY, string("HPO:") + "probinson"};
+  REQUIRE(pv1.value().data() == pv2.value().data());
+}
+
+
+TEST_CASE("Registries of edge types, predicates and properties","[staticregistry]")
+{
+  static constexpr RegistryEntry<int> ENTRIES[] = {{"is_a", 1}, {"RO_0004029", 2}, {"mondo#disease_has_feature", 3}};
+  constexpr auto registry = make_registry(ENTRIES);
+  static_assert(*registry.find("RO_0004029") == 2, "found at compile time");
+  REQUIRE(3 == registry.size());
+  REQUIRE(nullptr == registry.find("RO_0004030"));
+  REQUIRE(nullptr == registry.find(""));
+  REQUIRE("RO_0004029" == strip_iri("http://purl.obolibrary.org/obo/RO_0004029"));
+  REQUIRE("is_a" == strip_iri("is_a"));
+
+  REQUIRE(EdgeType::IS_A == Edge::string_to_edgetype("is_a"));
+  REQUIRE(EdgeType::DISEASE_HAS_FEATURE == Edge::obo_relation_to_edgetype("RO:0004029"));
+  REQUIRE(EdgeType::PREDISPOSES_TOWARDS == Edge::obo_relation_to_edgetype("predisposes_towards"));
+  REQUIRE_THROWS_AS(Edge::obo_relation_to_edgetype("part_of"), PhenopacketException);
+  Edge e = Edge::of("http://purl.obolibrary.org/obo/HP_0001166", "http://purl.obolibrary.org/obo/RO_0002573",
+                    "http://purl.obolibrary.org/obo/HP_0001238");
+  REQUIRE(EdgeType::HAS_MODIFIER == e.get_edge_type());
+  REQUIRE_THROWS_AS(Edge::of("http://purl.obolibrary.org/obo/HP_0001166", "http://purl.obolibrary.org/obo/BFO_0000050",
+                             "http://purl.obolibrary.org/obo/HP_0001238"), JsonParseException);
+
+  REQUIRE(Predicate::CREATED_BY == PredicateValue::string_to_predicate("oboInOwl#created_by"));
+  REQUIRE(Predicate::HOMEPAGE == PredicateValue::string_to_predicate("homepage"));
+  REQUIRE(AllowedPropertyValue::UK_SPELLING == Property::id_to_property("http://purl.obolibrary.org/obo/HP_0045076"));
+  REQUIRE(AllowedPropertyValue::LAYPERSON_TERM == Property::id_to_property("layperson term"));
+  REQUIRE_THROWS_AS(Property::id_to_property("http://purl.obolibrary.org/obo/HP_0000001"), PhenopacketException);
+  REQUIRE("secondary consequence" == Property::property_label(AllowedPropertyValue::CONSEQUENCE_OF_A_DISORDER_IN_ANOTHER_ORGAN_SYSTEM));
+}
+
+
 TEST_CASE("Parse hp.small.json","[parse_hp_small_json]")
 {
   string hp_json_path = "../testdata/hp.small.json";
@@ -438,11 +639,21 @@ TEST_CASE("Parse hp.small.json","[parse_hp_small_json]")
   PredicateValue proval_a = provals.at(0);
   REQUIRE(Predicate::HAS_OBO_NAMESPACE == proval_a.get_property());
   REQUIRE("human_phenotype" == proval_a.get_value());
+  // the reference accessors return the fields of the term itself
+  REQUIRE("Fake term 2" == term.label());
+  REQUIRE(def == term.definition());
+  REQUIRE(3 == term.property_values().size());
+  REQUIRE("human_phenotype" == term.property_values().front().value());
+  REQUIRE(t1 == term.id());
   vector<Xref> xrefs = term.get_term_xref_list();
   REQUIRE(1 == xrefs.size());
   Xref xref1 = xrefs.at(0);
   TermId expectedXreft = TermId::from_string("UMLS:C4024355");
   REQUIRE(expectedXreft == xref1.get_termid());
+  REQUIRE(term.contains_xref_with_prefix("UMLS"));
+  REQUIRE_FALSE(term.contains_xref_with_prefix("HPO"));
+  REQUIRE(ontology->term(t1)->contains_xref_with_prefix("UMLS"));
+  REQUIRE_FALSE(ontology->term(t1)->contains_xref_with_prefix("NOSUCHPREFIX"));
   // Term 4 has a synonym
   TermId t4 = TermId::from_string("HP:0000004");
   std::optional<Term> t4opt = ontology->get_term(t4);
@@ -456,6 +667,279 @@ TEST_CASE("Parse hp.small.json","[parse_hp_small_json]")
 }
 
 
+TEST_CASE("Parse hp.small.json in streaming mode","[parse_hp_small_json_streaming]")
+{
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboOptions options;
+  options.mode = JsonParseMode::STREAMING;
+  JsonOboParser sax_parser {hp_json_path, options};
+  std::unique_ptr<Ontology> ontology = sax_parser.get_ontology();
+  JsonOboParser dom_parser {hp_json_path};
+  std::unique_ptr<Ontology> dom_ontology = dom_parser.get_ontology();
+  REQUIRE(dom_ontology->get_id() == ontology->get_id());
+  REQUIRE(dom_ontology->current_term_count() == ontology->current_term_count());
+  REQUIRE(dom_ontology->edge_count() == ontology->edge_count());
+  REQUIRE(dom_ontology->predicate_count() == ontology->predicate_count());
+  REQUIRE(dom_parser.get_errors().size() == sax_parser.get_errors().size());
+  TermId t2 = TermId::from_string("HP:0000002");
+  std::optional<Term> t2opt = ontology->get_term(t2);
+  REQUIRE(t2opt);
+  REQUIRE("Fake term 2" == t2opt->get_label());
+  REQUIRE("Definition for HP:0000002." == t2opt->get_definition());
+  REQUIRE(1 == t2opt->get_definition_xref_list().size());
+  REQUIRE(1 == t2opt->get_term_xref_list().size());
+  REQUIRE(3 == t2opt->get_property_values().size());
+  REQUIRE(1 == t2opt->get_synonyms().size());
+  TermId t3 = TermId::from_string("HP:0000003");
+  TermId t1 = TermId::from_string("HP:0000001");
+  REQUIRE(ontology->exists_path(t3, t1));
+}
+
+TEST_CASE("Parse hp.small.json with lazy terms","[parse_hp_small_json_lazy]")
+{
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboOptions options;
+  options.mode = JsonParseMode::STREAMING;
+  options.lazy_terms = true;
+  JsonOboParser lazy_parser {hp_json_path, options};
+  std::unique_ptr<Ontology> ontology = lazy_parser.get_ontology();
+  JsonOboParser eager_parser {hp_json_path};
+  std::unique_ptr<Ontology> eager_ontology = eager_parser.get_ontology();
+  REQUIRE(eager_ontology->current_term_count() == ontology->current_term_count());
+  REQUIRE(eager_parser.get_errors().size() == lazy_parser.get_errors().size());
+  for (TermId tid : eager_ontology->get_current_term_ids()) {
+    std::optional<Term> lazy_term = ontology->get_term(tid);
+    std::optional<Term> eager_term = eager_ontology->get_term(tid);
+    REQUIRE(lazy_term);
+    REQUIRE_FALSE(lazy_term->is_materialized());
+    REQUIRE(eager_term->get_label() == lazy_term->get_label());
+    REQUIRE(eager_term->obsolete() == lazy_term->obsolete());
+    REQUIRE(eager_term->get_synonyms().size() == lazy_term->get_synonyms().size());
+    REQUIRE(lazy_term->is_materialized());
+    REQUIRE(eager_term->get_definition() == lazy_term->get_definition());
+    REQUIRE(eager_term->get_definition_xref_list().size() == lazy_term->get_definition_xref_list().size());
+    REQUIRE(eager_term->get_term_xref_list().size() == lazy_term->get_term_xref_list().size());
+    REQUIRE(eager_term->get_property_values().size() == lazy_term->get_property_values().size());
+  }
+}
+
+TEST_CASE("Lazy terms fail if the mapped file changes","[parse_hp_small_json_lazy_changed]")
+{
+  string lazy_path = "hp.small.lazy.json";
+  {
+    std::ifstream in("../testdata/hp.small.json");
+    std::ofstream out(lazy_path);
+    out << in.rdbuf();
+  }
+  JsonOboOptions options;
+  options.mode = JsonParseMode::STREAMING;
+  options.lazy_terms = true;
+  JsonOboParser parser {lazy_path, options};
+  std::unique_ptr<Ontology> ontology = parser.get_ontology();
+  {
+    // overwrite the file in place; the parser dropped the pages it read, so they are read again
+    std::fstream f(lazy_path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekg(0, std::ios::end);
+    string garbage(static_cast<size_t>(f.tellg()), '#');
+    f.seekp(0);
+    f.write(garbage.data(), garbage.size());
+  }
+  std::optional<Term> term = ontology->get_term(TermId::from_string("HP:0000004"));
+  REQUIRE(term);
+  REQUIRE_THROWS_AS(term->get_definition(), PhenopacketException);
+  // the term stays unmaterialized rather than appearing to have no details
+  REQUIRE_FALSE(term->is_materialized());
+  REQUIRE_THROWS_AS(ontology->term(TermId::from_string("HP:0000004"))->definition(), PhenopacketException);
+  std::remove(lazy_path.c_str());
+}
+
+TEST_CASE("Parse hp.small.json with load profiles","[parse_hp_small_json_profiles]")
+{
+  string hp_json_path = "../testdata/hp.small.json";
+  TermId t2 = TermId::from_string("HP:0000002");
+  TermId t3 = TermId::from_string("HP:0000003");
+  TermId t1 = TermId::from_string("HP:0000001");
+  for (JsonParseMode mode : {JsonParseMode::DOM, JsonParseMode::STREAMING}) {
+    JsonOboOptions options;
+    options.mode = mode;
+    options.profile = LoadProfile::GRAPH_ONLY;
+    JsonOboParser graph_parser {hp_json_path, options};
+    std::unique_ptr<Ontology> ontology = graph_parser.get_ontology();
+    REQUIRE(5 == ontology->current_term_count());
+    REQUIRE(ontology->exists_path(t3, t1));
+    std::optional<Term> term = ontology->get_term(t2);
+    REQUIRE(term);
+    REQUIRE(term->get_label().empty());
+    REQUIRE(term->get_definition().empty());
+    REQUIRE(term->get_synonyms().empty());
+    REQUIRE(term->get_property_values().empty());
+
+    options.profile = LoadProfile::GRAPH_LABELS_DATES;
+    JsonOboParser dates_parser {hp_json_path, options};
+    ontology = dates_parser.get_ontology();
+    term = ontology->get_term(t2);
+    REQUIRE("Fake term 2" == term->get_label());
+    REQUIRE(term->get_term_xref_list().empty());
+    REQUIRE(1 == term->get_property_values().size());
+    REQUIRE(CivilDate(2009, 1, 14) == term->get_creation_date());
+  }
+}
+
+TEST_CASE("Parse errors are recorded and capped","[parse_errors]")
+{
+  string path = "malformed.json";
+  {
+    std::ofstream out(path);
+    out << "{\"graphs\":[{\"nodes\":["
+        << "{\"id\":\"http://purl.obolibrary.org/obo/HP_0000001\",\"type\":\"CLASS\",\"lbl\":\"t1\"},"
+        << "{\"id\":\"http://purl.obolibrary.org/obo/HP_0000002\",\"type\":\"INDIVIDUAL\"}],"
+        << "\"edges\":[{\"sub\":\"a\"},{\"obj\":\"b\"},{\"pred\":\"is_a\"}],"
+        << "\"id\":\"http://purl.obolibrary.org/obo/hp.json\",\"meta\":{}}]}";
+  }
+  for (JsonParseMode mode : {JsonParseMode::DOM, JsonParseMode::STREAMING}) {
+    JsonOboOptions options;
+    options.mode = mode;
+    JsonOboParser parser {path, options};
+    const OboParseErrorList &errors = parser.get_error_records();
+    // missing meta, unknown node type, three malformed edges
+    REQUIRE(5 == errors.total());
+    REQUIRE(ParseErrorCause::MISSING_META == errors.records().at(0).cause);
+    REQUIRE(ParseErrorCause::UNKNOWN_NODE_TYPE == errors.records().at(1).cause);
+    REQUIRE(1 == errors.records().at(1).index);
+    REQUIRE(ParseErrorCause::MALFORMED_EDGE == errors.records().at(4).cause);
+    REQUIRE(2 == errors.records().at(4).index);
+    if (mode == JsonParseMode::STREAMING) {
+      REQUIRE(errors.records().at(0).byte_offset == 21);
+    }
+    REQUIRE(5 == parser.get_errors().size());
+
+    options.max_errors = 2;
+    JsonOboParser capped_parser {path, options};
+    REQUIRE(2 == capped_parser.get_error_records().records().size());
+    REQUIRE(3 == capped_parser.get_error_records().dropped());
+    std::stringstream sstr;
+    capped_parser.output_quality_assessment(sstr);
+    REQUIRE(sstr.str().find("3 further errors") != string::npos);
+  }
+  std::remove(path.c_str());
+}
+
+TEST_CASE("Parse hp.small.json without memory mapping","[parse_hp_small_json_ifstream]")
+{
+  string hp_json_path = "../testdata/hp.small.json";
+  for (JsonParseMode mode : {JsonParseMode::DOM, JsonParseMode::STREAMING}) {
+    JsonOboOptions options;
+    options.mode = mode;
+    options.memory_map = false;
+    JsonOboParser parser {hp_json_path, options};
+    std::unique_ptr<Ontology> ontology = parser.get_ontology();
+    REQUIRE(5 == ontology->current_term_count());
+    REQUIRE(4 == ontology->edge_count());
+    std::optional<Term> t4opt = ontology->get_term(TermId::from_string("HP:0000004"));
+    REQUIRE(t4opt);
+    REQUIRE("Fake term 4" == t4opt->get_label());
+  }
+}
+
+TEST_CASE("Parse a truncated JSON ontology","[parse_truncated_json]")
+{
+  std::ifstream in("../testdata/hp.small.json");
+  string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  string truncated_path = "hp.truncated.json";
+  {
+    std::ofstream out(truncated_path);
+    out << json.substr(0, json.size() / 2);
+  }
+  for (JsonParseMode mode : {JsonParseMode::DOM, JsonParseMode::STREAMING}) {
+    for (bool memory_map : {true, false}) {
+      JsonOboOptions options;
+      options.mode = mode;
+      options.memory_map = memory_map;
+      REQUIRE_THROWS_AS(JsonOboParser(truncated_path, options), JsonParseException);
+    }
+  }
+  std::remove(truncated_path.c_str());
+}
+
+TEST_CASE("Parse hp.small.json with several threads","[parse_hp_small_json_threads]")
+{
+  string hp_json_path = "../testdata/hp.small.json";
+  JsonOboParser serial_parser {hp_json_path};
+  std::unique_ptr<Ontology> serial = serial_parser.get_ontology();
+  JsonOboOptions options;
+  options.threads = 3;
+  JsonOboParser parallel_parser {hp_json_path, options};
+  std::unique_ptr<Ontology> ontology = parallel_parser.get_ontology();
+  REQUIRE(serial->get_current_term_ids() == ontology->get_current_term_ids());
+  REQUIRE(serial->edge_count() == ontology->edge_count());
+  REQUIRE(serial_parser.get_errors() == parallel_parser.get_errors());
+  std::optional<Term> t2opt = ontology->get_term(TermId::from_string("HP:0000002"));
+  REQUIRE(t2opt);
+  REQUIRE("Fake term 2" == t2opt->get_label());
+  REQUIRE(1 == t2opt->get_synonyms().size());
+}
+
+TEST_CASE("Parse gzip-compressed hp.small.json","[parse_hp_small_json_gz]")
+{
+  string hp_json_gz_path = "../testdata/hp.small.json.gz";
+  REQUIRE(Compression::GZIP == detect_compression(hp_json_gz_path));
+  REQUIRE(Compression::NONE == detect_compression("../testdata/hp.small.json"));
+  for (JsonParseMode mode : {JsonParseMode::DOM, JsonParseMode::STREAMING}) {
+    JsonOboOptions options;
+    options.mode = mode;
+    JsonOboParser parser {hp_json_gz_path, options};
+    std::unique_ptr<Ontology> ontology = parser.get_ontology();
+    REQUIRE(5 == ontology->current_term_count());
+    REQUIRE(4 == ontology->edge_count());
+    REQUIRE("http://purl.obolibrary.org/obo/hp/releases/2019-09-06" == ontology->get_version());
+    std::optional<Term> t5opt = ontology->get_term(TermId::from_string("HP:0000005"));
+    REQUIRE(t5opt);
+    REQUIRE("Fake term 5" == t5opt->get_label());
+  }
+}
+
+TEST_CASE("Parse hp.small.obo","[parse_hp_small_obo]")
+{
+  string hp_obo_path = "../testdata/hp.small.obo";
+  REQUIRE(OboParser::is_obo_file(hp_obo_path));
+  REQUIRE_FALSE(OboParser::is_obo_file("../testdata/hp.small.json"));
+  OboParser obo_parser {hp_obo_path};
+  REQUIRE(obo_parser.get_errors().empty());
+  std::unique_ptr<Ontology> ontology = obo_parser.get_ontology();
+  JsonOboParser json_parser {"../testdata/hp.small.json"};
+  std::unique_ptr<Ontology> json_ontology = json_parser.get_ontology();
+  REQUIRE("http://purl.obolibrary.org/obo/hp.obo" == ontology->get_id());
+  REQUIRE(json_ontology->get_version() == ontology->get_version());
+  REQUIRE(json_ontology->current_term_count() == ontology->current_term_count());
+  REQUIRE(json_ontology->edge_count() == ontology->edge_count());
+  for (TermId tid : json_ontology->get_current_term_ids()) {
+    std::optional<Term> obo_term = ontology->get_term(tid);
+    std::optional<Term> json_term = json_ontology->get_term(tid);
+    REQUIRE(obo_term);
+    REQUIRE(json_term->get_label() == obo_term->get_label());
+    REQUIRE(json_term->get_definition() == obo_term->get_definition());
+    REQUIRE(json_term->get_definition_xref_list().size() == obo_term->get_definition_xref_list().size());
+    REQUIRE(json_term->get_term_xref_list().size() == obo_term->get_term_xref_list().size());
+    REQUIRE(json_term->get_synonyms().size() == obo_term->get_synonyms().size());
+    REQUIRE(json_ontology->get_isa_parents(tid) == ontology->get_isa_parents(tid));
+  }
+  std::optional<Term> t4opt = ontology->get_term(TermId::from_string("HP:0000004"));
+  REQUIRE(t4opt->get_synonyms().at(0).is_exact());
+  REQUIRE("Abnormal shape of thyroid gland" == t4opt->get_synonyms().at(0).get_label());
+  REQUIRE(2012 == t4opt->get_creation_date().year());
+
+  OboOptions options;
+  options.profile = LoadProfile::GRAPH_ONLY;
+  OboParser graph_parser {hp_obo_path, options};
+  ontology = graph_parser.get_ontology();
+  REQUIRE(5 == ontology->current_term_count());
+  REQUIRE(ontology->exists_path(TermId::from_string("HP:0000005"), TermId::from_string("HP:0000001")));
+  std::optional<Term> t2opt = ontology->get_term(TermId::from_string("HP:0000002"));
+  REQUIRE(t2opt->get_label().empty());
+  REQUIRE(t2opt->get_definition().empty());
+  REQUIRE(t2opt->get_property_values().empty());
+}
+
 TEST_CASE("Parse Phenopacket with bad term","[has_term_not_in_ontology]") {
   string hp_json_path = "../testdata/hp.small.json";
   JsonOboParser parser {hp_json_path};